@@ -0,0 +1,15 @@
+#ifndef SPICIAL_BENCHMARK_H
+#define SPICIAL_BENCHMARK_H
+
+#include <armadillo>
+
+// (DEBUG) 在同一个矩阵上比较 arma::spsolve 与各线性求解器的耗时和残差
+void benchmarkLinearSolvers(const arma::sp_mat& A,
+                            const arma::vec& b,
+                            int repeat = 20);
+
+// (DEBUG) CPU 支持的各级内核的批量 exp 与 std::exp 比较：
+// [-750, 750] 上的最大相对误差，上溢、下溢、nan 的处理，以及耗时
+void benchmarkDiodeExp(int num = 300001, int repeat = 20);
+
+#endif  // SPICIAL_BENCHMARK_H
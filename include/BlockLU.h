@@ -0,0 +1,95 @@
+#ifndef SPICIAL_BLOCKLU_H
+#define SPICIAL_BLOCKLU_H
+
+#include <armadillo>
+#include <functional>
+#include <vector>
+#include "BlockTriangular.h"
+#include "SparseLU.h"
+
+/**
+ * 基于块上三角 (BTF) 形式的稀疏 LU
+ * 每个对角块单独用 SparseLU 分解（1x1 块直接存对角元），
+ * 块外的非零元只参与回代，不产生填充。
+ * 求解时从最后一块向前回代，依赖层数相同的块互不依赖，
+ * 规模足够大时用多个线程同时分解 / 求解。
+ * 结构可以预先由 setStructure() 给出（Circuit::preProcess 时计算），
+ * 矩阵结构不再满足该划分时自动重新计算。
+ */
+class BlockLU {
+   public:
+    BlockLU();
+    ~BlockLU();
+
+    void setStructure(const BlockTriangular& btf_);
+
+    bool factorize(const arma::sp_mat& A);
+    bool solve(const arma::vec& b, arma::vec& x) const;
+
+    void setOrdering(int method);
+    void setPivotTolerance(double tol);
+    void setThreadNum(int num);
+    void setParallelMinSize(int size);  // 一层的总行数小于该值时不开线程
+
+    bool isFactored() const { return factored; }
+    int getSize() const { return n; }
+    int getBlockNum() const { return btf.getBlockNum(); }
+    int getFactorNonzeroNum() const;
+    int getAnalyzeCount() const { return analyze_count; }
+    int getFactorizeCount() const { return factorize_count; }
+    int getFactorCount() const;
+    int getRefactorCount() const;
+    void printStats() const;
+
+   private:
+    bool loadValues(const arma::sp_mat& A);  // 结构不同时返回 false
+    void buildBlocks(const arma::sp_mat& A);
+    void buildLevels();
+    bool factorBlock(int blk);
+    bool solveBlock(int blk) const;
+    void runBlocks(const std::vector<int>& blocks,
+                   const std::function<void(int)>& func) const;
+
+    BlockTriangular btf;
+    bool factored;
+    int n;
+
+    // A 的 CSC 结构，用于判断结构是否变化
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+
+    // A 的第 k 个非零元写到哪里：块内为 (块, slot)，块外为 (-1, off slot)
+    std::vector<int> dest_block;
+    std::vector<int> dest_slot;
+
+    // 对角块
+    std::vector<arma::sp_mat> block_mat;
+    std::vector<double*> block_values;  // 指向 block_mat 的数值数组
+    std::vector<SparseLU> block_lu;
+    std::vector<double> block_diag;  // 1x1 块的对角元
+
+    // 块外的非零元，按排列后的行存储 (CSR)，列号为排列后的列
+    std::vector<int> off_ptr;
+    std::vector<int> off_col;
+    std::vector<double> off_val;
+
+    // levels[l] 中的块只依赖 levels[0..l-1] 中的块
+    std::vector<std::vector<int>> levels;
+
+    // 工作区（排列后的右端项和解）
+    mutable std::vector<double> work_b;
+    mutable std::vector<double> work_x;
+    mutable std::vector<arma::vec> block_b;
+    mutable std::vector<arma::vec> block_x;
+    mutable std::vector<char> block_status;
+
+    int ordering;
+    double pivot_tol;
+    int thread_num;
+    int parallel_min_size;
+
+    int analyze_count;
+    int factorize_count;
+};
+
+#endif  // SPICIAL_BLOCKLU_H
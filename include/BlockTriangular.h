@@ -0,0 +1,75 @@
+#ifndef SPICIAL_BLOCKTRIANGULAR_H
+#define SPICIAL_BLOCKTRIANGULAR_H
+
+#include <armadillo>
+#include <vector>
+
+/**
+ * 块上三角 (BTF) 分解的结构
+ * 先求最大横截 (maximum transversal) 使对角元结构非零，
+ * 再对方程之间的依赖图求强连通分量 (Tarjan)，得到排列后的矩阵
+ *   C = A(p, q)
+ * 为块上三角形式，每个对角块对应一个强连通分量。
+ * 弱耦合的子电路（例如只通过受控源相连的几级电路）会被分成不同的块，
+ * 各块可以单独分解，互不依赖的块可以同时求解。
+ * 只与稀疏结构有关，数值分解见 BlockLU。
+ */
+class BlockTriangular {
+   public:
+    BlockTriangular();
+    ~BlockTriangular();
+
+    bool analyze(const arma::sp_mat& A);
+    bool analyze(int n, const std::vector<int>& Ap, const std::vector<int>& Ai);
+
+    // A 的结构是否仍满足这一块上三角划分（不会出现在对角块下方）
+    bool fits(const arma::sp_mat& A) const;
+
+    // 只求最大横截（CSC 结构），row_match[i] 为与第 i 行匹配的列，
+    // 没有匹配时为 -1；返回结构秩。之后需要重新 analyze 才有块划分
+    int transversal(int n_,
+                    const std::vector<int>& Ap,
+                    const std::vector<int>& Ai,
+                    std::vector<int>& row_match);
+
+    bool isAnalyzed() const { return analyzed; }
+    int getSize() const { return n; }
+    int getBlockNum() const { return static_cast<int>(r.size()) - 1; }
+    int getBlockStart(int k) const { return r[k]; }
+    int getBlockSize(int k) const { return r[k + 1] - r[k]; }
+    int getMaxBlockSize() const;
+    int getStructuralRank() const { return structural_rank; }
+
+    // 排列后第 k 行是 A 的第 p[k] 行，第 k 列是 A 的第 q[k] 列
+    const std::vector<int>& getRowPerm() const { return p; }
+    const std::vector<int>& getColPerm() const { return q; }
+    // A 的第 i 行 / 第 j 列排列后所在的位置
+    const std::vector<int>& getRowPos() const { return pinv; }
+    const std::vector<int>& getColPos() const { return qinv; }
+    // 排列后第 k 行（列）所在的块
+    int getBlockOf(int k) const { return block_of[k]; }
+
+    void printBlocks() const;  // (DEBUG)
+
+   private:
+    int maxTransversal(const std::vector<int>& Ap,
+                       const std::vector<int>& Ai,
+                       std::vector<int>& row_match);
+    void stronglyConnected(const std::vector<int>& Ap,
+                           const std::vector<int>& Ai,
+                           const std::vector<int>& row_match);
+    void setSingleBlock();
+
+    bool analyzed;
+    int n;
+    int structural_rank;
+
+    std::vector<int> p;
+    std::vector<int> q;
+    std::vector<int> pinv;
+    std::vector<int> qinv;
+    std::vector<int> r;  // 第 k 块为 [r[k], r[k+1])
+    std::vector<int> block_of;
+};
+
+#endif  // SPICIAL_BLOCKTRIANGULAR_H
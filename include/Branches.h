@@ -2,6 +2,7 @@
 #define SPICIAL_BRANCHES_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Branches {
@@ -16,6 +17,7 @@ class Branches {
 
    private:
     std::vector<std::string> branches;
+    std::unordered_map<std::string, int> index;  // 名字到索引
 };
 
 #endif  // SPICIAL_BRANCHES_H
@@ -28,10 +28,20 @@ class Circuit {
     void printNodes();
     void printBranches();
 
+    void generateDeviceTables();  // 按器件类型连续存放的节点、参数数组
+
     void generateMNATemplate();
 
+    void generateBlockTriangular();  // Newton 矩阵的 BTF 结构
+
+    void generateNestedDissection();  // 大规模网格电路的区域划分
+
+    void printBlockTriangular();  // (DEBUG) print BTF blocks
+
     void printMNATemplate();  // (DEBUG) print MNA and RHS templates
 
+    void benchmarkSolvers() const;  // (DEBUG) linear solvers on MNA, exp
+
     Component* getComponentPtr(const std::string& name);
 
     void printComponentSize() const;
@@ -48,6 +58,9 @@ class Circuit {
     std::vector<ColumnData> createOutputYData(  // 重载复数版本
         const std::vector<Variable>& var_list,
         const std::vector<arma::cx_vec>& sim_cresults);
+    // AC 传递函数，每个 (输出, 源) 一列幅度 HM 和一列相位 HP
+    std::vector<ColumnData> createTransferYData(
+        const ACSimulation& ac_simulation);
     void outputResults();
     void printOutputData(ColumnData& xdata,
                          std::vector<ColumnData>& ydata,
@@ -58,6 +71,8 @@ class Circuit {
                         const std::string& title) const;
 
    private:
+    void addNewtonPattern(StampMap& pattern) const;  // MNA 加上二极管的位置
+
     Netlist& netlist;
 
     // nodes 和 branches 不会混淆，nodes 名为小写字母，branches 名为大写字母
@@ -68,6 +83,13 @@ class Circuit {
     arma::sp_mat* MNA_T;
     arma::vec* RHS_T;
 
+    // MNA 加上非线性器件位置后的块上三角结构
+    BlockTriangular* BTF_T;
+    // 同一结构上的嵌套剖分，规模不够大时不划分
+    NestedDissection* ND_T;
+    // 按器件类型连续存放的器件表
+    DeviceTables* DEV_T;
+
     // Simulation lists
     std::list<DCSimulation*> dc_simulations;
     std::list<ACSimulation*> ac_simulations;
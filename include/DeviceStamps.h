@@ -0,0 +1,432 @@
+#ifndef SPICIAL_DEVICESTAMPS_H
+#define SPICIAL_DEVICESTAMPS_H
+
+#include <armadillo>
+#include <complex>
+#include <vector>
+#include "DeviceTables.h"
+#include "StampMap.h"
+
+/**
+ * 按器件类型在编译期生成的装配循环 (CRTP)
+ * 每种器件在 XxxStamp 中声明第 k 个器件对各类分析的贡献：
+ *   linear        MNA 模板（直流线性部分）和 RHS 中的直流源
+ *   susceptance   AC 中与频率成正比的部分 B，Y(f) = G + j f B
+ *   acSource      AC 激励（在 RHS 模板上累加）
+ *   tranTemplate  瞬态模板在 MNA 模板之外的结构（含 tranStep 的位置）
+ *   tranStep      后向 Euler 伴随模型，依赖步长和上一时刻的解
+ * DeviceStamp 基类把它们展开成对整张器件表的循环，写入目标 (sink)
+ * 作为模板参数，每种器件、每种 sink 各自实例化并内联，
+ * 没有虚函数、没有 dynamic_cast。没有声明的贡献为空循环。
+ * 所有贡献都是累加；行或列为负（地节点）时由 sink 丢弃。
+ */
+
+// 常用的贡献形式
+template <typename Sink>
+inline void stampConductance(Sink& sink, int a, int b, double g) {
+    sink.add(a, a, g);
+    sink.add(b, b, g);
+    sink.add(a, b, -g);
+    sink.add(b, a, -g);
+}
+
+// 电流从 (ncplus, ncminus) 的电压控制，流过 nplus -> nminus
+template <typename Sink>
+inline void stampTransconductance(Sink& sink,
+                                  int nplus,
+                                  int nminus,
+                                  int ncplus,
+                                  int ncminus,
+                                  double g) {
+    sink.add(nplus, ncplus, g);
+    sink.add(nplus, ncminus, -g);
+    sink.add(nminus, ncplus, -g);
+    sink.add(nminus, ncminus, g);
+}
+
+// 支路电流流入 nplus、流出 nminus，支路方程含 v(nplus) - v(nminus)
+template <typename Sink>
+inline void stampIncidence(Sink& sink, int nplus, int nminus, int branch) {
+    sink.add(nplus, branch, 1.0);
+    sink.add(nminus, branch, -1.0);
+    sink.add(branch, nplus, 1.0);
+    sink.add(branch, nminus, -1.0);
+}
+
+// 从 nplus 经器件流到 nminus 的电流 i
+template <typename Sink, typename T>
+inline void stampCurrent(Sink& sink, int nplus, int nminus, const T& i) {
+    sink.addRHS(nplus, -i);
+    sink.addRHS(nminus, i);
+}
+
+// 只登记结构，数值忽略
+class PatternSink {
+   public:
+    explicit PatternSink(StampMap& map_) : map(map_) {}
+    void add(int row, int col, double) { map.addEntry(row, col); }
+    template <typename T>
+    void addRHS(int, const T&) {}
+
+   private:
+    StampMap& map;
+};
+
+// 累加到已编译的 StampMap 的数值数组，右端项累加到 rhs
+template <typename VecT>
+class StampMapSink {
+   public:
+    StampMapSink(StampMap& map_, VecT& rhs_) : map(map_), rhs(rhs_) {}
+    void add(int row, int col, double value) {
+        map.addValue(map.getSlot(row, col), value);
+    }
+    template <typename T>
+    void addRHS(int row, const T& value) {
+        stampAdd(rhs, row, value);
+    }
+
+   private:
+    StampMap& map;
+    VecT& rhs;
+};
+
+// 按 StampMap 的 slot 累加到另一个数值数组（例如 AC 的 B），不写右端项
+class SlotArraySink {
+   public:
+    SlotArraySink(const StampMap& map_, double* values_)
+        : map(map_), values(values_) {}
+    void add(int row, int col, double value) {
+        int slot = map.getSlot(row, col);
+        if (slot >= 0) {
+            values[slot] += value;
+        }
+    }
+    template <typename T>
+    void addRHS(int, const T&) {}
+
+   private:
+    const StampMap& map;
+    double* values;
+};
+
+// 直接写入矩阵（稀疏或稠密）和右端项
+template <typename MatT, typename VecT>
+class MatrixSink {
+   public:
+    MatrixSink(MatT& mat_, VecT& rhs_) : mat(mat_), rhs(rhs_) {}
+    void add(int row, int col, double value) {
+        stampAdd(mat, row, col, value);
+    }
+    template <typename T>
+    void addRHS(int row, const T& value) {
+        stampAdd(rhs, row, value);
+    }
+
+   private:
+    MatT& mat;
+    VecT& rhs;
+};
+
+// 行列按 index 换成局部编号后写入（例如凝聚后的端口方程），
+// 地节点或局部编号为负时丢弃
+template <typename MatT, typename VecT>
+class IndexedMatrixSink {
+   public:
+    IndexedMatrixSink(const std::vector<int>& index_, MatT& mat_, VecT& rhs_)
+        : index(index_), mat(mat_), rhs(rhs_) {}
+    void add(int row, int col, double value) {
+        if (row >= 0 && col >= 0) {
+            stampAdd(mat, index[row], index[col], value);
+        }
+    }
+    template <typename T>
+    void addRHS(int row, const T& value) {
+        if (row >= 0) {
+            stampAdd(rhs, index[row], value);
+        }
+    }
+
+   private:
+    const std::vector<int>& index;
+    MatT& mat;
+    VecT& rhs;
+};
+
+template <typename Derived, typename Table>
+class DeviceStamp {
+   public:
+    explicit DeviceStamp(const Table& table_) : table(table_) {}
+
+    template <typename Sink>
+    void stampLinear(Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            derived().linear(k, sink);
+        }
+    }
+    template <typename Sink>
+    void stampSusceptance(Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            derived().susceptance(k, sink);
+        }
+    }
+    template <typename Sink>
+    void stampACSource(Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            derived().acSource(k, sink);
+        }
+    }
+    template <typename Sink>
+    void stampTranTemplate(Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            derived().tranTemplate(k, sink);
+        }
+    }
+    template <typename Sink>
+    void stampTranStep(double h, const arma::vec& x_prev, Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            derived().tranStep(k, h, x_prev, sink);
+        }
+    }
+
+    // 默认没有贡献，器件类型按需隐藏
+    template <typename Sink>
+    void linear(int, Sink&) const {}
+    template <typename Sink>
+    void susceptance(int, Sink&) const {}
+    template <typename Sink>
+    void acSource(int, Sink&) const {}
+    template <typename Sink>
+    void tranTemplate(int, Sink&) const {}
+    template <typename Sink>
+    void tranStep(int, double, const arma::vec&, Sink&) const {}
+
+   protected:
+    const Derived& derived() const {
+        return static_cast<const Derived&>(*this);
+    }
+    // 地节点的电压就是 0
+    static double voltage(const arma::vec& x, int node) {
+        return node >= 0 ? x(node) : 0;
+    }
+
+    const Table& table;
+};
+
+class ResistorStamp : public DeviceStamp<ResistorStamp, ResistorTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        stampConductance(sink, table.nplus[k], table.nminus[k],
+                         table.conductance[k]);
+    }
+};
+
+class CapacitorStamp : public DeviceStamp<CapacitorStamp, CapacitorTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    // 直流时支路电流为 0
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        sink.add(table.branch[k], table.branch[k], -1.0);
+    }
+    template <typename Sink>
+    void susceptance(int k, Sink& sink) const {
+        stampConductance(sink, table.nplus[k], table.nminus[k],
+                         2 * M_PI * table.capacitance[k]);
+    }
+    // 支路方程中 C / h 的位置也登记在模板里（数值为 0，由 tranStep 装配）
+    template <typename Sink>
+    void tranTemplate(int k, Sink& sink) const {
+        sink.add(table.nplus[k], table.branch[k], 1.0);
+        sink.add(table.nminus[k], table.branch[k], -1.0);
+        sink.add(table.branch[k], table.nplus[k], 0.0);
+        sink.add(table.branch[k], table.nminus[k], 0.0);
+    }
+    // i = C / h * (v - v_prev)，支路方程为 C / h * v - i = C / h * v_prev
+    template <typename Sink>
+    void tranStep(int k, double h, const arma::vec& x_prev, Sink& sink) const {
+        int id_nplus = table.nplus[k];
+        int id_nminus = table.nminus[k];
+        int id_branch = table.branch[k];
+        double g = table.capacitance[k] / h;
+        sink.add(id_branch, id_nplus, g);
+        sink.add(id_branch, id_nminus, -g);
+        sink.addRHS(id_branch,
+                    g * (voltage(x_prev, id_nplus) -
+                         voltage(x_prev, id_nminus)));
+    }
+};
+
+class InductorStamp : public DeviceStamp<InductorStamp, InductorTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        stampIncidence(sink, table.nplus[k], table.nminus[k], table.branch[k]);
+    }
+    template <typename Sink>
+    void susceptance(int k, Sink& sink) const {
+        sink.add(table.branch[k], table.branch[k],
+                 -2 * M_PI * table.inductance[k]);
+    }
+    template <typename Sink>
+    void tranTemplate(int k, Sink& sink) const {
+        sink.add(table.branch[k], table.branch[k], 0.0);
+    }
+    // v = L / h * (i - i_prev)
+    template <typename Sink>
+    void tranStep(int k, double h, const arma::vec& x_prev, Sink& sink) const {
+        int id_branch = table.branch[k];
+        double r = table.inductance[k] / h;
+        sink.add(id_branch, id_branch, -r);
+        sink.addRHS(id_branch, -r * x_prev(id_branch));
+    }
+};
+
+class VCVSStamp : public DeviceStamp<VCVSStamp, VCVSTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        int id_branch = table.branch[k];
+        stampIncidence(sink, table.nplus[k], table.nminus[k], id_branch);
+        sink.add(id_branch, table.ncplus[k], -table.gain[k]);
+        sink.add(id_branch, table.ncminus[k], table.gain[k]);
+    }
+};
+
+class CCCSStamp : public DeviceStamp<CCCSStamp, CCCSTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        sink.add(table.nplus[k], table.control[k], table.gain[k]);
+        sink.add(table.nminus[k], table.control[k], -table.gain[k]);
+    }
+};
+
+class VCCSStamp : public DeviceStamp<VCCSStamp, VCCSTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        stampTransconductance(sink, table.nplus[k], table.nminus[k],
+                              table.ncplus[k], table.ncminus[k],
+                              table.gain[k]);
+    }
+};
+
+class CCVSStamp : public DeviceStamp<CCVSStamp, CCVSTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        int id_branch = table.branch[k];
+        stampIncidence(sink, table.nplus[k], table.nminus[k], id_branch);
+        sink.add(id_branch, table.control[k], -table.gain[k]);
+    }
+};
+
+class VoltageSourceStamp
+    : public DeviceStamp<VoltageSourceStamp, SourceTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        stampIncidence(sink, table.nplus[k], table.nminus[k], table.branch[k]);
+        sink.addRHS(table.branch[k], table.dc[k]);
+    }
+    template <typename Sink>
+    void acSource(int k, Sink& sink) const {
+        sink.addRHS(table.branch[k],
+                    std::polar(table.ac_magnitude[k], table.ac_phase[k]));
+    }
+};
+
+class CurrentSourceStamp
+    : public DeviceStamp<CurrentSourceStamp, SourceTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        stampCurrent(sink, table.nplus[k], table.nminus[k], table.dc[k]);
+    }
+    template <typename Sink>
+    void acSource(int k, Sink& sink) const {
+        stampCurrent(sink, table.nplus[k], table.nminus[k],
+                     std::polar(table.ac_magnitude[k], table.ac_phase[k]));
+    }
+};
+
+// 二极管的非线性部分在工作点 v 处线性化为电导 g 与电流源 j = i - g v 并联，
+// 电流、电导由 DiodeTable::evaluate 批量求出
+class DiodeStamp : public DeviceStamp<DiodeStamp, DiodeTable> {
+   public:
+    using DeviceStamp::DeviceStamp;
+
+    // 线性部分只有支路电流（由 Newton 迭代的支路方程给出）
+    template <typename Sink>
+    void linear(int k, Sink& sink) const {
+        sink.add(table.branch[k], table.branch[k], -1.0);
+    }
+    // Newton 迭代：结电导、等效电流源，支路方程 i_d = g v + j；
+    // 对 (g, j) 是线性的，可以只装配与已装配值之差
+    template <typename Sink>
+    void newton(int k, double g, double j, Sink& sink) const {
+        int id_nplus = table.nplus[k];
+        int id_nminus = table.nminus[k];
+        int id_branch = table.branch[k];
+        stampConductance(sink, id_nplus, id_nminus, g);
+        stampCurrent(sink, id_nplus, id_nminus, j);
+        sink.add(id_branch, id_nplus, g);
+        sink.add(id_branch, id_nminus, -g);
+        sink.addRHS(id_branch, -j);
+    }
+    // AC 小信号：只有结电导和工作点的等效电流源
+    template <typename Sink>
+    void smallSignal(int k, double g, double j, Sink& sink) const {
+        stampConductance(sink, table.nplus[k], table.nminus[k], g);
+        stampCurrent(sink, table.nplus[k], table.nminus[k], j);
+    }
+
+    template <typename Sink>
+    void stampNewtonPattern(Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            newton(k, 0, 0, sink);
+        }
+    }
+    template <typename Sink>
+    void stampSmallSignal(const double* g, const double* j, Sink& sink) const {
+        for (int k = 0; k < table.size(); k++) {
+            smallSignal(k, g == nullptr ? 0 : g[k], j == nullptr ? 0 : j[k],
+                        sink);
+        }
+    }
+};
+
+// 对每种器件调用一次 f（泛型 lambda），每种器件各自实例化
+template <typename F>
+inline void forEachDeviceStamp(const DeviceTables& dev, F&& f) {
+    f(ResistorStamp(dev.resistors));
+    f(CapacitorStamp(dev.capacitors));
+    f(InductorStamp(dev.inductors));
+    f(VCVSStamp(dev.vcvs));
+    f(CCCSStamp(dev.cccs));
+    f(VCCSStamp(dev.vccs));
+    f(CCVSStamp(dev.ccvs));
+    f(VoltageSourceStamp(dev.voltage_sources));
+    f(CurrentSourceStamp(dev.current_sources));
+    f(DiodeStamp(dev.diodes));
+}
+
+#endif  // SPICIAL_DEVICESTAMPS_H
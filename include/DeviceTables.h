@@ -0,0 +1,186 @@
+#ifndef SPICIAL_DEVICETABLES_H
+#define SPICIAL_DEVICETABLES_H
+
+#include <cmath>
+#include <list>
+#include <string>
+#include <vector>
+#include "Branches.h"
+#include "Component.h"
+#include "structs.h"
+
+/**
+ * 按器件类型连续存放的器件表 (structure of arrays)
+ * preProcess 分配完节点、支路索引后由 components 生成一次，之后 MNA 模板、
+ * Newton 迭代、AC 和瞬态的装配都只遍历这些数组，不再访问 Component 对象
+ * （不需要 dynamic_cast，也不会读到节点名等无关数据）。
+ * 索引与 MNA 的行列号一致：地节点为 -1，支路已加上节点数。
+ * 同一类型内的顺序与 netlist 中的顺序相同。
+ */
+struct ResistorTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<double> conductance;  // 1 / R
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct CapacitorTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> branch;
+    std::vector<double> capacitance;
+    std::vector<double> initial_voltage;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct InductorTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> branch;
+    std::vector<double> inductance;
+    std::vector<double> initial_current;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct VCVSTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> ncplus;
+    std::vector<int> ncminus;
+    std::vector<int> branch;
+    std::vector<double> gain;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct CCCSTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> control;  // 控制电压源的支路
+    std::vector<double> gain;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct VCCSTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> ncplus;
+    std::vector<int> ncminus;
+    std::vector<double> gain;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct CCVSTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> branch;
+    std::vector<int> control;  // 控制电压源的支路
+    std::vector<double> gain;
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct SourceTable {  // 独立电压源 / 电流源
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> branch;  // 电流源为 -1
+    std::vector<double> dc;
+    std::vector<double> ac_magnitude;
+    std::vector<double> ac_phase;  // 弧度
+    std::vector<const Function*> function;  // 没有 function 时为 nullptr
+    std::vector<std::string> name;  // AC 传递函数按源的名字输出
+
+    int size() const { return static_cast<int>(nplus.size()); }
+};
+
+struct DiodeTable {
+    std::vector<int> nplus;
+    std::vector<int> nminus;
+    std::vector<int> branch;
+    std::vector<double> initial_voltage;
+    // 模型参数，每个二极管一份，求值时不再访问 DiodeModel；
+    // 建表时算好常数，求值时没有除法
+    std::vector<double> saturation_current;      // Is
+    std::vector<double> inv_thermal_voltage;     // q / (n * k * T)
+    std::vector<double> saturation_conductance;  // Is * q / (n * k * T)
+    // 结电压限制 (pnjlim) 使用
+    std::vector<double> thermal_voltage;   // Vt = n * k * T / q
+    std::vector<double> critical_voltage;  // Vt * ln(Vt / (sqrt(2) * Is))
+
+    int size() const { return static_cast<int>(nplus.size()); }
+
+    // SPICE 的 pnjlim：结电压超过临界电压且一步增加超过 2 Vt 时，
+    // 按指数的反函数压缩步长，避免 exp 溢出和 Newton 来回振荡。
+    // 返回限制后的结电压，limited 表示是否做了限制
+    double limitVoltage(int k,
+                        double v_new,
+                        double v_old,
+                        bool& limited) const {
+        double vt = thermal_voltage[k];
+        double vcrit = critical_voltage[k];
+        limited = false;
+        if (v_new > vcrit && std::abs(v_new - v_old) > 2 * vt) {
+            limited = true;
+            if (v_old > 0) {
+                double arg = 1 + (v_new - v_old) / vt;
+                return arg > 0 ? v_old + vt * log(arg) : vcrit;
+            }
+            return vt * log(v_new / vt);
+        }
+        return v_new;
+    }
+
+    // 与 DiodeModel::calcCurrentAtVoltage / calcConductanceAtVoltage 相同，
+    // 共用一次 exp
+    void evaluate(int k, double v, double& current, double& conductance) const {
+        double e = exp(v * inv_thermal_voltage[k]);
+        current = saturation_current[k] * (e - 1);
+        conductance = saturation_conductance[k] * e;
+    }
+
+    // 批量求值：v[k] 为第 k 个二极管的结电压，结果写入 current[k] 和
+    // conductance[k]；CPU 支持 AVX2 / AVX-512 时用向量化的 exp（见 simd.h）
+    void evaluate(const double* v, double* current, double* conductance) const;
+    // 只求值 index[0..num) 中的二极管，v / current / conductance 按 index
+    // 的顺序连续存放（器件旁路时只有一部分二极管需要重新求值）
+    void evaluate(int num,
+                  const int* index,
+                  const double* v,
+                  double* current,
+                  double* conductance) const;
+    // 用指定内核 (SIMD_KERNEL_*) 求 y[k] = exp(x[k])，超过 CPU 支持的
+    // 一级时降低到支持的一级；与 std::exp 比较用
+    static void batchExp(int kernel, int num, const double* x, double* y);
+    static const char* getKernelName();
+};
+
+class DeviceTables {
+   public:
+    DeviceTables();
+    ~DeviceTables();
+
+    // components 的节点、支路索引必须已经分配（支路已加上节点数）
+    void build(const std::list<Component*>& components,
+               const Branches& branches,
+               int node_num);
+
+    void printSize() const;  // (DEBUG)
+
+    ResistorTable resistors;
+    CapacitorTable capacitors;
+    InductorTable inductors;
+    VCVSTable vcvs;
+    CCCSTable cccs;
+    VCCSTable vccs;
+    CCVSTable ccvs;
+    SourceTable voltage_sources;
+    SourceTable current_sources;
+    DiodeTable diodes;
+};
+
+#endif  // SPICIAL_DEVICETABLES_H
@@ -0,0 +1,121 @@
+#ifndef SPICIAL_DOMAINLU_H
+#define SPICIAL_DOMAINLU_H
+
+#include <armadillo>
+#include <functional>
+#include <vector>
+#include "BlockLU.h"
+#include "NestedDissection.h"
+#include "SparseLU.h"
+
+/**
+ * 基于嵌套剖分 (NestedDissection) 的区域分解 LU
+ * 各子区域的 A_dd 由多个线程同时分解，并对与之相邻的分隔集变量
+ * （边界）求出 Schur 补的贡献 A_Sd A_dd^{-1} A_dS（每个边界变量一次回代），
+ * 汇总后的 S = A_SS - sum_d A_Sd A_dd^{-1} A_dS 最后用稀疏 LU 分解。
+ * 求解时：
+ *   y_d = A_dd^{-1} b_d                      各子区域并行
+ *   S x_S = b_S - sum_d A_Sd y_d
+ *   x_d = A_dd^{-1} (b_d - A_dS x_S)          各子区域并行
+ * 适合电阻网格、电源网络这类接近二维网格的大规模电路。
+ * 划分可以预先由 setStructure() 给出（Circuit::preProcess 时计算），
+ * 矩阵结构不再满足该划分时自动重新计算；无法划分或子区域分解失败时
+ * 整体使用 BlockLU。
+ */
+class DomainLU {
+   public:
+    DomainLU();
+    ~DomainLU();
+
+    void setStructure(const NestedDissection& nd_);
+
+    bool factorize(const arma::sp_mat& A);
+    bool solve(const arma::vec& b, arma::vec& x) const;
+
+    void setThreadNum(int num);
+    void setDomainNum(int num);  // 重新划分时的子区域数，默认为线程数
+
+    bool isFactored() const { return factored; }
+    bool isDecomposed() const { return !use_whole; }
+    int getSize() const { return n; }
+    int getDomainNum() const;
+    int getSeparatorSize() const;
+    int getFactorNonzeroNum() const;
+    int getAnalyzeCount() const { return analyze_count; }
+    int getFallbackCount() const { return fallback_count; }
+    void printStats() const;
+
+   private:
+    // 一个子区域：A_dd 及其与分隔集的耦合，边界为相邻的分隔集变量
+    struct Domain {
+        arma::sp_mat mat;  // A_dd，固定结构
+        double* values;    // 指向 mat 的数值数组
+        SparseLU lu;
+        std::vector<int> boundary;  // 边界变量在分隔集中的编号
+        // A_dS 按边界列存储 (CSC)，行为子区域内编号
+        std::vector<int> ds_ptr;
+        std::vector<int> ds_row;
+        std::vector<double> ds_val;
+        // A_Sd 按子区域列存储 (CSC)，行为边界编号
+        std::vector<int> sd_ptr;
+        std::vector<int> sd_row;
+        std::vector<double> sd_val;
+        // Schur 补的贡献 (稠密，边界 x 边界) 及其在 S 中的 slot
+        std::vector<double> schur;
+        std::vector<int> schur_slot;
+        // 工作区
+        mutable arma::vec work_b;
+        mutable arma::vec work_x;
+        mutable std::vector<double> work_s;  // 边界上的 A_Sd y_d
+        mutable bool status;
+    };
+
+    void loadPattern(const arma::sp_mat& A);
+    bool loadValues(const arma::sp_mat& A);  // 结构不同时返回 false
+    void buildDomains(const arma::sp_mat& A);
+    bool factorDomain(int d);
+    bool solveInterior(int d) const;
+    bool solveDomain(int d) const;
+    void runDomains(const std::function<void(int)>& func) const;
+
+    NestedDissection nd;
+    bool factored;
+    bool use_whole;  // 整体用 BlockLU
+    int n;
+
+    // A 的 CSC 结构，用于判断结构是否变化
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+
+    // A 的第 k 个非零元写到哪里：种类、所在子区域（A_SS 为 -1）、
+    // 在对应数值数组中的位置
+    enum { DEST_INTERIOR, DEST_DOMAIN_SEP, DEST_SEP_DOMAIN, DEST_SEP };
+    std::vector<char> dest_kind;
+    std::vector<int> dest_domain;
+    std::vector<int> dest_slot;
+
+    std::vector<Domain> domains;
+
+    // 分隔集上的 Schur 补
+    arma::sp_mat schur_mat;
+    double* schur_values;            // 指向 schur_mat 的数值数组
+    std::vector<double> schur_base;  // A_SS 部分，与 schur_mat 的 slot 对应
+    SparseLU schur_lu;
+
+    BlockLU whole;
+
+    // 工作区（排列后的右端项和解）
+    mutable std::vector<double> work_b;
+    mutable std::vector<double> work_x;
+    mutable arma::vec sep_b;
+    mutable arma::vec sep_x;
+
+    int thread_num;
+    int domain_num;
+
+    int analyze_count;
+    int factorize_count;
+    int fallback_count;
+};
+
+#endif  // SPICIAL_DOMAINLU_H
@@ -0,0 +1,122 @@
+#ifndef SPICIAL_ITERATIVESOLVER_H
+#define SPICIAL_ITERATIVESOLVER_H
+
+#include <armadillo>
+#include <vector>
+#include "solvertype.h"
+
+/**
+ * 预条件 Krylov 子空间迭代法 (GMRES(m) / BiCGSTAB)，用于规模很大、
+ * 直接法内存不足的线性网络（RC 网络、寄生电阻提取等）
+ * - MNA 中电压源、电感的支路行对角元为零，先用最大横截做行排列，
+ *   使对角元结构非零，再做 ILU(0) / ILUT
+ * - 预条件子在矩阵结构不变时跨多次求解复用（Newton 迭代、DC 扫描、
+ *   瞬态步进时矩阵变化很小），迭代次数明显增加时才重新构造
+ * - 回收子空间：保留最近几次求解的修正方向 U，新的求解先在 span(AU)
+ *   上做最小残差投影，再从投影后的初值开始迭代
+ * - 每次 factorize 做行缩放，收敛判据基于缩放后方程的残差
+ * 与 SparseLU 接口一致：factorize() 更新矩阵，solve() 求解，
+ * 不同的是 x 的输入值作为迭代初值。
+ */
+class IterativeSolver {
+   public:
+    IterativeSolver();
+    ~IterativeSolver();
+
+    bool factorize(const arma::sp_mat& A);
+    // recycle 为 false 时（迭代精化的修正方程）不把修正方向记入回收子空间
+    bool solve(const arma::vec& b, arma::vec& x, bool recycle = true);
+
+    void setMethod(int method_);            // LINEAR_SOLVER_GMRES, BICGSTAB
+    void setPreconditioner(int precond_);  // PRECOND_NONE, ILU0, ILUT
+    void setTolerance(double tol_) { tol = tol_; }
+    void setMaxIter(int max_iter_) { max_iter = max_iter_; }
+    void setRestart(int restart_) { restart = restart_; }
+    void setILUT(double drop_tol_, int fill_) {
+        drop_tol = drop_tol_;
+        fill = fill_;
+    }
+    void setRecycleNum(int num) { recycle_num = num; }
+
+    int getSize() const { return n; }
+    int getMethod() const { return method; }
+    int getPreconditionerNonzeroNum() const;
+    int getSolveCount() const { return solve_count; }
+    int getIterationCount() const { return iteration_count; }
+    int getLastIterationNum() const { return last_iterations; }
+    int getPreconditionerCount() const { return precond_count; }
+    void printStats() const;
+
+   private:
+    bool loadValues(const arma::sp_mat& A);  // 结构不同时返回 false
+    void loadPattern(const arma::sp_mat& A);
+    bool scaleRows();
+    bool buildPreconditioner();
+    void buildILU0();
+    void buildILUT();
+    double guardPivot(double pivot, double row_norm) const;
+
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const;
+    void precondition(const std::vector<double>& r,
+                      std::vector<double>& z) const;
+    void residual(const std::vector<double>& x, std::vector<double>& r) const;
+    double stopResidual(const std::vector<double>& x) const;
+    void projectRecycled(std::vector<double>& x, std::vector<double>& r);
+    void updateRecycled(const std::vector<double>& dx);
+
+    bool runGMRES(std::vector<double>& x);
+    bool runBiCGSTAB(std::vector<double>& x);
+
+    int n;
+    int method;
+    int precond;
+
+    // A 的 CSC 结构，用于判断结构是否变化
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+
+    // 行排列后的 PA，CSR 存储；csc_to_csr[k] 为 A 的第 k 个非零元的位置
+    std::vector<int> row_perm;  // PA 的第 i 行是 A 的第 row_perm[i] 行
+    std::vector<int> Rp;
+    std::vector<int> Rj;
+    std::vector<double> Rx;
+    std::vector<int> csc_to_csr;
+    std::vector<int> diag_pos;
+    std::vector<double> row_scale;  // 行缩放 D，实际求解 D P A x = D P b
+
+    // 预条件子 M = L U，L 为单位下三角，U 的对角元单独存储，均为 CSR
+    std::vector<int> Lp;
+    std::vector<int> Lj;
+    std::vector<double> Lx;
+    std::vector<int> Up;
+    std::vector<int> Uj;
+    std::vector<double> Ux;
+    std::vector<double> Ud;
+    bool precond_valid;
+    int precond_iterations;  // 新的预条件子第一次求解的迭代次数
+
+    // 回收子空间，A * recycle_u[k] = recycle_c[k]，recycle_c 正交归一
+    std::vector<std::vector<double>> recycle_u;
+    std::vector<std::vector<double>> recycle_c;
+    bool recycle_dirty;  // 矩阵变化后需要重新计算 recycle_c
+    int recycle_num;
+
+    // 工作区
+    std::vector<double> work_b;
+    std::vector<double> work_r;
+    std::vector<double> work_z;
+
+    double tol;       // ||b - Ax|| <= tol * (||b|| + ||x||)
+    int max_iter;
+    int restart;      // GMRES 重启长度
+    double drop_tol;  // ILUT 丢弃阈值（相对行范数）
+    int fill;         // ILUT 每行 L, U 各保留的最大非零元数
+
+    int solve_count;
+    int iteration_count;
+    int last_iterations;
+    int precond_count;
+    int fail_count;
+};
+
+#endif  // SPICIAL_ITERATIVESOLVER_H
@@ -0,0 +1,297 @@
+#ifndef SPICIAL_LINEARSOLVER_H
+#define SPICIAL_LINEARSOLVER_H
+
+#include <armadillo>
+#include <complex>
+#include "BlockLU.h"
+#include "BlockTriangular.h"
+#include "DomainLU.h"
+#include "IterativeSolver.h"
+#include "SmallDenseLU.h"
+#include "SparseLU.h"
+#include "solvertype.h"
+
+/**
+ * 线性方程组求解器的统一接口，实数 / 复数各一套
+ * factorize(): 自动选择，结构不变时只做数值分解
+ * refactor():  沿用已有的主元顺序，只做数值分解，不支持时等同 factorize
+ * solve():     单个或多个右端项；迭代法把 x 的输入值作为初值
+ * solveCorrection(): 迭代精化的修正方程 A d = r，默认同 solve；
+ *             迭代法不把修正方向记入回收子空间
+ * solveTransposed(): 用同一个分解解 A^T x = b（不取共轭），
+ *             伴随法计算传递函数时使用，不支持时返回 false
+ * setThreadNum(): 分解和回代内部的线程数上限（默认为硬件线程数），
+ *             多个线程各用一个求解器时调小，没有内部并行的求解器忽略
+ * 具体实现：
+ *   DenseLUSolver          稠密 LU，n <= 64 时用 SmallDenseLU，否则 LAPACK
+ *   SuperLUSolver          arma::spsolve (SuperLU)，每次从头分解
+ *   SparseLUSolver         自带的稀疏 LU，实数时使用 BTF (BlockLU)
+ *   DomainLUSolver         嵌套剖分后各子区域并行分解 (DomainLU)，只有实数
+ *   IterativeLinearSolver  GMRES / BiCGSTAB，只有实数
+ *   MixedPrecisionSolver   单精度稀疏 LU + 双精度迭代精化
+ *   EquilibratedSolver     对以上求解器的包装，行列平衡 + 迭代精化
+ * 由 selectLinearSolver() 按规模、密度和分析类型选择，
+ * netlist 中的 .OPTIONS SOLVER= 可以强制指定。
+ */
+template <typename eT>
+class LinearSolver {
+   public:
+    virtual ~LinearSolver() {}
+
+    virtual const char* getName() const = 0;
+
+    virtual bool factorize(const arma::SpMat<eT>& A) = 0;
+    virtual bool refactor(const arma::SpMat<eT>& A) { return factorize(A); }
+    virtual bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) = 0;
+    virtual bool solve(const arma::Mat<eT>& B, arma::Mat<eT>& X);
+    virtual bool solveCorrection(const arma::Col<eT>& r, arma::Col<eT>& d) {
+        return solve(r, d);
+    }
+    virtual bool solveTransposed(const arma::Col<eT>&, arma::Col<eT>&) {
+        return false;
+    }
+    bool solveTransposed(const arma::Mat<eT>& B, arma::Mat<eT>& X);
+
+    virtual void setThreadNum(int) {}
+
+    virtual void printStats() const {}
+};
+
+typedef LinearSolver<double> RealLinearSolver;
+typedef LinearSolver<std::complex<double>> ComplexLinearSolver;
+
+template <typename eT>
+class DenseLUSolver : public LinearSolver<eT> {
+   public:
+    DenseLUSolver() : factored(false), use_small(false) {}
+
+    const char* getName() const override { return "dense"; }
+
+    bool factorize(const arma::SpMat<eT>& A) override;
+    bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+    bool solve(const arma::Mat<eT>& B, arma::Mat<eT>& X) override;
+    using LinearSolver<eT>::solveTransposed;
+    bool solveTransposed(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+
+    void printStats() const override;
+
+   private:
+    bool factored;
+    bool use_small;
+    SmallDenseLU<eT> small;
+
+    // 规模较大时用 LAPACK，P^T L U = A
+    arma::Mat<eT> L;
+    arma::Mat<eT> U;
+    arma::Mat<eT> P;
+};
+
+template <typename eT>
+class SuperLUSolver : public LinearSolver<eT> {
+   public:
+    const char* getName() const override { return "superlu"; }
+
+    bool factorize(const arma::SpMat<eT>& A) override;
+    bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+    bool solve(const arma::Mat<eT>& B, arma::Mat<eT>& X) override;
+    using LinearSolver<eT>::solveTransposed;
+    bool solveTransposed(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+
+   private:
+    arma::SpMat<eT> matrix;  // spsolve 每次都重新分解，只保存矩阵
+};
+
+class SparseLUSolver : public RealLinearSolver {
+   public:
+    explicit SparseLUSolver(const BlockTriangular* btf = nullptr);
+
+    const char* getName() const override { return "sparselu"; }
+
+    using RealLinearSolver::solve;
+    bool factorize(const arma::sp_mat& A) override;
+    bool solve(const arma::vec& b, arma::vec& x) override;
+
+    void setThreadNum(int num) override { lu.setThreadNum(num); }
+
+    void printStats() const override { lu.printStats(); }
+
+   private:
+    BlockLU lu;
+};
+
+class ComplexSparseLUSolver : public ComplexLinearSolver {
+   public:
+    const char* getName() const override { return "sparselu"; }
+
+    using ComplexLinearSolver::solve;
+    bool factorize(const arma::sp_cx_mat& A) override;
+    bool refactor(const arma::sp_cx_mat& A) override;
+    bool solve(const arma::cx_vec& b, arma::cx_vec& x) override;
+    using ComplexLinearSolver::solveTransposed;
+    bool solveTransposed(const arma::cx_vec& b, arma::cx_vec& x) override;
+
+    void setThreadNum(int num) override { lu.setThreadNum(num); }
+
+    void printStats() const override { lu.printStats(); }
+
+   private:
+    ComplexSparseLU lu;
+};
+
+class DomainLUSolver : public RealLinearSolver {
+   public:
+    explicit DomainLUSolver(const NestedDissection* nd = nullptr);
+
+    const char* getName() const override { return "domain"; }
+
+    using RealLinearSolver::solve;
+    bool factorize(const arma::sp_mat& A) override;
+    bool solve(const arma::vec& b, arma::vec& x) override;
+
+    void setThreadNum(int num) override { lu.setThreadNum(num); }
+
+    void printStats() const override { lu.printStats(); }
+
+   private:
+    DomainLU lu;
+};
+
+class IterativeLinearSolver : public RealLinearSolver {
+   public:
+    IterativeLinearSolver(int method, int precond);
+
+    const char* getName() const override;
+
+    using RealLinearSolver::solve;
+    bool factorize(const arma::sp_mat& A) override;
+    bool solve(const arma::vec& b, arma::vec& x) override;
+    bool solveCorrection(const arma::vec& r, arma::vec& d) override;
+
+    void printStats() const override { solver.printStats(); }
+
+   private:
+    IterativeSolver solver;
+};
+
+/**
+ * 混合精度：单精度稀疏 LU 分解，对双精度残差做迭代精化
+ * L, U 的数值只占一半内存，大规模电路上分解和回代的访存约减半；
+ * 条件数不超过 1e7 左右时，精化几步即可达到双精度的精度。
+ * 单精度分解失败或精化停滞（后向误差不再减半）时，对当前矩阵
+ * 改用双精度分解 (BlockLU)；停滞多次后不再尝试单精度。
+ */
+class MixedPrecisionSolver : public RealLinearSolver {
+   public:
+    explicit MixedPrecisionSolver(const BlockTriangular* btf = nullptr);
+
+    const char* getName() const override { return "sparselu/mixed"; }
+
+    using RealLinearSolver::solve;
+    bool factorize(const arma::sp_mat& A) override;
+    bool solve(const arma::vec& b, arma::vec& x) override;
+
+    void setThreadNum(int num) override {
+        lu_f.setThreadNum(num);
+        lu_double.setThreadNum(num);
+    }
+
+    void printStats() const override;
+
+   private:
+    bool factorizeDouble();
+    bool solveFloat(const arma::vec& b, arma::vec& x);
+
+    arma::sp_mat matrix;          // 双精度的 A，用于计算残差
+    arma::SpMat<float> matrix_f;  // 单精度的 A
+    FloatSparseLU lu_f;
+    SparseLUSolver lu_double;  // 回退用
+    bool use_double;           // 当前矩阵使用双精度分解
+    bool double_only;          // 停滞次数过多，之后都用双精度
+
+    // 工作区
+    arma::Col<float> work_bf;
+    arma::Col<float> work_xf;
+    arma::vec work_r;
+    arma::vec work_d;
+    arma::vec work_x_new;
+    arma::vec work_r_new;
+
+    int solve_count;
+    int refine_count;
+    int stall_count;
+    int fallback_count;
+};
+
+/**
+ * 行列平衡 (Ruiz) 和迭代精化，包装另一个求解器
+ * factorize(): A_s = D_r A D_c，使各行各列的最大元接近 1，
+ *              D_r, D_c 取 2 的幂，缩放本身没有舍入误差
+ * solve():     在 A_s 上求解后做迭代精化，分量后向误差
+ *              max |r_i| / (|A_s| |y| + |b_s|)_i 足够小或不再下降时停止
+ * solveTransposed(): A^T = D_c^{-1} A_s^T D_r^{-1}，在 A_s^T 上同样精化
+ * 二极管的饱和电流 (1e-12) 与电压源行 (1) 同时出现时矩阵尺度相差很大，
+ * 平衡后主元选择更可靠，精化后解的精度也不受尺度影响。
+ */
+template <typename eT>
+class EquilibratedSolver : public LinearSolver<eT> {
+   public:
+    explicit EquilibratedSolver(LinearSolver<eT>* inner_);  // 接管 inner_
+    ~EquilibratedSolver() override;
+
+    const char* getName() const override { return inner->getName(); }
+
+    using LinearSolver<eT>::solve;
+    bool factorize(const arma::SpMat<eT>& A) override;
+    bool refactor(const arma::SpMat<eT>& A) override;
+    bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+    using LinearSolver<eT>::solveTransposed;
+    bool solveTransposed(const arma::Col<eT>& b, arma::Col<eT>& x) override;
+
+    void setThreadNum(int num) override { inner->setThreadNum(num); }
+
+    void printStats() const override;
+
+   private:
+    bool equilibrate(const arma::SpMat<eT>& A);
+    // 在 A_s（或 A_s^T）上由 work_b 求 work_y 并迭代精化
+    bool solveScaled(bool transposed);
+
+    LinearSolver<eT>* inner;
+    arma::SpMat<eT> scaled;  // A_s
+    arma::vec row_scale;     // D_r
+    arma::vec col_scale;     // D_c
+
+    // 工作区
+    arma::Col<eT> work_b;
+    arma::Col<eT> work_y;
+    arma::Col<eT> work_r;
+    arma::Col<eT> work_d;
+    arma::Col<eT> work_y_new;
+    arma::Col<eT> work_r_new;
+
+    int equilibrate_passes;  // 最近一次平衡的轮数
+    int solve_count;
+    int refine_count;
+    double max_backward_error;
+};
+
+// 选择求解器：requested 不是 LINEAR_SOLVER_AUTO 时直接使用（复数时
+// 迭代法换成稀疏 LU），否则按规模、密度和分析类型选择
+int selectLinearSolver(int requested,
+                       int size,
+                       int nonzero_num,
+                       int analysis_type,
+                       bool complex = false);
+
+// 创建求解器（带行列平衡和迭代精化），返回的对象由调用者释放
+// mixed_precision 只对稀疏 LU 有效，nd 只对区域分解有效
+RealLinearSolver* createLinearSolver(int type,
+                                     int precond = PRECOND_ILU0,
+                                     const BlockTriangular* btf = nullptr,
+                                     bool mixed_precision = false,
+                                     const NestedDissection* nd = nullptr);
+ComplexLinearSolver* createComplexLinearSolver(int type);
+
+const char* getLinearSolverName(int type);
+
+#endif  // SPICIAL_LINEARSOLVER_H
@@ -0,0 +1,72 @@
+#ifndef SPICIAL_LOWRANKLU_H
+#define SPICIAL_LOWRANKLU_H
+
+#include <armadillo>
+#include "BlockLU.h"
+#include "BlockTriangular.h"
+
+// 非线性器件数不超过该值时才使用低秩更新
+#define LOW_RANK_MAX_RANK 32
+
+/**
+ * 低秩更新的 LU (Sherman-Morrison-Woodbury)
+ * Newton 迭代中只有二极管的电导变化，矩阵可以写成
+ *   A(g) = A_lin + U diag(g) V^T
+ * 其中 U, V 为 n x k（k 为二极管数），每列只有两三个非零元。
+ * 在某个 g0 处分解一次 B = A(g0)，并预先计算 W = B^{-1} U，
+ * 之后对 A(g) = B + U diag(g - g0) V^T 的求解只需要一次回代
+ * 和一个 k x k 的稠密方程：
+ *   S = I + V^T W D,  S z = V^T y,  x = y - W D z,  y = B^{-1} b
+ * 每次求解都检查分量残差，电导变化太大导致精度不够时在当前 g 处
+ * 重新分解 B（只做数值分解，BTF 和符号分解仍然复用）。
+ */
+class LowRankLU {
+   public:
+    LowRankLU();
+    ~LowRankLU();
+
+    void setStructure(const BlockTriangular& btf);
+    void setUpdate(const arma::sp_mat& U_, const arma::sp_mat& V_);
+    void invalidate() { based = false; }  // A_lin 变化后调用
+    void setThreadNum(int num) { base_lu.setThreadNum(num); }
+
+    // A 为完整的当前矩阵 A(g)，用于重新分解和残差检验
+    bool solve(const arma::sp_mat& A,
+               const arma::vec& g,
+               const arma::vec& b,
+               arma::vec& x);
+
+    int getRank() const { return static_cast<int>(U.n_cols); }
+    int getUpdateCount() const { return update_count; }
+    int getRebaseCount() const { return rebase_count; }
+    void printStats() const;
+
+   private:
+    bool rebase(const arma::sp_mat& A, const arma::vec& g);
+    bool solveUpdated(const arma::vec& b, arma::vec& x);
+    bool checkResidual(const arma::sp_mat& A,
+                       const arma::vec& b,
+                       const arma::vec& x) const;
+
+    BlockLU base_lu;
+    bool based;
+
+    arma::sp_mat U;
+    arma::sp_mat V;
+    arma::vec g_base;  // B = A(g_base)
+    arma::vec delta;   // g - g_base
+    arma::mat W;       // B^{-1} U, n x k
+    arma::mat VtW;     // V^T W, k x k
+
+    // 工作区
+    arma::vec work_u;
+    arma::vec work_w;
+    arma::vec work_y;
+
+    double residual_tol;  // 分量后向误差上限
+
+    int update_count;
+    int rebase_count;
+};
+
+#endif  // SPICIAL_LOWRANKLU_H
@@ -37,6 +37,8 @@ class DiodeModel : public Model {
     double calcCurrentAtVoltage(double voltage) const;
     double calcVoltageAtCurrent(double current) const;
     double calcConductanceAtVoltage(double voltage) const;  // dI/dV
+    double getSaturationCurrent() const { return is; }
+    double getThermalVoltage() const;  // n * k * T / q
 };
 
 #endif  // SPICIAL_MODEL_H
@@ -0,0 +1,79 @@
+#ifndef SPICIAL_NESTEDDISSECTION_H
+#define SPICIAL_NESTEDDISSECTION_H
+
+#include <armadillo>
+#include <vector>
+
+/**
+ * 嵌套剖分 (nested dissection) 的区域划分
+ * 在 A + A^T 的连接图上递归二分：每次从伪外围顶点做 BFS 分层，
+ * 取按规模中位的一层作为顶点分隔集，两侧继续二分，直到 2^k 个子区域。
+ * 排列后的矩阵为
+ *   [A_11           A_1S]
+ *   [     ...       ... ]
+ *   [          A_kk A_kS]
+ *   [A_S1  ...  A_Sk A_SS]
+ * 子区域之间没有非零元，可以同时分解，最后求解分隔集上的 Schur 补。
+ * 电压源、电感等支路变量的对角元为结构零，先求零自由对角的匹配，
+ * 匹配成环的变量（支路及其节点）合并为一个顶点，保证各对角块结构非奇异。
+ * 只与稀疏结构有关，数值分解见 DomainLU。
+ */
+class NestedDissection {
+   public:
+    NestedDissection();
+    ~NestedDissection();
+
+    // domain_num 向下取为 2 的幂，且每个子区域不少于 DOMAIN_MIN_SIZE；
+    // 不足两个子区域、结构奇异或分隔集过大时返回 false
+    bool analyze(const arma::sp_mat& A, int domain_num);
+    bool analyze(int n_,
+                 const std::vector<int>& Ap,
+                 const std::vector<int>& Ai,
+                 int domain_num);
+
+    // A 的非零元是否仍不跨越两个不同的子区域
+    bool fits(const arma::sp_mat& A) const;
+
+    bool isAnalyzed() const { return analyzed; }
+    int getSize() const { return n; }
+    int getDomainNum() const { return static_cast<int>(r.size()) - 2; }
+    int getDomainStart(int d) const { return r[d]; }
+    int getDomainSize(int d) const { return r[d + 1] - r[d]; }
+    int getSeparatorStart() const { return r[getDomainNum()]; }
+    int getSeparatorSize() const { return n - getSeparatorStart(); }
+    int getMaxDomainSize() const;
+
+    // 排列后第 k 个变量是 A 的第 perm[k] 个变量（行列相同的对称排列）
+    const std::vector<int>& getPerm() const { return perm; }
+    const std::vector<int>& getPos() const { return pos; }
+    // A 的第 i 个变量所在的子区域，分隔集为 -1
+    int getDomainOf(int i) const { return domain_of[i]; }
+
+    void printDomains() const;  // (DEBUG)
+
+   private:
+    int matchGroups(const std::vector<int>& Ap,
+                    const std::vector<int>& Ai,
+                    std::vector<int>& group);
+    void bisect(const std::vector<int>& adj_ptr,
+                const std::vector<int>& adj,
+                const std::vector<int>& weight,
+                std::vector<int>& label,
+                const std::vector<int>& vertices,
+                int tag,
+                int depth);
+    void clear();
+
+    bool analyzed;
+    int n;
+    int leaf_base;  // 递归二分的叶子编号从 leaf_base 开始
+    std::vector<int> work_level;  // 二分时的 BFS 层号
+
+    std::vector<int> perm;
+    std::vector<int> pos;
+    std::vector<int> domain_of;
+    // 第 d 个子区域为 perm[r[d]..r[d+1]-1]，分隔集为最后一段
+    std::vector<int> r;
+};
+
+#endif  // SPICIAL_NESTEDDISSECTION_H
@@ -13,6 +13,7 @@
 #include "Component.h"
 #include "Model.h"
 #include "linetype.h"
+#include "solvertype.h"
 #include "structs.h"
 #include "tokentype.h"
 
@@ -136,6 +137,40 @@ class Netlist {
 
     void parseTran(double step, double stop_time, double start_time = 0);
 
+    // 为某一类分析（ANALYSIS_DC / AC / TRAN）选择线性求解器
+    void setLinearSolver(int analysis_type,
+                         int linear_solver,
+                         int preconditioner = PRECOND_ILU0);
+    // .OPTIONS SOLVER=<name> / PRECOND=<name>，名字不认识时返回 false
+    bool parseOptionSolver(const std::string& name);
+    bool parseOptionPrecond(const std::string& name);
+    // .OPTIONS PRECISION=MIXED / DOUBLE
+    bool parseOptionPrecision(const std::string& name);
+    // 稀疏 LU 用单精度分解，双精度残差迭代精化，停滞时回到双精度
+    void setMixedPrecision(int analysis_type, bool enable);
+    // .OPTIONS BYPASS=ON / OFF
+    bool parseOptionBypass(const std::string& name);
+    // Newton 迭代中端电压变化小于容差的器件跳过求值和重新装配
+    void setDeviceBypass(int analysis_type, bool enable);
+    // .OPTIONS CONDENSE=ON / OFF
+    bool parseOptionCondense(const std::string& name);
+    // 线性部分凝聚到非线性器件端口上，Newton 只在端口方程上迭代
+    void setPortCondensation(int analysis_type, bool enable);
+    // .OPTIONS PREDICTOR=NONE / LINEAR / QUADRATIC / TANGENT
+    bool parseOptionPredictor(const std::string& name);
+    // DC 扫描每一点 Newton 初值的预测方式 (SWEEP_PREDICTOR_*)
+    void setSweepPredictor(int predictor);
+    // .OPTIONS THREADS=<n>，n 为负数时返回 false
+    bool parseOptionThreads(int num);
+    // DC / AC 扫描的线程数，0 为自动；DC 扫描只在 n > 1 时分段
+    void setSweepThreads(int num);
+    // .OPTIONS TRANSFER=OFF / AUTO / DIRECT / ADJOINT
+    bool parseOptionTransfer(const std::string& name);
+    // AC 分析时计算各 AC 源到输出的传递函数 (AC_TRANSFER_*)
+    void setACTransfer(int mode);
+    // .OPTIONS STATS：分析结束后输出线性求解器、Newton 等统计（调试用）
+    void setPrintStats(bool enable);
+
     void parsePrint(int analysis_type, const std::vector<Variable>& var_list);
 
     void parsePlot(int analysis_type, const std::vector<Variable>& var_list);
@@ -149,6 +184,17 @@ class Netlist {
     std::list<Analysis*> analyses;     // 分析，包括 OP, AC, DC, TRAN
     std::list<Output*> outputs;        // 输出，包括 PRINT, PLOT
 
+    // .OPTIONS 指定的线性求解器，作为之后各分析的默认值
+    int option_linear_solver;
+    int option_preconditioner;
+    bool option_mixed_precision;
+    bool option_device_bypass;
+    bool option_condense_ports;
+    int option_sweep_predictor;
+    int option_sweep_threads;
+    int option_ac_transfer;
+    bool option_print_stats;
+
     // set only contains names
     std::unordered_set<std::string> resistor_name_set = {};
     std::unordered_set<std::string> capacitor_name_set = {};
@@ -2,6 +2,7 @@
 #define SPICIAL_NODES_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Nodes {
@@ -18,6 +19,8 @@ class Nodes {
 
    private:
     std::vector<std::string> nodes;
+    // 名字到索引，大规模网表上 addNode 不再线性查找
+    std::unordered_map<std::string, int> index;
 };
 
 #endif  // SPICIAL_NODES_H
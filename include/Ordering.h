@@ -0,0 +1,29 @@
+#ifndef SPICIAL_ORDERING_H
+#define SPICIAL_ORDERING_H
+
+#include <vector>
+
+// 稀疏 LU 的列排序方法
+#define ORDERING_NATURAL 0
+#define ORDERING_AMD 1     // 近似最小度，作用于 A + A^T
+#define ORDERING_COLAMD 2  // 列近似最小度，作用于 A^T A
+
+// 输入为 CSC 结构 (Ap, Ai)，返回排列 perm，第 k 个消去的是 perm[k]
+std::vector<int> computeOrdering(int method,
+                                 int n,
+                                 const std::vector<int>& Ap,
+                                 const std::vector<int>& Ai);
+
+std::vector<int> orderAMD(int n,
+                          const std::vector<int>& Ap,
+                          const std::vector<int>& Ai);
+
+std::vector<int> orderCOLAMD(int n,
+                             const std::vector<int>& Ap,
+                             const std::vector<int>& Ai);
+
+// 对称图（邻接表，不含自环）上的近似最小度排序
+std::vector<int> orderApproximateMinimumDegree(
+    std::vector<std::vector<int>>& adj);
+
+#endif  // SPICIAL_ORDERING_H
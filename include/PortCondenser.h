@@ -0,0 +1,77 @@
+#ifndef SPICIAL_PORTCONDENSER_H
+#define SPICIAL_PORTCONDENSER_H
+
+#include <armadillo>
+#include <vector>
+#include "SparseLU.h"
+
+/**
+ * 线性子网络到非线性器件端口的静态凝聚 (Schur 补)
+ * 把未知量分成端口 P（二极管两端节点及支路，再加上使 A_II 结构
+ * 奇异的变量，例如驱动端口节点的电压源支路）和内部 I，
+ *   [A_II A_IP] [x_I]   [b_I]
+ *   [A_PI A_PP] [x_P] = [b_P]
+ * 内部消去后得到端口上的稠密方程
+ *   S x_P = b_P - A_PI y_I,  S = A_PP - A_PI Z
+ * 其中 Z = A_II^{-1} A_IP 只在线性部分变化时计算一次，
+ * y_I = A_II^{-1} b_I 每个工作点（右端项）计算一次。
+ * Newton 迭代只在 S 上进行，收敛后由 x_I = y_I - Z x_P 恢复完整解。
+ * 非线性器件只能出现在端口的行和列上。
+ */
+class PortCondenser {
+   public:
+    PortCondenser();
+    ~PortCondenser();
+
+    // A 为线性部分，ports 为端口变量的编号（可以无序、重复）
+    bool setup(const arma::sp_mat& A, const std::vector<int>& ports_);
+    bool isReady() const { return ready; }
+    void setThreadNum(int num) { interior_lu.setThreadNum(num); }
+
+    // 凝聚右端项，同时保存 y_I 供 recover 使用
+    bool condenseRHS(const arma::vec& b, arma::vec& b_port);
+    // 由端口解恢复完整解
+    void recover(const arma::vec& x_port, arma::vec& x) const;
+
+    int getPortNum() const { return static_cast<int>(ports.size()); }
+    const std::vector<int>& getPorts() const { return ports; }
+    // 变量 i 在端口中的位置，不是端口（或为地节点）时返回 -1
+    // 完整方程的下标 -> 端口下标，内部变量为 -1
+    const std::vector<int>& getPortIndex() const { return port_index; }
+    int getPortIndex(int i) const {
+        return i >= 0 && i < n ? port_index[i] : -1;
+    }
+    const arma::mat& getSchur() const { return schur; }
+
+    int getSetupCount() const { return setup_count; }
+    int getCondenseCount() const { return condense_count; }
+    void printStats() const;
+
+   private:
+    // 把使 A_II 结构奇异的变量加入端口（ports / port_index）
+    void extendPorts(const arma::sp_mat& A);
+
+    bool ready;
+    int n;
+
+    std::vector<int> ports;     // 端口变量在原方程中的编号
+    std::vector<int> interior;  // 内部变量在原方程中的编号
+    std::vector<int> port_index;
+    std::vector<int> interior_index;
+
+    arma::sp_mat A_II;
+    arma::sp_mat A_PI;  // 端口行、内部列
+    SparseLU interior_lu;
+
+    arma::mat Z;      // A_II^{-1} A_IP，n_I x n_P
+    arma::mat schur;  // S，n_P x n_P
+
+    // 当前右端项的 y_I
+    arma::vec y_interior;
+    arma::vec work_b;
+
+    int setup_count;
+    int condense_count;
+};
+
+#endif  // SPICIAL_PORTCONDENSER_H
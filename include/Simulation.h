@@ -3,20 +3,31 @@
 
 #include <armadillo>
 #include <variant>
+#include "BlockLU.h"
+#include "BlockTriangular.h"
+#include "LinearSolver.h"
 #include "Branches.h"
+#include "DeviceTables.h"
+#include "LowRankLU.h"
+#include "NestedDissection.h"
 #include "Netlist.h"
 #include "Nodes.h"
+#include "PortCondenser.h"
+#include "StampMap.h"
 #include "function.h"
 #include "structs.h"
 
 class Simulation {  // 静态工作点的基类
    public:
-    Simulation(Analysis& analysis_,
-               Netlist& netlist_,
-               Nodes& nodes_,
-               Branches& branches_,
+    Simulation(const Analysis& analysis_,
+               const Netlist& netlist_,
+               const Nodes& nodes_,
+               const Branches& branches_,
                const arma::sp_mat* MNA_T_ = nullptr,
-               const arma::vec* RHS_T_ = nullptr);
+               const arma::vec* RHS_T_ = nullptr,
+               const BlockTriangular* BTF_T_ = nullptr,
+               const NestedDissection* ND_T_ = nullptr,
+               const DeviceTables* DEV_T_ = nullptr);
     virtual ~Simulation();
 
     virtual void runSimulation();  // run op simulation
@@ -27,11 +38,29 @@ class Simulation {  // 静态工作点的基类
     }
 
     // 求解一个工作点
-    arma::vec solveOneOP(arma::sp_mat& MNA,
+    arma::vec solveOneOP(const arma::sp_mat& MNA,
                          arma::vec& RHS,
-                         arma::vec& x_prev) const;  // real
+                         arma::vec& x_prev);  // real
 
    protected:
+    // 使用 op_solver 求解，x 的输入值作为迭代法的初值
+    bool solveLinear(const arma::sp_mat& A, const arma::vec& b, arma::vec& x);
+    // 在最近一次求值的二极管线性化（即上一工作点的 Jacobian）上解 J x = b
+    bool solveJacobian(const arma::vec& b, arma::vec& x);
+    long long getNewtonIterCount() const { return newton_iter_count; }
+    // 与 solveOneOP 相同，但不计入工作点数和 Newton 迭代数（分段扫描的
+    // 段首初值、段间交叉检查），返回用掉的 Newton 迭代次数
+    long long solveUncountedOP(const arma::sp_mat& MNA,
+                               arma::vec& RHS,
+                               arma::vec& x);
+    // AC 扫描使用的线程数，analysis.sweep_threads 为 0 时取硬件线程数
+    int getThreadNum() const;
+    // 把另一个 Simulation（多线程扫描的 worker）的 Newton 和旁路统计加进来
+    void mergeSolverStats(const Simulation& other);
+    // 线性求解器（或低秩更新、端口凝聚）的统计，printSolverStats 的一部分
+    void printLinearSolverStats() const;
+    void printSolverStats() const;
+
     const Analysis& analysis;
     const Netlist& netlist;
     const Nodes& nodes;
@@ -40,31 +69,146 @@ class Simulation {  // 静态工作点的基类
     // simulation parameters for non-linear solver
     double rel_tol;  // relative tolerance, default 1e-3
     double abs_tol;  // absolute tolerance, default 5e-5
-    int max_iter;    // maximum iteration number, default 100
+    int max_iter;    // maximum iteration number, default NEWTON_MAX_ITER
 
     // MNA and RHS templates
     static const arma::sp_mat* MNA_T;
     static const arma::vec* RHS_T;
+    // Newton 矩阵（含二极管）的块上三角结构
+    static const BlockTriangular* BTF_T;
+    // 同一结构上的嵌套剖分（区域分解求解器使用）
+    static const NestedDissection* ND_T;
+    // 按器件类型连续存放的器件表，所有装配循环只遍历这些表
+    static const DeviceTables* DEV_T;
 
     double sim_value;  // simulation point value
+
+    // 持久的线性求解器，结构编译时按规模和 analysis.linear_solver 选择；
+    // 同一结构下只做一次排序和符号分解（迭代法复用预条件子）
+    RealLinearSolver* op_solver;
+    int op_solver_type;
+    // 二极管很少时，线性部分只分解一次，Newton 迭代做低秩更新
+    LowRankLU op_lowrank;
+    bool op_low_rank;
+    // 线性部分凝聚到二极管端口上，Newton 只在端口方程上迭代
+    PortCondenser op_condenser;
+    // 以上求解器内部的线程数上限，0 为不限制（硬件线程数）；
+    // 多线程扫描的 worker 各自设置，避免线程数超额
+    int solver_threads;
+
+   private:
+    // 二极管在端口方程中的位置，地节点为 -1
+    struct DiodePorts {
+        int nplus;
+        int nminus;
+        int branch;
+    };
+
+    void buildOPStampMap(const arma::sp_mat& MNA);
+    void setupCondensation();
+    bool solveOneOPCondensed(const arma::vec& x_prev, arma::vec& x);
+    // Newton 迭代（结电压限制 + 自适应阻尼），方程由 rhs_base 和 op_gmin
+    // 决定，x 的输入值为初值；收敛时返回 true
+    bool solveNewton(arma::vec& x, int iter_limit);
+    // 直接 Newton 不收敛时的后备策略，x 的输入值为初值
+    bool solveGminStepping(arma::vec& x);
+    bool solveSourceStepping(arma::vec& x);
+    // 连续法：伪瞬态和 Newton 同伦，同样作为后备策略
+    bool solvePseudoTransient(arma::vec& x);
+    bool solveHomotopy(arma::vec& x);
+    // 原方程在 x 处的残差 A(x) x - b（结电压先做 pnjlim 限制）
+    void computeResidual(const arma::vec& x, arma::vec& r);
+    // 把第 k 个二极管的当前线性化与已装配值之差加到 op_stamps 和 rhs_iter
+    void stampDiodeUpdate(int k);
+    // values 回到线性部分（加上伪瞬态的伪电导），重新装配全部二极管
+    void restampDiodes();
+
+    // solveOneOP 的固定结构矩阵及工作区（不含地节点）
+    StampMap op_stamps;
+    arma::vec rhs_base;
+    arma::vec rhs_iter;
+    arma::vec rhs_source;  // 本工作点完整的 RHS，源步进时 rhs_base 为其缩放
+    double op_gmin;        // 与每个结并联的电导，只在 gmin 步进时不为 0
+    double op_pseudo_g;    // 节点到地的伪电导 1 / dtau，只在伪瞬态时不为 0
+    std::vector<int> pseudo_slots;  // 各节点对角元的 slot
+    // Newton 统计
+    long long newton_point_count;     // 求解的工作点数
+    long long newton_iter_count;      // Newton 迭代总次数（含后备策略）
+    long long gmin_stepping_count;    // 靠 gmin 步进收敛的工作点数
+    long long source_stepping_count;  // 靠源步进收敛的工作点数
+    long long ptran_count;            // 靠伪瞬态收敛的工作点数
+    long long ptran_step_count;       // 伪瞬态的总步数
+    long long homotopy_count;         // 靠同伦收敛的工作点数
+    long long homotopy_step_count;    // 同伦的总步数
+    long long newton_fail_count;      // 最终没有收敛的工作点数
+    // 各二极管最近一次求值时的结电压、电流和电导（器件旁路时沿用）；
+    // 结电压初始为 NaN，保证第一次一定求值
+    arma::vec diode_v;
+    arma::vec diode_i;
+    arma::vec diode_g;
+    // 当前已经装配进 op_stamps / rhs_iter 的电导和等效电流源
+    arma::vec diode_stamped_g;
+    arma::vec diode_stamped_j;
+    // 上次整体装配以来装配过的最大 |g| 和 |j|，用于判断增量的舍入误差
+    arma::vec diode_peak_g;
+    arma::vec diode_peak_j;
+    // 本次迭代需要重新求值的二极管及其结电压、电流和电导
+    std::vector<int> eval_index;
+    std::vector<double> eval_v;
+    std::vector<double> eval_i;
+    std::vector<double> eval_g;
+    long long diode_eval_count;    // 求值次数
+    long long diode_bypass_count;  // 旁路次数
+    std::vector<DiodePorts> diode_ports;
+    int op_base_version;
 };
 
 class DCSimulation : public Simulation {
    public:
-    DCSimulation(Analysis& analysis_,
-                 Netlist& netlist_,
-                 Nodes& nodes_,
-                 Branches& branches_);
+    DCSimulation(const Analysis& analysis_,
+                 const Netlist& netlist_,
+                 const Nodes& nodes_,
+                 const Branches& branches_);
+    ~DCSimulation() override;
 
     void runSimulation() override;
 
     const std::vector<arma::vec>& getIterResults();
+    // 每个扫描点的 Newton 迭代次数
+    const std::vector<int>& getPointIterations() const {
+        return point_iterations;
+    }
 
    private:
+    // 从 x 开始顺序扫描 analysis.sim_values 的 [first, last)，
+    // 结果追加到 sim_results
+    void sweepRange(int first, int last, arma::vec& x);
+    // 分成 segment_num 段多线程扫描，并检查段间的多值解
+    void sweepSegments(const arma::vec& x_init);
+    void appendResults(const DCSimulation& other, size_t first);
+    bool isSameSolution(const arma::vec& a, const arma::vec& b) const;
+    // 按 analysis.sweep_predictor 预测扫描值 value 处的解，作为 Newton 初值；
+    // x_last 为没有历史时的初值
+    arma::vec predictSweepPoint(double value, const arma::vec& x_last);
+    // 求解扫描值 value 处的工作点并记录迭代次数，x 输入为上一点的解
+    void solveSweepPoint(double value, arma::vec& x);
+    // 求解 value 处的工作点但不作为扫描结果，迭代次数加到 iterations
+    void solveExtraPoint(double value, arma::vec& x, long long& iterations);
+    void printSweepStats() const;
+
     arma::sp_mat* MNA_DC_T;
     arma::vec* RHS_DC_T;
+    // 扫描点的 RHS = rhs_fixed + value * drhs
+    arma::vec rhs_fixed;
+    arma::vec drhs;
 
     std::vector<arma::vec> sim_results;  // exclude gnd!!!
+    std::vector<int> point_iterations;
+    int sweep_first;  // sim_results[0] 在 analysis.sim_values 中的下标
+    int segment_num;
+    int hysteresis_count;  // 段间出现多值解的次数
+    long long seed_iter_count;   // 各段段首初值的 Newton 迭代次数
+    long long check_iter_count;  // 段间交叉检查的 Newton 迭代次数
 };
 
 class ACSimulation : public Simulation {
@@ -73,22 +217,74 @@ class ACSimulation : public Simulation {
                  Netlist& netlist_,
                  Nodes& nodes_,
                  Branches& branches_);
-
-    // 求解一个 AC 频率点
-    arma::cx_vec solveOneFreq(arma::sp_cx_mat& MNA_AC,
-                              arma::cx_vec& RHS_AC,
-                              arma::vec& x_op,
-                              double freq) const;  // complex
+    ~ACSimulation() override;
 
     void runSimulation() override;
 
     const std::vector<arma::cx_vec>& getIterResults();
 
+    // 传递函数，analysis.ac_transfer 不为 OFF 时与 sim_values 一一对应：
+    // H(o, s) 为第 s 个 AC 源单位激励 (1∠0) 时第 o 个输出的响应
+    bool hasTransfer() const { return !sim_transfer.empty(); }
+    const std::vector<arma::cx_mat>& getTransferResults() const {
+        return sim_transfer;
+    }
+    const std::vector<std::string>& getTransferOutputs() const {
+        return transfer_outputs;
+    }
+    const std::vector<std::string>& getTransferSources() const {
+        return transfer_sources;
+    }
+
    private:
+    // 一个线程的 AC 工作区：固定结构的复数矩阵和它自己的求解器。
+    // 每个工作区只做一次排序和符号分解，之后每个频率只做数值分解
+    struct ACWorkspace {
+        arma::sp_cx_mat matrix;
+        std::complex<double>* values;  // 指向 matrix 的数值数组
+        ComplexLinearSolver* solver;
+    };
+
+    // 在工作点处线性化，生成整个扫描共用的固定结构 Y(f) = G + j f B，
+    // 并选择求解器类型（工作区由 runSimulation 按线程数生成）
+    void buildACStampMap(const arma::vec& x_op);
+    // 按 ac_stamps 的结构和求解器类型生成 thread_num 个工作区
+    void buildWorkspaces(int thread_num);
+    void clearWorkspaces();
+    // 在工作区 ws 中装配并求解频率 freq，失败时返回 false
+    bool solveFreq(ACWorkspace& ws, double freq, arma::cx_vec& x);
+    // 用工作区 ws 求解 analysis.sim_values 的 [first, last)，
+    // 结果写入预先分配好的 sim_cresults[first, last)，求解失败的点为全零
+    void sweepFreqRange(ACWorkspace& ws, int first, int last);
+    // 收集 AC 源（每个源一列单位激励）和 .PRINT AC 的输出变量，
+    // 按源和输出的个数确定直接法或伴随法
+    void buildTransfer();
+    // 沿用 ws 中当前频率的分解求传递函数矩阵
+    bool solveTransfer(ACWorkspace& ws, arma::cx_mat& H);
+    void printTransferStats() const;
+
     arma::sp_cx_mat* MNA_AC_T;
     arma::cx_vec* RHS_AC_T;
 
+    // 固定结构的 AC 矩阵，每个频率只改写数值
+    StampMap ac_stamps;        // 只用于结构和 slot
+    arma::vec ac_conductance;  // G，与频率无关
+    arma::vec ac_susceptance;  // B，乘以频率后为虚部
+    arma::cx_vec ac_rhs;
+    int ac_solver_type;
+    // 各频率互相独立，多线程扫描时每个线程一个工作区
+    std::vector<ACWorkspace> workspaces;
+
     std::vector<arma::cx_vec> sim_cresults;  // exclude gnd!!!
+
+    // 传递函数
+    int transfer_mode;            // AC_TRANSFER_DIRECT 或 ADJOINT
+    arma::cx_mat transfer_rhs;    // 每个 AC 源一列单位激励
+    arma::cx_mat transfer_probe;  // 伴随法的右端项，每个输出一列单位向量
+    std::vector<int> transfer_index;  // 输出在解向量中的下标
+    std::vector<std::string> transfer_outputs;  // V(node) / I(branch)
+    std::vector<std::string> transfer_sources;
+    std::vector<arma::cx_mat> sim_transfer;
 };
 
 class TranSimulation : public Simulation {
@@ -98,7 +294,7 @@ class TranSimulation : public Simulation {
                    Nodes& nodes_,
                    Branches& branches_);
 
-    arma::vec tranBackEuler(double time, double h, arma::vec x_prevtime) const;
+    arma::vec tranBackEuler(double time, double h, arma::vec x_prevtime);
 
     void runSimulation() override;
 
@@ -107,6 +303,8 @@ class TranSimulation : public Simulation {
    private:
     arma::sp_mat* MNA_TRAN_T;
     arma::vec* RHS_TRAN_T;
+    // 瞬态模板的固定结构，每步只重置数值再装配伴随模型
+    StampMap tran_stamps;
 
     double tstart;
     double tstep;
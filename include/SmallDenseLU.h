@@ -0,0 +1,50 @@
+#ifndef SPICIAL_SMALLDENSELU_H
+#define SPICIAL_SMALLDENSELU_H
+
+#include <armadillo>
+#include <complex>
+
+#define SMALL_DENSE_MAX_SIZE 64  // 定长存储的最大阶数
+
+/**
+ * 小规模方程的稠密 LU 分解（列主元），P A = L U
+ * 存储为定长数组，分解和求解过程中不分配内存，适合 n < 64 的 MNA 方程，
+ * 此时稀疏结构和 LAPACK 调用的开销远大于运算本身。
+ * n = 4, 8, 16, 32 使用编译期固定大小的内核，其余规模使用通用内核。
+ * 实数时消元的列更新按运行时检测到的指令集使用 AVX-512 / AVX2
+ * (见 simd.h)，否则为标量实现。
+ */
+template <typename eT>
+class SmallDenseLU {
+   public:
+    SmallDenseLU();
+
+    // 规模超过 SMALL_DENSE_MAX_SIZE 或主元为零时返回 false
+    bool factorize(const arma::SpMat<eT>& A);
+    bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) const;
+    bool solveTransposed(const arma::Col<eT>& b, arma::Col<eT>& x) const;
+
+    bool isFactored() const { return factored; }
+    int getSize() const { return n; }
+    int getFactorCount() const { return factor_count; }
+    // 列更新使用的内核 (SIMD_KERNEL_*)，默认为 CPU 支持的最高一级；
+    // 超过 CPU 支持的一级时降低到支持的一级（基准测试比较各内核用）
+    void setKernel(int kernel_);
+    int getKernel() const { return kernel; }
+    const char* getKernelName() const;
+    void printStats() const;
+
+   private:
+    bool factored;
+    int n;
+    int kernel;
+
+    // 列主序，前导维数为 n；L（单位下三角，不存对角元）和 U 存在一起
+    alignas(64) eT lu[SMALL_DENSE_MAX_SIZE * SMALL_DENSE_MAX_SIZE];
+    int perm[SMALL_DENSE_MAX_SIZE];  // 第 k 行来自 A 的第 perm[k] 行
+
+    int factor_count;
+    mutable int solve_count;
+};
+
+#endif  // SPICIAL_SMALLDENSELU_H
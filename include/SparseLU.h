@@ -0,0 +1,130 @@
+#ifndef SPICIAL_SPARSELU_H
+#define SPICIAL_SPARSELU_H
+
+#include <armadillo>
+#include <complex>
+#include <vector>
+
+/**
+ * 可复用符号分解的稀疏 LU 分解 (left-looking, Gilbert-Peierls)
+ * analyze():  根据稀疏结构计算降低填充的列排序 (AMD / COLAMD)，只与结构有关
+ * factor():   阈值部分主元的数值分解，同时确定主元顺序和 L, U 的结构
+ *             MNA 中电压源、电感、二极管支路行的对角元为结构零，
+ *             因此不能只做对角主元
+ * refactor(): 沿用已有的主元顺序和 L, U 结构，只做数值分解
+ * 对同一结构的矩阵反复求解时（Newton 迭代、DC 扫描、瞬态步进），
+ * 排序和符号分解只需要做一次。
+ * 实数 (SparseLU) 与复数 (ComplexSparseLU，AC 扫描) 共用同一实现，
+ * 复数时主元大小按模比较。单精度 (FloatSparseLU) 用于混合精度求解。
+ * 规模较大时 solve() 按依赖层并行回代：同一层的行互不依赖，
+ * 由多个线程按行（L, U 另存一份按行存储的副本）同时求解。
+ */
+template <typename eT>
+class BasicSparseLU {
+   public:
+    BasicSparseLU();
+    ~BasicSparseLU();
+
+    // 自动选择：结构变化时 analyze + factor，否则 refactor，失败时再 factor
+    bool factorize(const arma::SpMat<eT>& A);
+
+    bool analyze(const arma::SpMat<eT>& A);
+    bool factor(const arma::SpMat<eT>& A);
+    bool refactor(const arma::SpMat<eT>& A);
+
+    bool solve(const arma::Col<eT>& b, arma::Col<eT>& x) const;
+    // A^T x = b（不取共轭），U^T、L^T 直接按列存储的 L, U 做内积，串行
+    bool solveTransposed(const arma::Col<eT>& b, arma::Col<eT>& x) const;
+
+    void setOrdering(int method);  // ORDERING_AMD, ORDERING_COLAMD, ...
+    void setPivotTolerance(double tol);
+    void setThreadNum(int num);
+    // nnz(L+U) 小于该值时回代不开线程；<= 0 时只要线程数大于 1 就并行
+    // （不再按依赖层宽度判断），用于检查并行回代与串行回代一致
+    void setParallelSolveMinSize(int size);
+
+    bool isAnalyzed() const { return analyzed; }
+    bool isFactored() const { return factored; }
+    bool samePattern(const arma::SpMat<eT>& A) const;
+
+    int getSize() const { return n; }
+    int getFactorNonzeroNum() const;
+    int getAnalyzeCount() const { return analyze_count; }
+    int getFactorCount() const { return factor_count; }
+    int getRefactorCount() const { return refactor_count; }
+    bool isParallelSolve() const { return parallel_solve; }
+    int getSolveLevelNum() const;  // L, U 依赖层数之和，未启用并行时为 0
+    void printStats() const;
+
+   private:
+    void loadPattern(const arma::SpMat<eT>& A);
+    bool loadValues(const arma::SpMat<eT>& A);  // 结构不同时返回 false
+    bool factorNumeric();
+    bool refactorNumeric();
+    int reach(int k, int col);  // 求 L\A(:,col) 的非零结构，返回 top
+    void sortUColumns();
+    void buildSolveSchedule();  // factor 后：依赖层和按行存储的 L, U
+    void loadSolveValues();     // refactor 后：只更新按行存储的数值
+    void solveLevels() const;   // 在 work_y 上并行求解 L, U
+
+    bool analyzed;
+    bool factored;
+    int n;
+
+    // A 的 CSC 结构及数值
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+    std::vector<eT> Ax;
+
+    std::vector<int> q;     // 列排序，第 k 步处理 A 的第 q[k] 列
+    std::vector<int> pinv;  // 行 i 是第 pinv[i] 个主元
+    std::vector<int> prow;  // 第 k 个主元所在的行
+    std::vector<int> prow_prev;  // 上一次分解的主元行
+
+    // L: 单位下三角，对角元存在每列第一个位置；U: 对角元存在每列最后一个位置
+    std::vector<int> Lp;
+    std::vector<int> Li;
+    std::vector<eT> Lx;
+    std::vector<int> Up;
+    std::vector<int> Ui;
+    std::vector<eT> Ux;
+
+    // 工作区
+    std::vector<eT> work_x;
+    std::vector<int> work_xi;
+    std::vector<int> work_stack;
+    std::vector<int> work_mark;
+    mutable std::vector<eT> work_y;
+
+    // 并行回代：L, U 不含对角元的按行存储 (CSR)，src 为在 Lx / Ux 中的位置
+    bool parallel_solve;
+    std::vector<int> Lr_ptr;
+    std::vector<int> Lr_col;
+    std::vector<int> Lr_src;
+    std::vector<eT> Lr_val;
+    std::vector<int> Ur_ptr;
+    std::vector<int> Ur_col;
+    std::vector<int> Ur_src;
+    std::vector<eT> Ur_val;
+    // 第 l 层的行为 rows[level_ptr[l]..level_ptr[l+1]-1]
+    std::vector<int> l_level_ptr;
+    std::vector<int> l_level_rows;
+    std::vector<int> u_level_ptr;
+    std::vector<int> u_level_rows;
+    int thread_num;
+    int parallel_min_size;
+
+    int ordering;
+    double pivot_tol;     // 部分主元阈值，1.0 即严格的列主元
+    double refactor_tol;  // refactor 时主元相对本列的最小比例
+
+    int analyze_count;
+    int factor_count;
+    int refactor_count;
+};
+
+typedef BasicSparseLU<double> SparseLU;
+typedef BasicSparseLU<std::complex<double>> ComplexSparseLU;
+typedef BasicSparseLU<float> FloatSparseLU;
+
+#endif  // SPICIAL_SPARSELU_H
@@ -0,0 +1,100 @@
+#ifndef SPICIAL_STAMPMAP_H
+#define SPICIAL_STAMPMAP_H
+
+#include <armadillo>
+#include <vector>
+
+/**
+ * 固定稀疏结构的 MNA 矩阵
+ * 先登记所有可能出现非零元的位置（包括非线性器件的位置），编译成 CSC 结构，
+ * 之后每个 slot 的位置不再改变。迭代时只需重置数值数组，再按 slot
+ * 累加器件贡献，不会触发内存分配，也不会改变矩阵结构。
+ * 索引为负数的行/列（例如地节点）会被直接丢弃。
+ */
+class StampMap {
+   public:
+    StampMap();
+    ~StampMap();
+
+    void clear();
+
+    // 登记阶段
+    void addEntry(int row, int col);
+    void addPattern(const arma::sp_mat& MNA);
+    void compile(int size);  // 生成 CSC 结构，之后 slot 固定
+
+    bool isCompiled() const { return compiled; }
+    int getSize() const { return size; }
+    int getNonzeroNum() const { return static_cast<int>(row_idx.size()); }
+
+    // 查询 (row, col) 对应的 slot，不在结构中或被丢弃时返回 -1
+    int getSlot(int row, int col) const;
+
+    // 将 MNA 的数值作为基准值（线性部分），失败表示 MNA 中有结构外的非零元
+    bool loadBase(const arma::sp_mat& MNA);
+    // 基准值每变化一次加一，用于判断线性部分是否改变
+    int getBaseVersion() const { return base_version; }
+
+    // 每次迭代：values = base
+    void resetValues();
+
+    void addValue(int slot, double value) {
+        if (slot >= 0) {
+            values[slot] += value;
+        }
+    }
+    void setValue(int slot, double value) {
+        if (slot >= 0) {
+            values[slot] = value;
+        }
+    }
+
+    const arma::sp_mat& getMatrix() const { return matrix; }
+
+   private:
+    bool compiled;
+    int size;
+
+    std::vector<std::pair<int, int>> entries;  // (col, row)，登记阶段使用
+
+    // CSC 结构
+    std::vector<int> col_ptr;
+    std::vector<int> row_idx;
+
+    std::vector<double> base;  // 基准值
+    std::vector<double> base_next;
+    int base_version;
+    arma::sp_mat matrix;       // 结构固定的矩阵，数值直接写入
+    double* values;            // 指向 matrix 的数值数组
+};
+
+// 直接向 MNA / RHS 写入器件贡献，索引为负（地节点）的行列在这里被丢弃
+template <typename MatT, typename T>
+inline void stampAdd(MatT& MNA, int row, int col, const T& value) {
+    if (row >= 0 && col >= 0) {
+        MNA(row, col) += value;
+    }
+}
+
+template <typename MatT, typename T>
+inline void stampSet(MatT& MNA, int row, int col, const T& value) {
+    if (row >= 0 && col >= 0) {
+        MNA(row, col) = value;
+    }
+}
+
+template <typename VecT, typename T>
+inline void stampAdd(VecT& RHS, int row, const T& value) {
+    if (row >= 0) {
+        RHS(row) += value;
+    }
+}
+
+template <typename VecT, typename T>
+inline void stampSet(VecT& RHS, int row, const T& value) {
+    if (row >= 0) {
+        RHS(row) = value;
+    }
+}
+
+#endif  // SPICIAL_STAMPMAP_H
@@ -0,0 +1,53 @@
+#ifndef SPICIAL_SIMD_H
+#define SPICIAL_SIMD_H
+
+/**
+ * 向量指令的运行时选择
+ * x86-64 上的 GCC / Clang 用 target 属性把 AVX2 / AVX-512 内核单独编译，
+ * 运行时按 CPU 支持的指令集选择，不需要 -march=native；
+ * 其他编译器和平台只有标量实现。
+ * 调用方按 SSE 编译，AVX 内核返回前要 _mm256_zeroupper()，
+ * 否则每次调用都有 SSE / AVX 切换的开销。
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define SIMD_DISPATCH 1
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#include <immintrin.h>
+#else
+#define SIMD_DISPATCH 0
+#endif
+
+#define SIMD_KERNEL_SCALAR 0
+#define SIMD_KERNEL_AVX2 1    // AVX2 + FMA
+#define SIMD_KERNEL_AVX512 2  // AVX-512F
+
+// 当前 CPU 支持的最高一级内核，第一次调用时检测
+inline int getSimdKernel() {
+    static const int kernel = []() {
+#if SIMD_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return SIMD_KERNEL_AVX512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return SIMD_KERNEL_AVX2;
+        }
+#endif
+        return SIMD_KERNEL_SCALAR;
+    }();
+    return kernel;
+}
+
+inline const char* getSimdKernelName(int kernel) {
+    switch (kernel) {
+        case SIMD_KERNEL_AVX2:
+            return "avx2";
+        case SIMD_KERNEL_AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+#endif  // SPICIAL_SIMD_H
@@ -0,0 +1,89 @@
+#ifndef SPICIAL_SOLVERTYPE_H
+#define SPICIAL_SOLVERTYPE_H
+
+// 线性方程组求解器
+#define LINEAR_SOLVER_AUTO -1     // 按规模、密度和分析类型自动选择
+#define LINEAR_SOLVER_DIRECT 0    // 稀疏 LU (BTF + SparseLU)
+#define LINEAR_SOLVER_GMRES 1     // 重启 GMRES
+#define LINEAR_SOLVER_BICGSTAB 2  // BiCGSTAB
+#define LINEAR_SOLVER_DENSE 3     // 稠密 LU (SmallDenseLU / LAPACK)
+#define LINEAR_SOLVER_SUPERLU 4   // arma::spsolve (SuperLU)
+#define LINEAR_SOLVER_DOMAIN 5    // 嵌套剖分 + 子区域并行分解 (DomainLU)
+
+// 迭代法的预条件子
+#define PRECOND_NONE 0
+#define PRECOND_ILU0 1
+#define PRECOND_ILUT 2
+
+// 自动选择的阈值
+#define LINEAR_SOLVER_DENSE_MAX_SIZE 64       // 不超过该规模时用稠密 LU
+#define LINEAR_SOLVER_DENSE_MIN_DENSITY 0.25  // 或者密度足够大
+#define LINEAR_SOLVER_DENSE_DENSITY_SIZE 500  // （此时规模不超过该值）
+#define LINEAR_SOLVER_ITERATIVE_MIN_SIZE 200000  // 超过该规模时用迭代法
+#define LINEAR_SOLVER_DOMAIN_MIN_SIZE 50000  // 超过该规模且线程足够时区域分解
+#define LINEAR_SOLVER_DOMAIN_MIN_THREADS 4
+
+// 行列平衡和迭代精化
+#define EQUILIBRATE_MAX_PASSES 8   // Ruiz 迭代的最大轮数
+#define EQUILIBRATE_TOL 0.5        // 各行列最大元与 1 的偏差小于该值时停止
+#define REFINE_MAX_STEPS 3         // 迭代精化的最大步数
+#define REFINE_BACKWARD_ERROR 1e-14  // 分量后向误差小于该值时不再精化
+
+// 混合精度
+#define MIXED_PRECISION_MAX_STEPS 10  // 单精度分解时迭代精化的最大步数
+#define MIXED_PRECISION_MAX_STALLS 3  // 停滞超过该次数后只用双精度
+
+// 区域分解
+#define DOMAIN_MIN_SIZE 2000            // 每个子区域的最小规模
+#define DOMAIN_MAX_SEPARATOR_RATIO 0.1  // 分隔集占比超过该值时不分解
+
+// 非线性求解 (Newton)
+#define NEWTON_MAX_ITER 100           // 直接 Newton 的最大迭代次数
+#define NEWTON_STEPPING_MAX_ITER 50   // gmin / 源步进中每一级的最大迭代次数
+#define NEWTON_MIN_DAMPING 0.0625     // 自适应阻尼的最小系数
+#define GMIN_STEPPING_START 1e-2      // gmin 步进的初始电导 (S)
+#define GMIN_STEPPING_END 1e-12       // 小于该值后在 gmin = 0 上求解
+#define GMIN_STEPPING_FACTOR 10.0     // 每级 gmin 缩小的最大倍数
+#define GMIN_STEPPING_MIN_FACTOR 1.01  // 倍数小于该值时放弃
+#define SOURCE_STEPPING_INITIAL_STEP 0.1  // 源步进的初始步长（比例）
+#define SOURCE_STEPPING_MIN_STEP 1e-4     // 步长小于该值时放弃
+
+// 连续法（伪瞬态、同伦），在 gmin / 源步进之后尝试
+#define PTRAN_INITIAL_STEP 1e-6   // 伪时间步长初值（每个节点到地 1 F）
+#define PTRAN_MIN_STEP 1e-15      // 步长小于该值时放弃
+#define PTRAN_MAX_STEPS 1000      // 最大伪时间步数
+#define PTRAN_FAST_ITER 4         // 一步内 Newton 迭代不超过该值时放大步长
+#define PTRAN_STEP_GROW 4.0       // 步长放大倍数
+#define PTRAN_STEP_SHRINK 8.0     // 不收敛时步长缩小倍数
+#define PTRAN_END_CONDUCTANCE 1e-9  // 伪电导小于该值后在原方程上求解
+#define HOMOTOPY_INITIAL_STEP 0.05  // 同伦参数的初始步长
+#define HOMOTOPY_MIN_STEP 1e-6      // 步长小于该值时放弃
+
+// DC 扫描的预测器（下一点 Newton 的初值）
+#define SWEEP_PREDICTOR_NONE 0       // 上一点的解
+#define SWEEP_PREDICTOR_LINEAR 1     // 前两点线性外推
+#define SWEEP_PREDICTOR_QUADRATIC 2  // 前三点二次外推
+#define SWEEP_PREDICTOR_TANGENT 3    // Jacobian 上解切线方向
+
+// 多线程 DC 扫描
+#define DC_SWEEP_MIN_SEGMENT_POINTS 100  // 每段的最少点数
+// 段首的两个解相差超过 Newton 容差的该倍数时视为多值解
+#define DC_SWEEP_MATCH_FACTOR 10.0
+
+// 多线程 AC 扫描
+#define AC_SWEEP_MIN_THREAD_POINTS 16  // 每个线程的最少频率点数
+
+// AC 传递函数：每个 AC 源单位激励到 .PRINT / .PLOT AC 各输出的响应
+#define AC_TRANSFER_OFF 0      // 不计算
+#define AC_TRANSFER_AUTO 1     // 源比输出多时用伴随法，否则用直接法
+#define AC_TRANSFER_DIRECT 2   // 每个源一个右端项，一次分解解多个右端项
+#define AC_TRANSFER_ADJOINT 3  // 每个输出一次转置求解
+
+// 器件旁路（与 SPICE 的 BYPASS 相同的判据）
+#define DEVICE_BYPASS_RELTOL 1e-3  // 结电压、电流的相对容差
+#define DEVICE_BYPASS_VNTOL 1e-6   // 结电压的绝对容差 (V)
+#define DEVICE_BYPASS_ABSTOL 1e-12  // 电流的绝对容差 (A)
+// 增量装配时，电导或等效电流比装配过的最大值小超过该倍数就整体重新装配
+#define DEVICE_RESTAMP_RATIO 1e3
+
+#endif  // SPICIAL_SOLVERTYPE_H
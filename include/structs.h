@@ -26,6 +26,15 @@ struct Analysis {
     double step;  // for TRAN
     std::string sim_name;
     std::vector<double> sim_values;
+    int linear_solver;   // LINEAR_SOLVER_DIRECT, GMRES, BICGSTAB
+    int preconditioner;  // 迭代法使用，PRECOND_NONE, ILU0, ILUT
+    bool condense_ports;  // Newton 迭代前把线性部分凝聚到二极管端口上
+    bool mixed_precision;  // 稀疏 LU 用单精度分解，双精度迭代精化
+    bool device_bypass;  // 端电压几乎不变的二极管沿用上次的电流和电导
+    int sweep_predictor;  // for DC，SWEEP_PREDICTOR_NONE, LINEAR, ...
+    int sweep_threads;  // 扫描线程数，0 为自动（AC 用硬件线程数，DC 不分段）
+    int ac_transfer;    // for AC，AC_TRANSFER_OFF, AUTO, DIRECT, ADJOINT
+    bool print_stats;   // 分析结束后输出求解器统计 (.OPTIONS STATS)
 };
 
 struct Output {
@@ -26,5 +26,14 @@
 
 #define TOKEN_OPTION_NODE 1
 #define TOKEN_OPTION_LIST 2
+#define TOKEN_OPTION_SOLVER 3
+#define TOKEN_OPTION_PRECOND 4
+#define TOKEN_OPTION_PRECISION 5
+#define TOKEN_OPTION_BYPASS 6
+#define TOKEN_OPTION_PREDICTOR 7
+#define TOKEN_OPTION_THREADS 8
+#define TOKEN_OPTION_TRANSFER 9
+#define TOKEN_OPTION_STATS 10
+#define TOKEN_OPTION_CONDENSE 11
 
 #endif // SPICIAL_TOKENTYPE_H
@@ -14,6 +14,8 @@ CONFIG(debug, release|debug) {
 
 CONFIG(release, release|debug) {
     message("Compiling in release mode.")
+    # SmallDenseLU、二极管批量求值的 AVX2 / AVX-512 内核运行时选择 (simd.h)，
+    # 不需要 -march=native
 }
 
 macx{
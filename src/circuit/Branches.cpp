@@ -8,23 +8,24 @@ Branches::~Branches() {}
 
 int Branches::addBranch(const std::string& newBranch) {
     // 若新支路已经存在，返回支路的索引
-    auto it = std::find(branches.begin(), branches.end(), newBranch);
-    if (it != branches.end()) {
-        return std::distance(branches.begin(), it);
+    auto it = index.find(newBranch);
+    if (it != index.end()) {
+        return it->second;
     }
     branches.push_back(newBranch);
     // 若新支路被添加，返回支路的索引（最后一个）
+    index[newBranch] = branches.size() - 1;
     return branches.size() - 1;
 }
 
 int Branches::getBranchIndex(const std::string& name) const {
-    auto it = std::find(branches.begin(), branches.end(), name);
-    if (it == branches.end()) {
+    auto it = index.find(name);
+    if (it == index.end()) {
         qDebug() << "getBranchIndex(" << name.c_str() << ")";
         printf("Branch not found\n");
         return -1;
     }
-    return std::distance(branches.begin(), it);
+    return it->second;
 }
 
 int Branches::getBranchNum() const {
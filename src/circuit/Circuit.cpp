@@ -1,5 +1,8 @@
 #include "Circuit.h"
 #include <QDebug>
+#include <thread>
+#include "Benchmark.h"
+#include "DeviceStamps.h"
 
 Circuit::Circuit(Netlist& netlist_) : netlist(netlist_) {
     this->preProcess();
@@ -18,70 +21,75 @@ Circuit::~Circuit() {
     }
     delete MNA_T;
     delete RHS_T;
+    delete BTF_T;
+    delete ND_T;
+    delete DEV_T;
 }
 
 void Circuit::preProcess() {
     // add nodes and branches
     // and create node, branch index for components
     // and get model ptr for components
+    // 器件的节点索引不含地节点（地节点索引为 -1），与 MNA 的行列号一致
     for (Component* component : netlist.components) {
         switch (component->getType()) {
             case (COMPONENT_RESISTOR): {
                 Resistor* resistor = dynamic_cast<Resistor*>(component);
-                resistor->id_nplus = nodes.addNode(resistor->nplus);
-                resistor->id_nminus = nodes.addNode(resistor->nminus);
+                resistor->id_nplus = nodes.addNode(resistor->nplus) - 1;
+                resistor->id_nminus = nodes.addNode(resistor->nminus) - 1;
                 break;
             }
             case (COMPONENT_CAPACITOR): {
                 Capacitor* capacitor = dynamic_cast<Capacitor*>(component);
-                capacitor->id_nplus = nodes.addNode(capacitor->nplus);
-                capacitor->id_nminus = nodes.addNode(capacitor->nminus);
+                capacitor->id_nplus = nodes.addNode(capacitor->nplus) - 1;
+                capacitor->id_nminus = nodes.addNode(capacitor->nminus) - 1;
                 capacitor->id_branch = branches.addBranch(capacitor->name);
                 break;
             }
             case (COMPONENT_INDUCTOR): {
                 Inductor* inductor = dynamic_cast<Inductor*>(component);
-                inductor->id_nplus = nodes.addNode(inductor->nplus);
-                inductor->id_nminus = nodes.addNode(inductor->nminus);
+                inductor->id_nplus = nodes.addNode(inductor->nplus) - 1;
+                inductor->id_nminus = nodes.addNode(inductor->nminus) - 1;
                 inductor->id_branch = branches.addBranch(inductor->name);
                 break;
             }
             case (COMPONENT_VCVS): {
                 VCVS* vcvs = dynamic_cast<VCVS*>(component);
-                vcvs->id_nplus = nodes.addNode(vcvs->nplus);
-                vcvs->id_nminus = nodes.addNode(vcvs->nminus);
-                vcvs->id_ncplus = nodes.addNode(vcvs->ncplus);
-                vcvs->id_ncminus = nodes.addNode(vcvs->ncminus);
+                vcvs->id_nplus = nodes.addNode(vcvs->nplus) - 1;
+                vcvs->id_nminus = nodes.addNode(vcvs->nminus) - 1;
+                vcvs->id_ncplus = nodes.addNode(vcvs->ncplus) - 1;
+                vcvs->id_ncminus = nodes.addNode(vcvs->ncminus) - 1;
                 vcvs->id_branch = branches.addBranch(vcvs->name);
                 break;
             }
             case (COMPONENT_CCCS): {
                 CCCS* cccs = dynamic_cast<CCCS*>(component);
-                cccs->id_nplus = nodes.addNode(cccs->nplus);
-                cccs->id_nminus = nodes.addNode(cccs->nminus);
+                cccs->id_nplus = nodes.addNode(cccs->nplus) - 1;
+                cccs->id_nminus = nodes.addNode(cccs->nminus) - 1;
                 break;
             }
             case (COMPONENT_VCCS): {
                 VCCS* vccs = dynamic_cast<VCCS*>(component);
-                vccs->id_nplus = nodes.addNode(vccs->nplus);
-                vccs->id_nminus = nodes.addNode(vccs->nminus);
-                vccs->id_ncplus = nodes.addNode(vccs->ncplus);
-                vccs->id_ncminus = nodes.addNode(vccs->ncminus);
+                vccs->id_nplus = nodes.addNode(vccs->nplus) - 1;
+                vccs->id_nminus = nodes.addNode(vccs->nminus) - 1;
+                vccs->id_ncplus = nodes.addNode(vccs->ncplus) - 1;
+                vccs->id_ncminus = nodes.addNode(vccs->ncminus) - 1;
                 break;
             }
             case (COMPONENT_CCVS): {
                 CCVS* ccvs = dynamic_cast<CCVS*>(component);
-                ccvs->id_nplus = nodes.addNode(ccvs->nplus);
-                ccvs->id_nminus = nodes.addNode(ccvs->nminus);
+                ccvs->id_nplus = nodes.addNode(ccvs->nplus) - 1;
+                ccvs->id_nminus = nodes.addNode(ccvs->nminus) - 1;
                 ccvs->id_branch = branches.addBranch(ccvs->name);
                 break;
             }
             case (COMPONENT_VOLTAGE_SOURCE): {
                 VoltageSource* voltage_source =
                     dynamic_cast<VoltageSource*>(component);
-                voltage_source->id_nplus = nodes.addNode(voltage_source->nplus);
+                voltage_source->id_nplus =
+                    nodes.addNode(voltage_source->nplus) - 1;
                 voltage_source->id_nminus =
-                    nodes.addNode(voltage_source->nminus);
+                    nodes.addNode(voltage_source->nminus) - 1;
                 voltage_source->id_branch =
                     branches.addBranch(voltage_source->name);
                 break;
@@ -89,15 +97,16 @@ void Circuit::preProcess() {
             case (COMPONENT_CURRENT_SOURCE): {
                 CurrentSource* current_source =
                     dynamic_cast<CurrentSource*>(component);
-                current_source->id_nplus = nodes.addNode(current_source->nplus);
+                current_source->id_nplus =
+                    nodes.addNode(current_source->nplus) - 1;
                 current_source->id_nminus =
-                    nodes.addNode(current_source->nminus);
+                    nodes.addNode(current_source->nminus) - 1;
                 break;
             }
             case (COMPONENT_DIODE): {
                 Diode* diode = dynamic_cast<Diode*>(component);
-                diode->id_nplus = nodes.addNode(diode->nplus);
-                diode->id_nminus = nodes.addNode(diode->nminus);
+                diode->id_nplus = nodes.addNode(diode->nplus) - 1;
+                diode->id_nminus = nodes.addNode(diode->nminus) - 1;
                 diode->id_branch = branches.addBranch(diode->name);
                 diode->model =
                     dynamic_cast<DiodeModel*>(getModelPtr(diode->modelname));
@@ -106,8 +115,8 @@ void Circuit::preProcess() {
         }
     }
 
-    // 更新 branch 索引，加上节点数
-    int node_num = nodes.getNodeNum();
+    // 更新 branch 索引，加上节点数（不含地节点）
+    int node_num = nodes.getNodeNumExgnd();
     for (Component* component : netlist.components) {
         switch (component->getType()) {
             case (COMPONENT_RESISTOR): {
@@ -156,11 +165,18 @@ void Circuit::preProcess() {
         }
     }
 
+    // 按类型连续存放的器件表，之后的装配只遍历这些表
+    this->generateDeviceTables();
     // 创建 MNA, RHS 模板
     this->generateMNATemplate();
+    // 分析 BTF 结构，弱耦合的子电路分成不同的块
+    this->generateBlockTriangular();
+    // 大规模网格划分为可以并行分解的子区域
+    this->generateNestedDissection();
     // 更新 Simulation 中的 MNA, RHS 模板(static)
-    Simulation test_sim = Simulation(*(netlist.analyses.front()), netlist,
-                                     nodes, branches, MNA_T, RHS_T);
+    Simulation test_sim =
+        Simulation(*(netlist.analyses.front()), netlist, nodes, branches,
+                   MNA_T, RHS_T, BTF_T, ND_T, DEV_T);
 }
 
 void Circuit::printNodes() {
@@ -171,166 +187,90 @@ void Circuit::printBranches() {
     branches.printBranches();
 }
 
+void Circuit::generateDeviceTables() {
+    DEV_T = new DeviceTables();
+    DEV_T->build(netlist.components, branches, nodes.getNodeNumExgnd());
+}
+
 void Circuit::generateMNATemplate() {
-    // 生成 MNA, RHS 模板
-    int node_num = nodes.getNodeNum();
-    // qDebug() << "generateDCMNA() node_num: " << node_num;
+    // 生成 MNA, RHS 模板，直接生成不含地节点的方程
+    // 与地节点相关的项在 StampMap / stampAdd 中被丢弃
+    // 先登记所有位置再一次编译成 CSC，避免逐个插入非零元；
+    // 同一位置的贡献相加
+    int node_num = nodes.getNodeNumExgnd();
     int branch_num = branches.getBranchNum();
-    // qDebug() << "generateDCMNA() branch_num: " << branch_num;
     int matrix_size = node_num + branch_num;
-    arma::sp_mat* MNA =
-        new arma::sp_mat(matrix_size, matrix_size);  // create sparse MNA
-    arma::vec* RHS =
-        new arma::vec(arma::zeros<arma::vec>(matrix_size));  // create RHS
-    // qDebug() << "generateDCMNA() matrix_size: " << matrix_size;
-    for (Component* component : netlist.components) {
-        switch (component->getType()) {
-            case COMPONENT_RESISTOR: {
-                Resistor* resistor = dynamic_cast<Resistor*>(component);
-                int id_nplus = resistor->getIdNplus();
-                int id_nminus = resistor->getIdNminus();
-                double resistance = resistor->getResistance();
-
-                (*MNA)(id_nplus, id_nplus) += 1 / resistance;
-                (*MNA)(id_nminus, id_nminus) += 1 / resistance;
-                (*MNA)(id_nplus, id_nminus) -= 1 / resistance;
-                (*MNA)(id_nminus, id_nplus) -= 1 / resistance;
-                break;
-            }
-            case COMPONENT_CAPACITOR: {
-                Capacitor* capacitor = dynamic_cast<Capacitor*>(component);
-                // int id_nplus = capacitor->getIdNplus();
-                // int id_nminus = capacitor->getIdNminus();
-                int id_branch = capacitor->getIdBranch();
-                // double capacitance = capacitor->getCapacitance();
-
-                // (*MNA)(id_nplus, id_nplus) += 0 * capacitance;
-                // (*MNA)(id_nminus, id_nminus) += 0 * capacitance;
-                // (*MNA)(id_nplus, id_nminus) -= 0 * capacitance;
-                // (*MNA)(id_nminus, id_nplus) -= 0 * capacitance;
-                // (*MNA)(id_branch, id_nplus) = 0 * capacitance;
-                // (*MNA)(id_branch, id_nminus) = -0 * capacitance;
-                (*MNA)(id_branch, id_branch) = -1;
-                break;
-            }
-            case COMPONENT_INDUCTOR: {
-                Inductor* inductor = dynamic_cast<Inductor*>(component);
-                int id_nplus = inductor->getIdNplus();
-                int id_nminus = inductor->getIdNminus();
-                int id_branch = inductor->getIdBranch();
-                // double inductance = inductor->getInductance();
-
-                (*MNA)(id_nplus, id_branch) = 1;
-                (*MNA)(id_nminus, id_branch) = -1;
-                (*MNA)(id_branch, id_nplus) = 1;
-                (*MNA)(id_branch, id_nminus) = -1;
-                // (*MNA)(id_branch, id_branch) = -0 * inductance;
-                break;
-            }
-            case COMPONENT_VCVS: {
-                VCVS* vcvs = dynamic_cast<VCVS*>(component);
-                int id_nplus = vcvs->getIdNplus();
-                int id_nminus = vcvs->getIdNminus();
-                int id_ncplus = vcvs->getIdNCplus();
-                int id_ncminus = vcvs->getIdNCminus();
-                int id_branch = vcvs->getIdBranch();
-                double gain = vcvs->getGain();
-
-                (*MNA)(id_nplus, id_branch) = 1;
-                (*MNA)(id_nminus, id_branch) = -1;
-                (*MNA)(id_branch, id_nplus) = 1;
-                (*MNA)(id_branch, id_nminus) = -1;
-                (*MNA)(id_branch, id_ncplus) = -gain;
-                (*MNA)(id_branch, id_ncminus) = gain;
-                break;
-            }
-            case COMPONENT_CCCS: {
-                CCCS* cccs = dynamic_cast<CCCS*>(component);
-                int id_nplus = cccs->getIdNplus();
-                int id_nminus = cccs->getIdNminus();
-                int id_vsource =
-                    branches.getBranchIndex(cccs->getName()) + node_num;
-                double gain = cccs->getGain();
-
-                (*MNA)(id_nplus, id_vsource) += gain;
-                (*MNA)(id_nminus, id_vsource) -= gain;
-                break;
-            }
-            case COMPONENT_VCCS: {
-                VCCS* vccs = dynamic_cast<VCCS*>(component);
-                int id_nplus = vccs->getIdNplus();
-                int id_nminus = vccs->getIdNminus();
-                int id_ncplus = vccs->getIdNCplus();
-                int id_ncminus = vccs->getIdNCminus();
-                double gain = vccs->getGain();
-
-                (*MNA)(id_nplus, id_ncplus) += gain;
-                (*MNA)(id_nplus, id_ncminus) -= gain;
-                (*MNA)(id_nminus, id_ncplus) -= gain;
-                (*MNA)(id_nminus, id_ncminus) += gain;
-                break;
-            }
-            case COMPONENT_CCVS: {
-                CCVS* ccvs = dynamic_cast<CCVS*>(component);
-                int id_nplus = ccvs->getIdNplus();
-                int id_nminus = ccvs->getIdNminus();
-                int id_branch = ccvs->getIdBranch();
-                double gain = ccvs->getGain();
-                int id_vsource =
-                    branches.getBranchIndex(ccvs->getVsource()) + node_num;
-
-                (*MNA)(id_branch, id_nplus) = 1;
-                (*MNA)(id_branch, id_nminus) = -1;
-                (*MNA)(id_nplus, id_branch) = 1;
-                (*MNA)(id_nminus, id_branch) = -1;
-                (*MNA)(id_branch, id_vsource) = -gain;
-                break;
-            }
-            case COMPONENT_VOLTAGE_SOURCE: {
-                VoltageSource* voltage_source =
-                    dynamic_cast<VoltageSource*>(component);
-                int id_nplus = voltage_source->getIdNplus();
-                int id_nminus = voltage_source->getIdNminus();
-                int id_branch = voltage_source->getIdBranch();
-                double dc_voltage = voltage_source->getDCVoltage();
-
-                (*MNA)(id_nplus, id_branch) = 1;
-                (*MNA)(id_nminus, id_branch) = -1;
-                (*MNA)(id_branch, id_nplus) = 1;
-                (*MNA)(id_branch, id_nminus) = -1;
-                (*RHS)(id_branch) = dc_voltage;
-                break;
-            }
-            case COMPONENT_CURRENT_SOURCE: {
-                CurrentSource* current_source =
-                    dynamic_cast<CurrentSource*>(component);
-                int id_nplus = current_source->getIdNplus();
-                int id_nminus = current_source->getIdNminus();
-                double dc_current = current_source->getDCCurrent();
 
-                (*RHS)(id_nplus) -= dc_current;
-                (*RHS)(id_nminus) += dc_current;
-                break;
-            }
-            case COMPONENT_DIODE: {
-                Diode* diode = dynamic_cast<Diode*>(component);
-                int id_branch = diode->getIdBranch();
+    StampMap stamps;
+    PatternSink pattern(stamps);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampLinear(pattern);
+    });
+    stamps.compile(matrix_size);
+    stamps.resetValues();
 
-                (*MNA)(id_branch, id_branch) = -1;
-                break;
-            }
-            default: {
-                qDebug() << "generateMNA() Unknown component type:"
-                         << component->getType();
-                break;
-            }
-        }
+    arma::vec* RHS =
+        new arma::vec(arma::zeros<arma::vec>(matrix_size));  // create RHS
+    StampMapSink<arma::vec> sink(stamps, *RHS);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampLinear(sink);
+    });
+
+    // 相互抵消的贡献不作为非零元保留
+    const arma::sp_mat& M = stamps.getMatrix();
+    int nnz = stamps.getNonzeroNum();
+    arma::uvec rowind(nnz);
+    arma::uvec colptr(matrix_size + 1);
+    for (int k = 0; k < nnz; k++) {
+        rowind(k) = M.row_indices[k];
+    }
+    for (int col = 0; col <= matrix_size; col++) {
+        colptr(col) = M.col_ptrs[col];
     }
+    arma::sp_mat* MNA = new arma::sp_mat(
+        rowind, colptr, arma::vec(M.values, nnz), matrix_size, matrix_size);
+
     /** 保存 MNA 模板 */
     // 未考虑 analysis 语句的模板，若为静态工作点分析，求解该方程即可
     MNA_T = MNA;
     RHS_T = RHS;
-    // arma::vec x = arma::spsolve(MNA, RHS);
+}
+
+void Circuit::addNewtonPattern(StampMap& pattern) const {
+    // Newton 迭代时二极管会在 MNA 模板之外增加非零元，一并登记
+    pattern.addPattern(*MNA_T);
+    PatternSink sink(pattern);
+    DiodeStamp(DEV_T->diodes).stampNewtonPattern(sink);
+    pattern.compile(static_cast<int>(MNA_T->n_rows));
+}
+
+void Circuit::generateBlockTriangular() {
+    StampMap pattern;
+    addNewtonPattern(pattern);
+    BTF_T = new BlockTriangular();
+    BTF_T->analyze(pattern.getMatrix());
+}
+
+void Circuit::generateNestedDissection() {
+    // 在 Newton 矩阵的连接图上划分（节点和支路变量一起），
+    // 子区域数取硬件线程数；规模不够大或分隔集过大时不划分
+    ND_T = new NestedDissection();
+    int thread_num = static_cast<int>(std::thread::hardware_concurrency());
+    if (static_cast<int>(MNA_T->n_rows) < 2 * DOMAIN_MIN_SIZE ||
+        thread_num < 2) {
+        return;
+    }
+    StampMap pattern;
+    addNewtonPattern(pattern);
+    ND_T->analyze(pattern.getMatrix(), thread_num);
+}
+
+void Circuit::printBlockTriangular() {
+    if (BTF_T == nullptr) {
+        qDebug() << "BTF_T is nullptr.";
+        return;
+    }
+    BTF_T->printBlocks();
 }
 
 void Circuit::printMNATemplate() {
@@ -345,6 +285,15 @@ void Circuit::printMNATemplate() {
     std::cout << "-------------------------------" << std::endl;
 }
 
+void Circuit::benchmarkSolvers() const {
+    if (MNA_T == nullptr || RHS_T == nullptr) {
+        qDebug() << "MNA_T or RHS_T is nullptr.";
+        return;
+    }
+    benchmarkLinearSolvers(*MNA_T, *RHS_T);
+    benchmarkDiodeExp();
+}
+
 Component* Circuit::getComponentPtr(const std::string& name) {
     return netlist.getComponentPtr(name);
 }
@@ -403,7 +352,7 @@ std::vector<ColumnData> Circuit::createOutputYData(
     const std::vector<Variable>& var_list,
     const std::vector<arma::vec>& sim_results) {
     std::vector<ColumnData> ydata;
-    // 不要用 getComponentPtr()，里面的索引包含地节点
+    // 节点和支路按名字查解向量中的下标（不含地节点）
     for (const auto& var : var_list) {
         for (const auto& node_branch : var.nodes) {
             ColumnData y;
@@ -719,6 +668,11 @@ void Circuit::outputResults() {
 
         // print
         printOutputData(xdata, ydata_print, "ac", ac_sim_id);
+        if (ac_simulation->hasTransfer()) {
+            std::vector<ColumnData> ydata_transfer =
+                createTransferYData(*ac_simulation);
+            printOutputData(xdata, ydata_transfer, "actf", ac_sim_id);
+        }
 
         if (ac_plot_requests.empty()) {
             break;
@@ -771,6 +725,32 @@ void Circuit::outputResults() {
     }
 }
 
+std::vector<ColumnData> Circuit::createTransferYData(
+    const ACSimulation& ac_simulation) {
+    const std::vector<arma::cx_mat>& transfer =
+        ac_simulation.getTransferResults();
+    const std::vector<std::string>& outputs =
+        ac_simulation.getTransferOutputs();
+    const std::vector<std::string>& sources =
+        ac_simulation.getTransferSources();
+    std::vector<ColumnData> ydata;
+
+    for (size_t s = 0; s < sources.size(); s++) {
+        for (size_t o = 0; o < outputs.size(); o++) {
+            std::string pair = outputs[o] + "/" + sources[s];
+            ColumnData mag{"HM(" + pair + ")", {}};
+            ColumnData phase{"HP(" + pair + ")", {}};
+            for (const auto& h : transfer) {
+                mag.values.push_back(abs(h(o, s)));
+                phase.values.push_back(arg(h(o, s)));
+            }
+            ydata.push_back(mag);
+            ydata.push_back(phase);
+        }
+    }
+    return ydata;
+}
+
 void Circuit::printOutputData(ColumnData& xdata,
                               std::vector<ColumnData>& ydata,
                               std::string sim_type,
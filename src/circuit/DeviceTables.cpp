@@ -0,0 +1,409 @@
+#include "DeviceTables.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "simd.h"
+
+#if SIMD_DISPATCH
+// GCC 12 的 AVX-512 / AVX2 头文件用自赋值表示未定义的向量，
+// 内联到 target 函数后误报 -Wmaybe-uninitialized
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// 向量化的 exp：x = k ln2 + r，|r| <= ln2 / 2，exp(r) 用 13 阶 Taylor
+// 多项式（截断误差约 4e-18），再把 k 加到指数位上。
+// 与 std::exp 的相对误差在几个 ulp 以内；上溢为 inf，nan 保持不变，
+// 结果低于最小正规数时直接取 0（std::exp 此时为次正规数）。
+static const double EXP_MAX = 709.782712893384;
+static const double EXP_MIN = -708.396418532264;
+static const double EXP_LOG2E = 1.4426950408889634;
+static const double EXP_LN2_HI = 6.93147180369123816490e-01;
+static const double EXP_LN2_LO = 1.90821492927058770002e-10;
+// 1 / k!，k = 13 .. 2
+static const double EXP_COEF[] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0,
+    1.0 / 3628800.0,    1.0 / 362880.0,    1.0 / 40320.0,
+    1.0 / 5040.0,       1.0 / 720.0,       1.0 / 120.0,
+    1.0 / 24.0,         1.0 / 6.0,         1.0 / 2.0};
+// 加上 1.5 * 2^52 后整数落在尾数的低位，再减去偏置得到 k + 1023
+static const double EXP_SHIFTER = 6755399441055744.0 + 1023.0;
+static const long long EXP_SHIFTER_BITS = 0x4338000000000000LL;
+
+SIMD_TARGET_AVX512 static inline __m512d exp512(__m512d x) {
+    __mmask8 over = _mm512_cmp_pd_mask(x, _mm512_set1_pd(EXP_MAX),
+                                       _CMP_GT_OQ);
+    __mmask8 under = _mm512_cmp_pd_mask(x, _mm512_set1_pd(EXP_MIN),
+                                        _CMP_LT_OQ);
+    x = _mm512_min_pd(_mm512_set1_pd(EXP_MAX), x);  // nan 保持不变
+    x = _mm512_max_pd(_mm512_set1_pd(EXP_MIN), x);
+    __m512d k = _mm512_roundscale_pd(
+        _mm512_mul_pd(x, _mm512_set1_pd(EXP_LOG2E)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(EXP_LN2_HI), x);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(EXP_LN2_LO), r);
+    __m512d p = _mm512_set1_pd(EXP_COEF[0]);
+    for (int i = 1; i < 12; i++) {
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_COEF[i]));
+    }
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+    // k 可能为 1024（x 接近 EXP_MAX），分成两次乘 2^(k/2)
+    __m512i bits = _mm512_castpd_si512(
+        _mm512_add_pd(k, _mm512_set1_pd(EXP_SHIFTER)));
+    bits = _mm512_sub_epi64(bits, _mm512_set1_epi64(EXP_SHIFTER_BITS));
+    __m512i half = _mm512_srai_epi64(
+        _mm512_sub_epi64(bits, _mm512_set1_epi64(1023)), 1);
+    __m512i rest = _mm512_sub_epi64(
+        _mm512_sub_epi64(bits, _mm512_set1_epi64(1023)), half);
+    __m512d scale1 = _mm512_castsi512_pd(_mm512_slli_epi64(
+        _mm512_add_epi64(half, _mm512_set1_epi64(1023)), 52));
+    __m512d scale2 = _mm512_castsi512_pd(_mm512_slli_epi64(
+        _mm512_add_epi64(rest, _mm512_set1_epi64(1023)), 52));
+    p = _mm512_mul_pd(_mm512_mul_pd(p, scale1), scale2);
+    p = _mm512_mask_blend_pd(over, p, _mm512_set1_pd(HUGE_VAL));
+    p = _mm512_mask_blend_pd(under, p, _mm512_setzero_pd());
+    return p;
+}
+
+SIMD_TARGET_AVX2 static inline __m256d exp256(__m256d x) {
+    __m256d over = _mm256_cmp_pd(x, _mm256_set1_pd(EXP_MAX), _CMP_GT_OQ);
+    __m256d under = _mm256_cmp_pd(x, _mm256_set1_pd(EXP_MIN), _CMP_LT_OQ);
+    x = _mm256_min_pd(_mm256_set1_pd(EXP_MAX), x);  // nan 保持不变
+    x = _mm256_max_pd(_mm256_set1_pd(EXP_MIN), x);
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(EXP_LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(EXP_LN2_HI), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(EXP_LN2_LO), r);
+    __m256d p = _mm256_set1_pd(EXP_COEF[0]);
+    for (int i = 1; i < 12; i++) {
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_COEF[i]));
+    }
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+    // k 可能为 1024（x 接近 EXP_MAX），分成两次乘 2^(k/2)
+    __m256i bits = _mm256_castpd_si256(
+        _mm256_add_pd(k, _mm256_set1_pd(EXP_SHIFTER)));
+    bits = _mm256_sub_epi64(bits, _mm256_set1_epi64x(EXP_SHIFTER_BITS));
+    // AVX2 没有 64 位算术右移，k 在 [-1022, 1024] 内，用 32 位移位即可
+    __m256i kint = _mm256_sub_epi64(bits, _mm256_set1_epi64x(1023));
+    __m256i half = _mm256_srai_epi32(kint, 1);
+    half = _mm256_blend_epi32(half, _mm256_srai_epi32(kint, 31), 0xAA);
+    __m256i rest = _mm256_sub_epi64(kint, half);
+    __m256d scale1 = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_add_epi64(half, _mm256_set1_epi64x(1023)), 52));
+    __m256d scale2 = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_add_epi64(rest, _mm256_set1_epi64x(1023)), 52));
+    p = _mm256_mul_pd(_mm256_mul_pd(p, scale1), scale2);
+    p = _mm256_blendv_pd(p, _mm256_set1_pd(HUGE_VAL), over);
+    p = _mm256_blendv_pd(p, _mm256_setzero_pd(), under);
+    return p;
+}
+
+// 批量求值的向量部分，返回处理的个数，余下的由调用方按标量补齐；
+// 返回前 vzeroupper，避免调用方的 SSE 代码付出切换开销
+SIMD_TARGET_AVX512 static int evaluateAVX512(const DiodeTable& table,
+                                             int num,
+                                             const int* index,
+                                             const double* v,
+                                             double* current,
+                                             double* conductance) {
+    const double* is = table.saturation_current.data();
+    const double* inv_vt = table.inv_thermal_voltage.data();
+    const double* gs = table.saturation_conductance.data();
+    int k = 0;
+    for (; k + 8 <= num; k += 8) {
+        __m512d vis, vinv, vgs;
+        if (index == nullptr) {
+            vis = _mm512_loadu_pd(is + k);
+            vinv = _mm512_loadu_pd(inv_vt + k);
+            vgs = _mm512_loadu_pd(gs + k);
+        } else {
+            __m256i idx = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(index + k));
+            vis = _mm512_i32gather_pd(idx, is, 8);
+            vinv = _mm512_i32gather_pd(idx, inv_vt, 8);
+            vgs = _mm512_i32gather_pd(idx, gs, 8);
+        }
+        __m512d e = exp512(_mm512_mul_pd(_mm512_loadu_pd(v + k), vinv));
+        _mm512_storeu_pd(current + k,
+                         _mm512_mul_pd(vis,
+                                       _mm512_sub_pd(e, _mm512_set1_pd(1.0))));
+        _mm512_storeu_pd(conductance + k, _mm512_mul_pd(vgs, e));
+    }
+    _mm256_zeroupper();
+    return k;
+}
+
+SIMD_TARGET_AVX2 static int evaluateAVX2(const DiodeTable& table,
+                                         int num,
+                                         const int* index,
+                                         const double* v,
+                                         double* current,
+                                         double* conductance) {
+    const double* is = table.saturation_current.data();
+    const double* inv_vt = table.inv_thermal_voltage.data();
+    const double* gs = table.saturation_conductance.data();
+    int k = 0;
+    for (; k + 4 <= num; k += 4) {
+        __m256d vis, vinv, vgs;
+        if (index == nullptr) {
+            vis = _mm256_loadu_pd(is + k);
+            vinv = _mm256_loadu_pd(inv_vt + k);
+            vgs = _mm256_loadu_pd(gs + k);
+        } else {
+            __m128i idx =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(index + k));
+            vis = _mm256_i32gather_pd(is, idx, 8);
+            vinv = _mm256_i32gather_pd(inv_vt, idx, 8);
+            vgs = _mm256_i32gather_pd(gs, idx, 8);
+        }
+        __m256d e = exp256(_mm256_mul_pd(_mm256_loadu_pd(v + k), vinv));
+        _mm256_storeu_pd(current + k,
+                         _mm256_mul_pd(vis,
+                                       _mm256_sub_pd(e, _mm256_set1_pd(1.0))));
+        _mm256_storeu_pd(conductance + k, _mm256_mul_pd(vgs, e));
+    }
+    _mm256_zeroupper();
+    return k;
+}
+
+SIMD_TARGET_AVX512 static int expAVX512(int num, const double* x, double* y) {
+    int k = 0;
+    for (; k + 8 <= num; k += 8) {
+        _mm512_storeu_pd(y + k, exp512(_mm512_loadu_pd(x + k)));
+    }
+    _mm256_zeroupper();
+    return k;
+}
+
+SIMD_TARGET_AVX2 static int expAVX2(int num, const double* x, double* y) {
+    int k = 0;
+    for (; k + 4 <= num; k += 4) {
+        _mm256_storeu_pd(y + k, exp256(_mm256_loadu_pd(x + k)));
+    }
+    _mm256_zeroupper();
+    return k;
+}
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+DeviceTables::DeviceTables() {}
+
+DeviceTables::~DeviceTables() {}
+
+void DeviceTables::build(const std::list<Component*>& components,
+                         const Branches& branches,
+                         int node_num) {
+    *this = DeviceTables();
+    for (Component* component : components) {
+        switch (component->getType()) {
+            case COMPONENT_RESISTOR: {
+                Resistor* resistor = dynamic_cast<Resistor*>(component);
+                resistors.nplus.push_back(resistor->getIdNplus());
+                resistors.nminus.push_back(resistor->getIdNminus());
+                resistors.conductance.push_back(1 / resistor->getResistance());
+                break;
+            }
+            case COMPONENT_CAPACITOR: {
+                Capacitor* capacitor = dynamic_cast<Capacitor*>(component);
+                capacitors.nplus.push_back(capacitor->getIdNplus());
+                capacitors.nminus.push_back(capacitor->getIdNminus());
+                capacitors.branch.push_back(capacitor->getIdBranch());
+                capacitors.capacitance.push_back(capacitor->getCapacitance());
+                capacitors.initial_voltage.push_back(
+                    capacitor->getInitialVoltage());
+                break;
+            }
+            case COMPONENT_INDUCTOR: {
+                Inductor* inductor = dynamic_cast<Inductor*>(component);
+                inductors.nplus.push_back(inductor->getIdNplus());
+                inductors.nminus.push_back(inductor->getIdNminus());
+                inductors.branch.push_back(inductor->getIdBranch());
+                inductors.inductance.push_back(inductor->getInductance());
+                inductors.initial_current.push_back(
+                    inductor->getInitialCurrent());
+                break;
+            }
+            case COMPONENT_VCVS: {
+                VCVS* e = dynamic_cast<VCVS*>(component);
+                vcvs.nplus.push_back(e->getIdNplus());
+                vcvs.nminus.push_back(e->getIdNminus());
+                vcvs.ncplus.push_back(e->getIdNCplus());
+                vcvs.ncminus.push_back(e->getIdNCminus());
+                vcvs.branch.push_back(e->getIdBranch());
+                vcvs.gain.push_back(e->getGain());
+                break;
+            }
+            case COMPONENT_CCCS: {
+                CCCS* f = dynamic_cast<CCCS*>(component);
+                cccs.nplus.push_back(f->getIdNplus());
+                cccs.nminus.push_back(f->getIdNminus());
+                cccs.control.push_back(
+                    branches.getBranchIndex(f->getVsource()) + node_num);
+                cccs.gain.push_back(f->getGain());
+                break;
+            }
+            case COMPONENT_VCCS: {
+                VCCS* g = dynamic_cast<VCCS*>(component);
+                vccs.nplus.push_back(g->getIdNplus());
+                vccs.nminus.push_back(g->getIdNminus());
+                vccs.ncplus.push_back(g->getIdNCplus());
+                vccs.ncminus.push_back(g->getIdNCminus());
+                vccs.gain.push_back(g->getGain());
+                break;
+            }
+            case COMPONENT_CCVS: {
+                CCVS* h = dynamic_cast<CCVS*>(component);
+                ccvs.nplus.push_back(h->getIdNplus());
+                ccvs.nminus.push_back(h->getIdNminus());
+                ccvs.branch.push_back(h->getIdBranch());
+                ccvs.control.push_back(
+                    branches.getBranchIndex(h->getVsource()) + node_num);
+                ccvs.gain.push_back(h->getGain());
+                break;
+            }
+            case COMPONENT_VOLTAGE_SOURCE: {
+                VoltageSource* voltage_source =
+                    dynamic_cast<VoltageSource*>(component);
+                voltage_sources.nplus.push_back(voltage_source->getIdNplus());
+                voltage_sources.nminus.push_back(
+                    voltage_source->getIdNminus());
+                voltage_sources.branch.push_back(
+                    voltage_source->getIdBranch());
+                voltage_sources.dc.push_back(voltage_source->getDCVoltage());
+                voltage_sources.ac_magnitude.push_back(
+                    voltage_source->getACMagnitude());
+                voltage_sources.ac_phase.push_back(
+                    voltage_source->getACPhase() / 180 * M_PI);
+                voltage_sources.function.push_back(
+                    voltage_source->getFunction());
+                voltage_sources.name.push_back(voltage_source->getName());
+                break;
+            }
+            case COMPONENT_CURRENT_SOURCE: {
+                CurrentSource* current_source =
+                    dynamic_cast<CurrentSource*>(component);
+                current_sources.nplus.push_back(current_source->getIdNplus());
+                current_sources.nminus.push_back(
+                    current_source->getIdNminus());
+                current_sources.branch.push_back(-1);
+                current_sources.dc.push_back(current_source->getDCCurrent());
+                current_sources.ac_magnitude.push_back(
+                    current_source->getACMagnitude());
+                current_sources.ac_phase.push_back(
+                    current_source->getACPhase() / 180 * M_PI);
+                current_sources.function.push_back(
+                    current_source->getFunction());
+                current_sources.name.push_back(current_source->getName());
+                break;
+            }
+            case COMPONENT_DIODE: {
+                Diode* diode = dynamic_cast<Diode*>(component);
+                const DiodeModel* model = diode->getModel();
+                if (model == nullptr) {
+                    qDebug() << "DeviceTables::build() diode"
+                             << diode->getName().c_str()
+                             << "has no model, using default parameters.";
+                    static const DiodeModel default_model("default");
+                    model = &default_model;
+                }
+                diodes.nplus.push_back(diode->getIdNplus());
+                diodes.nminus.push_back(diode->getIdNminus());
+                diodes.branch.push_back(diode->getIdBranch());
+                diodes.initial_voltage.push_back(diode->getInitialVoltage());
+                double is = model->getSaturationCurrent();
+                double vt = model->getThermalVoltage();
+                diodes.saturation_current.push_back(is);
+                diodes.inv_thermal_voltage.push_back(1 / vt);
+                diodes.saturation_conductance.push_back(is / vt);
+                diodes.thermal_voltage.push_back(vt);
+                diodes.critical_voltage.push_back(
+                    vt * log(vt / (std::sqrt(2.0) * is)));
+                break;
+            }
+            default: {
+                qDebug() << "DeviceTables::build() Unknown component type:"
+                         << component->getType();
+                break;
+            }
+        }
+    }
+}
+
+// 按 kernel 选择向量部分，返回处理的个数
+static int evaluateKernel(const DiodeTable& table,
+                          int kernel,
+                          int num,
+                          const int* index,
+                          const double* v,
+                          double* current,
+                          double* conductance) {
+#if SIMD_DISPATCH
+    if (kernel == SIMD_KERNEL_AVX512) {
+        return evaluateAVX512(table, num, index, v, current, conductance);
+    }
+    if (kernel == SIMD_KERNEL_AVX2) {
+        return evaluateAVX2(table, num, index, v, current, conductance);
+    }
+#endif
+    return 0;
+}
+
+void DiodeTable::evaluate(const double* v,
+                          double* current,
+                          double* conductance) const {
+    int num = size();
+    int k = evaluateKernel(*this, getSimdKernel(), num, nullptr, v, current,
+                           conductance);
+    for (; k < num; k++) {
+        evaluate(k, v[k], current[k], conductance[k]);
+    }
+}
+
+void DiodeTable::evaluate(int num,
+                          const int* index,
+                          const double* v,
+                          double* current,
+                          double* conductance) const {
+    int k = evaluateKernel(*this, getSimdKernel(), num, index, v, current,
+                           conductance);
+    for (; k < num; k++) {
+        evaluate(index[k], v[k], current[k], conductance[k]);
+    }
+}
+
+void DiodeTable::batchExp(int kernel, int num, const double* x, double* y) {
+    int k = 0;
+#if SIMD_DISPATCH
+    kernel = std::min(kernel, getSimdKernel());
+    if (kernel == SIMD_KERNEL_AVX512) {
+        k = expAVX512(num, x, y);
+    } else if (kernel == SIMD_KERNEL_AVX2) {
+        k = expAVX2(num, x, y);
+    }
+#endif
+    for (; k < num; k++) {
+        y[k] = exp(x[k]);
+    }
+}
+
+const char* DiodeTable::getKernelName() {
+    return getSimdKernelName(getSimdKernel());
+}
+
+void DeviceTables::printSize() const {
+    std::cout << "Devices: R = " << resistors.size()
+              << ", C = " << capacitors.size() << ", L = " << inductors.size()
+              << ", E = " << vcvs.size() << ", F = " << cccs.size()
+              << ", G = " << vccs.size() << ", H = " << ccvs.size()
+              << ", V = " << voltage_sources.size()
+              << ", I = " << current_sources.size()
+              << ", D = " << diodes.size()
+              << " (kernel = " << DiodeTable::getKernelName() << ")"
+              << std::endl;
+}
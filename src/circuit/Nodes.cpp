@@ -6,29 +6,31 @@ Nodes::Nodes() {
     // add ground node, name is "0"
     std::string gnd = "0";
     nodes.push_back(gnd);
+    index[gnd] = 0;
 }
 
 Nodes::~Nodes() {}
 
 int Nodes::addNode(const std::string& newNode) {
     // 若新节点已经存在，返回节点的索引
-    auto it = std::find(nodes.begin(), nodes.end(), newNode);
-    if (it != nodes.end()) {
-        return std::distance(nodes.begin(), it);
+    auto it = index.find(newNode);
+    if (it != index.end()) {
+        return it->second;
     }
     nodes.push_back(newNode);
     // 若新节点被添加，返回节点的索引（最后一个）
+    index[newNode] = nodes.size() - 1;
     return nodes.size() - 1;
 }
 
 int Nodes::getNodeIndex(const std::string& name) const {  // 获取节点的编号
-    auto it = std::find(nodes.begin(), nodes.end(), name);
-    if (it == nodes.end()) {
+    auto it = index.find(name);
+    if (it == index.end()) {
         qDebug() << "getNodeIndex(" << name.c_str() << ")";
         printf("Node not found\n");
         return 0;
     }
-    return std::distance(nodes.begin(), it);
+    return it->second;
 }
 
 int Nodes::getNodeIndexExgnd(const std::string& name) const {
@@ -40,13 +42,13 @@ int Nodes::getNodeIndexExgnd(const std::string& name) const {
         printf("No nodes excluding ground\n");
         return 0;
     }
-    auto it = std::find(nodes.begin() + 1, nodes.end(), name);
-    if (it == nodes.end()) {
+    auto it = index.find(name);
+    if (it == index.end()) {
         qDebug() << "getNodeIndexExgnd(" << name.c_str() << ")";
         printf("Node not found\n");
         return 0;
     }
-    return std::distance(nodes.begin() + 1, it);
+    return it->second - 1;
 }
 
 int Nodes::getNodeNum() const {
@@ -291,6 +291,10 @@ void MainWindow::slotDebug() {
 
     circuit.printMNATemplate();
 
+    circuit.printBlockTriangular();
+
+    circuit.benchmarkSolvers();
+
     circuit.runSimulations();
 
     circuit.outputResults();
@@ -56,3 +56,7 @@ double DiodeModel::calcConductanceAtVoltage(double voltage) const {
     return (is * ELECTRON_CHARGE) / (n * BOLTZMANN_CONSTANT * temperature) *
            exp((ELECTRON_CHARGE * voltage) / (n * BOLTZMANN_CONSTANT * temperature));
 }
+
+double DiodeModel::getThermalVoltage() const {
+    return n * BOLTZMANN_CONSTANT * temperature / ELECTRON_CHARGE;
+}
@@ -1,10 +1,23 @@
 #include "Netlist.h"
 #include <QDebug>
+#include <algorithm>
+#include <cctype>
 
 Netlist::Netlist(const std::string& file, const std::string& title) {
     this->file_path = file;
     this->title = title;
 
+    // .OPTIONS 未指定时自动选择线性求解器
+    option_linear_solver = LINEAR_SOLVER_AUTO;
+    option_preconditioner = PRECOND_ILU0;
+    option_mixed_precision = false;
+    option_device_bypass = true;
+    option_condense_ports = false;
+    option_sweep_predictor = SWEEP_PREDICTOR_NONE;
+    option_sweep_threads = 0;
+    option_ac_transfer = AC_TRANSFER_OFF;
+    option_print_stats = false;
+
     /////// test only ////////
     Model* diode1 = new DiodeModel("diode1");
     models.push_back(diode1);
@@ -367,6 +380,14 @@ void Netlist::parseDC(int source_type,
                    [](unsigned char c) { return std::toupper(c); });
 
     analysis->analysis_type = ANALYSIS_DC;
+    analysis->linear_solver = option_linear_solver;
+    analysis->preconditioner = option_preconditioner;
+    analysis->condense_ports = option_condense_ports;
+    analysis->mixed_precision = option_mixed_precision;
+    analysis->device_bypass = option_device_bypass;
+    analysis->sweep_threads = option_sweep_threads;
+    analysis->print_stats = option_print_stats;
+    analysis->sweep_predictor = option_sweep_predictor;
     analysis->source_type = source_type;
     analysis->source_name = source_u;
     for (double iter = start; iter <= end; iter += increment) {
@@ -398,6 +419,14 @@ void Netlist::parseAC(int ac_type,
     Analysis* analysis = new Analysis();
 
     analysis->analysis_type = ANALYSIS_AC;
+    analysis->linear_solver = option_linear_solver;
+    analysis->preconditioner = option_preconditioner;
+    analysis->condense_ports = option_condense_ports;
+    analysis->mixed_precision = option_mixed_precision;
+    analysis->device_bypass = option_device_bypass;
+    analysis->sweep_threads = option_sweep_threads;
+    analysis->print_stats = option_print_stats;
+    analysis->ac_transfer = option_ac_transfer;
     analysis->sim_name = "frequency / Hz";
 
     // qDebug() << "parseAC() ac_type: " << ac_type;
@@ -445,6 +474,13 @@ void Netlist::parseTran(double step, double stop_time, double start_time) {
     Analysis* analysis = new Analysis();
 
     analysis->analysis_type = ANALYSIS_TRAN;
+    analysis->linear_solver = option_linear_solver;
+    analysis->preconditioner = option_preconditioner;
+    analysis->condense_ports = option_condense_ports;
+    analysis->mixed_precision = option_mixed_precision;
+    analysis->device_bypass = option_device_bypass;
+    analysis->sweep_threads = option_sweep_threads;
+    analysis->print_stats = option_print_stats;
     analysis->sim_name = "time / s";
     analysis->step = step;
 
@@ -455,6 +491,226 @@ void Netlist::parseTran(double step, double stop_time, double start_time) {
     analyses.push_back(analysis);
 }
 
+void Netlist::setLinearSolver(int analysis_type,
+                              int linear_solver,
+                              int preconditioner) {
+    for (Analysis* analysis : analyses) {
+        if (analysis->analysis_type == analysis_type) {
+            analysis->linear_solver = linear_solver;
+            analysis->preconditioner = preconditioner;
+        }
+    }
+}
+
+static std::string toUpper(const std::string& str) {
+    std::string result = str;
+    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+    return result;
+}
+
+static int parseLinearSolverName(const std::string& name) {
+    std::string upper = toUpper(name);
+    if (upper == "AUTO") {
+        return LINEAR_SOLVER_AUTO;
+    } else if (upper == "SPARSELU" || upper == "DIRECT" || upper == "KLU") {
+        return LINEAR_SOLVER_DIRECT;
+    } else if (upper == "GMRES") {
+        return LINEAR_SOLVER_GMRES;
+    } else if (upper == "BICGSTAB") {
+        return LINEAR_SOLVER_BICGSTAB;
+    } else if (upper == "DENSE" || upper == "LAPACK") {
+        return LINEAR_SOLVER_DENSE;
+    } else if (upper == "SUPERLU") {
+        return LINEAR_SOLVER_SUPERLU;
+    } else if (upper == "DOMAIN" || upper == "ND") {
+        return LINEAR_SOLVER_DOMAIN;
+    }
+    return -2;  // LINEAR_SOLVER_AUTO 为 -1
+}
+
+static int parsePreconditionerName(const std::string& name) {
+    std::string upper = toUpper(name);
+    if (upper == "NONE") {
+        return PRECOND_NONE;
+    } else if (upper == "ILU0") {
+        return PRECOND_ILU0;
+    } else if (upper == "ILUT") {
+        return PRECOND_ILUT;
+    }
+    return -1;
+}
+
+bool Netlist::parseOptionSolver(const std::string& name) {
+    int linear_solver = parseLinearSolverName(name);
+    if (linear_solver < LINEAR_SOLVER_AUTO) {
+        qDebug() << "parseOptionSolver() Unknown solver:" << name.c_str();
+        return false;
+    }
+    // .OPTIONS 可以出现在分析语句之前或之后，对已有和之后的分析都生效
+    option_linear_solver = linear_solver;
+    for (Analysis* analysis : analyses) {
+        analysis->linear_solver = linear_solver;
+    }
+    return true;
+}
+
+bool Netlist::parseOptionPrecond(const std::string& name) {
+    int preconditioner = parsePreconditionerName(name);
+    if (preconditioner < 0) {
+        qDebug() << "parseOptionPrecond() Unknown preconditioner:"
+                 << name.c_str();
+        return false;
+    }
+    option_preconditioner = preconditioner;
+    for (Analysis* analysis : analyses) {
+        analysis->preconditioner = preconditioner;
+    }
+    return true;
+}
+
+bool Netlist::parseOptionPrecision(const std::string& name) {
+    std::string upper = toUpper(name);
+    if (upper != "MIXED" && upper != "DOUBLE") {
+        qDebug() << "parseOptionPrecision() Unknown precision:"
+                 << name.c_str();
+        return false;
+    }
+    option_mixed_precision = upper == "MIXED";
+    for (Analysis* analysis : analyses) {
+        analysis->mixed_precision = option_mixed_precision;
+    }
+    return true;
+}
+
+bool Netlist::parseOptionBypass(const std::string& name) {
+    std::string upper = toUpper(name);
+    if (upper != "ON" && upper != "OFF") {
+        qDebug() << "parseOptionBypass() Unknown value:" << name.c_str();
+        return false;
+    }
+    option_device_bypass = upper == "ON";
+    for (Analysis* analysis : analyses) {
+        analysis->device_bypass = option_device_bypass;
+    }
+    return true;
+}
+
+bool Netlist::parseOptionPredictor(const std::string& name) {
+    std::string upper = toUpper(name);
+    int predictor;
+    if (upper == "NONE") {
+        predictor = SWEEP_PREDICTOR_NONE;
+    } else if (upper == "LINEAR") {
+        predictor = SWEEP_PREDICTOR_LINEAR;
+    } else if (upper == "QUADRATIC") {
+        predictor = SWEEP_PREDICTOR_QUADRATIC;
+    } else if (upper == "TANGENT") {
+        predictor = SWEEP_PREDICTOR_TANGENT;
+    } else {
+        qDebug() << "parseOptionPredictor() Unknown predictor:"
+                 << name.c_str();
+        return false;
+    }
+    setSweepPredictor(predictor);
+    return true;
+}
+
+bool Netlist::parseOptionTransfer(const std::string& name) {
+    std::string upper = toUpper(name);
+    int mode;
+    if (upper == "OFF") {
+        mode = AC_TRANSFER_OFF;
+    } else if (upper == "AUTO" || upper == "ON") {
+        mode = AC_TRANSFER_AUTO;
+    } else if (upper == "DIRECT") {
+        mode = AC_TRANSFER_DIRECT;
+    } else if (upper == "ADJOINT") {
+        mode = AC_TRANSFER_ADJOINT;
+    } else {
+        qDebug() << "parseOptionTransfer() Unknown transfer mode:"
+                 << name.c_str();
+        return false;
+    }
+    setACTransfer(mode);
+    return true;
+}
+
+void Netlist::setMixedPrecision(int analysis_type, bool enable) {
+    for (Analysis* analysis : analyses) {
+        if (analysis->analysis_type == analysis_type) {
+            analysis->mixed_precision = enable;
+        }
+    }
+}
+
+bool Netlist::parseOptionCondense(const std::string& name) {
+    std::string upper = toUpper(name);
+    if (upper != "ON" && upper != "OFF") {
+        qDebug() << "parseOptionCondense() Unknown value:" << name.c_str();
+        return false;
+    }
+    option_condense_ports = upper == "ON";
+    for (Analysis* analysis : analyses) {
+        analysis->condense_ports = option_condense_ports;
+    }
+    return true;
+}
+
+void Netlist::setPortCondensation(int analysis_type, bool enable) {
+    for (Analysis* analysis : analyses) {
+        if (analysis->analysis_type == analysis_type) {
+            analysis->condense_ports = enable;
+        }
+    }
+}
+
+void Netlist::setDeviceBypass(int analysis_type, bool enable) {
+    for (Analysis* analysis : analyses) {
+        if (analysis->analysis_type == analysis_type) {
+            analysis->device_bypass = enable;
+        }
+    }
+}
+
+void Netlist::setSweepPredictor(int predictor) {
+    option_sweep_predictor = predictor;
+    for (Analysis* analysis : analyses) {
+        analysis->sweep_predictor = predictor;
+    }
+}
+
+bool Netlist::parseOptionThreads(int num) {
+    if (num < 0) {
+        qDebug() << "parseOptionThreads() Invalid thread number:" << num;
+        return false;
+    }
+    setSweepThreads(num);
+    return true;
+}
+
+void Netlist::setSweepThreads(int num) {
+    option_sweep_threads = std::max(num, 0);
+    for (Analysis* analysis : analyses) {
+        analysis->sweep_threads = option_sweep_threads;
+    }
+}
+
+void Netlist::setACTransfer(int mode) {
+    option_ac_transfer = mode;
+    for (Analysis* analysis : analyses) {
+        if (analysis->analysis_type == ANALYSIS_AC) {
+            analysis->ac_transfer = mode;
+        }
+    }
+}
+
+void Netlist::setPrintStats(bool enable) {
+    option_print_stats = enable;
+    for (Analysis* analysis : analyses) {
+        analysis->print_stats = enable;
+    }
+}
+
 void Netlist::parsePrint(int analysis_type,
                          const std::vector<Variable>& var_list) {
     Output* output = new Output();
@@ -87,7 +87,11 @@ bison -v -d -o src/parser.cpp src/parser.yy
 
 %token TYPE_DEC TYPE_OCT TYPE_LIN
 
-%token OPTION_TYPE_NODE OPTION_TYPE_LIST
+%token OPTION_TYPE_NODE OPTION_TYPE_LIST OPTION_TYPE_SOLVER OPTION_TYPE_PRECOND OPTION_TYPE_PRECISION
+%token OPTION_TYPE_STATS OPTION_TYPE_BYPASS OPTION_TYPE_PREDICTOR OPTION_TYPE_THREADS
+%token OPTION_TYPE_TRANSFER OPTION_TYPE_CONDENSE
+
+%token<s> OPTION_VALUE_NAME
 
 %token VAR_TYPE_VOLTAGE_REAL VAR_TYPE_VOLTAGE_IMAG VAR_TYPE_VOLTAGE_MAG VAR_TYPE_VOLTAGE_PHASE VAR_TYPE_VOLTAGE_DB
 %token VAR_TYPE_CURRENT_REAL VAR_TYPE_CURRENT_IMAG VAR_TYPE_CURRENT_MAG VAR_TYPE_CURRENT_PHASE VAR_TYPE_CURRENT_DB
@@ -696,6 +700,33 @@ options: OPTION option_list
                 case TOKEN_OPTION_LIST:
                     printf("List, ");
                     break;
+                case TOKEN_OPTION_SOLVER:
+                    printf("Solver, ");
+                    break;
+                case TOKEN_OPTION_PRECOND:
+                    printf("Precond, ");
+                    break;
+                case TOKEN_OPTION_PRECISION:
+                    printf("Precision, ");
+                    break;
+                case TOKEN_OPTION_STATS:
+                    printf("Stats, ");
+                    break;
+                case TOKEN_OPTION_BYPASS:
+                    printf("Bypass, ");
+                    break;
+                case TOKEN_OPTION_PREDICTOR:
+                    printf("Predictor, ");
+                    break;
+                case TOKEN_OPTION_THREADS:
+                    printf("Threads, ");
+                    break;
+                case TOKEN_OPTION_TRANSFER:
+                    printf("Transfer, ");
+                    break;
+                case TOKEN_OPTION_CONDENSE:
+                    printf("Condense, ");
+                    break;
                 default:
                     printf("!No such option type\n");
             }
@@ -724,6 +755,51 @@ option: OPTION_TYPE_NODE
     {
         $$ = new Option{ TOKEN_OPTION_LIST, -1.0 };
     }
+    | OPTION_TYPE_SOLVER OPTION_VALUE_NAME
+    {
+        netlist->parseOptionSolver($2);
+        $$ = new Option{ TOKEN_OPTION_SOLVER, -1.0 };
+    }
+    | OPTION_TYPE_PRECOND OPTION_VALUE_NAME
+    {
+        netlist->parseOptionPrecond($2);
+        $$ = new Option{ TOKEN_OPTION_PRECOND, -1.0 };
+    }
+    | OPTION_TYPE_PRECISION OPTION_VALUE_NAME
+    {
+        netlist->parseOptionPrecision($2);
+        $$ = new Option{ TOKEN_OPTION_PRECISION, -1.0 };
+    }
+    | OPTION_TYPE_STATS
+    {
+        netlist->setPrintStats(true);
+        $$ = new Option{ TOKEN_OPTION_STATS, -1.0 };
+    }
+    | OPTION_TYPE_BYPASS OPTION_VALUE_NAME
+    {
+        netlist->parseOptionBypass($2);
+        $$ = new Option{ TOKEN_OPTION_BYPASS, -1.0 };
+    }
+    | OPTION_TYPE_PREDICTOR OPTION_VALUE_NAME
+    {
+        netlist->parseOptionPredictor($2);
+        $$ = new Option{ TOKEN_OPTION_PREDICTOR, -1.0 };
+    }
+    | OPTION_TYPE_THREADS INTEGER
+    {
+        netlist->parseOptionThreads($2);
+        $$ = new Option{ TOKEN_OPTION_THREADS, static_cast<double>($2) };
+    }
+    | OPTION_TYPE_TRANSFER OPTION_VALUE_NAME
+    {
+        netlist->parseOptionTransfer($2);
+        $$ = new Option{ TOKEN_OPTION_TRANSFER, -1.0 };
+    }
+    | OPTION_TYPE_CONDENSE OPTION_VALUE_NAME
+    {
+        netlist->parseOptionCondense($2);
+        $$ = new Option{ TOKEN_OPTION_CONDENSE, -1.0 };
+    }
 ;
 
 analysis_type: TYPE_OP
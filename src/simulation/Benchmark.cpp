@@ -0,0 +1,284 @@
+#include "Benchmark.h"
+#include <QDebug>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BlockLU.h"
+#include "DeviceTables.h"
+#include "DomainLU.h"
+#include "IterativeSolver.h"
+#include "Ordering.h"
+#include "SmallDenseLU.h"
+#include "SparseLU.h"
+#include "simd.h"
+#include "solvertype.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+static double residualNorm(const arma::sp_mat& A,
+                           const arma::vec& x,
+                           const arma::vec& b) {
+    if (x.n_elem != b.n_elem) {
+        return -1;
+    }
+    arma::vec r = A * x - b;
+    return arma::norm(r);
+}
+
+void benchmarkLinearSolvers(const arma::sp_mat& A,
+                            const arma::vec& b,
+                            int repeat) {
+    if (A.n_rows != A.n_cols || A.n_rows != b.n_elem || A.n_rows == 0) {
+        qDebug() << "benchmarkLinearSolvers() matrix size mismatch.";
+        return;
+    }
+    repeat = std::max(repeat, 1);
+
+    std::cout << std::endl;
+    std::cout << "-------------------------------" << std::endl
+              << "Benchmark: n = " << A.n_rows << ", nnz = " << A.n_nonzero
+              << ", repeat = " << repeat << std::endl;
+    std::printf("%-18s %12s %12s %10s %12s\n", "solver", "first/ms",
+                "per-solve/ms", "nnz(L+U)", "residual");
+
+    // arma::spsolve，每次都从头分解
+    {
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = arma::spsolve(x, A, b);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = arma::spsolve(x, A, b) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10s %12.3e%s\n", "arma::spsolve",
+                    first, per_solve, "-", residualNorm(A, x, b),
+                    status ? "" : " (failed)");
+    }
+
+    // SparseLU，第一次 analyze + factor，之后只 refactor
+    const int orderings[] = {ORDERING_NATURAL, ORDERING_AMD, ORDERING_COLAMD};
+    const char* names[] = {"SparseLU/natural", "SparseLU/AMD",
+                           "SparseLU/COLAMD"};
+    for (int k = 0; k < 3; k++) {
+        SparseLU lu;
+        lu.setOrdering(orderings[k]);
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = lu.factorize(A) && lu.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = lu.factorize(A) && lu.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n", names[k], first,
+                    per_solve, lu.getFactorNonzeroNum(),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+
+    // 按依赖层并行回代，强制开启，与串行回代的解比较
+    {
+        SparseLU serial;
+        serial.setThreadNum(1);
+        arma::vec x_serial;
+        bool serial_status = serial.factorize(A) && serial.solve(b, x_serial);
+
+        SparseLU lu;
+        lu.setThreadNum(std::max(2u, std::thread::hardware_concurrency()));
+        lu.setParallelSolveMinSize(0);
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = lu.factorize(A) && lu.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = lu.factorize(A) && lu.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        double diff = -1;
+        if (serial_status && x.n_elem == x_serial.n_elem) {
+            diff = arma::norm(x - x_serial) /
+                   std::max(arma::norm(x_serial), 1e-300);
+        }
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s"
+                    " (levels = %d, diff vs serial = %.3e)\n",
+                    "SparseLU/levels", first, per_solve,
+                    lu.getFactorNonzeroNum(), residualNorm(A, x, b),
+                    status ? "" : " (failed)", lu.getSolveLevelNum(), diff);
+    }
+
+    // BlockLU，先做 BTF，再逐块分解
+    {
+        BlockLU lu;
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = lu.factorize(A) && lu.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = lu.factorize(A) && lu.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n", "BlockLU/BTF",
+                    first, per_solve, lu.getFactorNonzeroNum(),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+
+    // DomainLU，嵌套剖分后各子区域并行分解，规模不够大时整体用 BlockLU
+    {
+        DomainLU lu;
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = lu.factorize(A) && lu.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = lu.factorize(A) && lu.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n",
+                    lu.isDecomposed() ? "DomainLU" : "DomainLU/whole",
+                    first, per_solve, lu.getFactorNonzeroNum(),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+
+    // 稠密 LU (LAPACK)，包括转换为稠密矩阵的开销；
+    // 规模较大时稠密矩阵放不进内存，不测
+    if (A.n_rows <= LINEAR_SOLVER_DENSE_DENSITY_SIZE) {
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = arma::solve(x, arma::mat(A), b);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = arma::solve(x, arma::mat(A), b) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n", "DenseLU/LAPACK",
+                    first, per_solve, static_cast<int>(A.n_rows * A.n_rows),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+
+    // 小规模时的定长稠密 LU，CPU 支持的每一级内核各测一次
+    for (int kernel = SIMD_KERNEL_SCALAR;
+         A.n_rows <= SMALL_DENSE_MAX_SIZE && kernel <= getSimdKernel();
+         kernel++) {
+        SmallDenseLU<double> lu;
+        lu.setKernel(kernel);
+        std::string name = std::string("SmallDenseLU/") + lu.getKernelName();
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = lu.factorize(A) && lu.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            status = lu.factorize(A) && lu.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n", name.c_str(),
+                    first, per_solve, static_cast<int>(A.n_rows * A.n_rows),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+
+    // 迭代法，预条件子只在第一次构造
+    const int methods[] = {LINEAR_SOLVER_GMRES, LINEAR_SOLVER_BICGSTAB};
+    const char* method_names[] = {"GMRES/ILU0", "BiCGSTAB/ILU0"};
+    for (int k = 0; k < 2; k++) {
+        IterativeSolver solver;
+        solver.setMethod(methods[k]);
+        solver.setPreconditioner(PRECOND_ILU0);
+        arma::vec x;
+        auto start = std::chrono::steady_clock::now();
+        bool status = solver.factorize(A) && solver.solve(b, x);
+        double first = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            x.zeros(b.n_elem);  // 不使用上一次的解作为初值
+            status = solver.factorize(A) && solver.solve(b, x) && status;
+        }
+        double per_solve = elapsedMs(start) / repeat;
+        std::printf("%-18s %12.4f %12.4f %10d %12.3e%s\n", method_names[k],
+                    first, per_solve, solver.getPreconditionerNonzeroNum(),
+                    residualNorm(A, x, b), status ? "" : " (failed)");
+    }
+    std::cout << "-------------------------------" << std::endl;
+}
+
+void benchmarkDiodeExp(int num, int repeat) {
+    repeat = std::max(repeat, 1);
+    // 均匀覆盖 [-750, 750]，末尾加上边界附近和特殊值：上溢 (> 709.78)、
+    // 结果为次正规数 (-745 .. -708.4)、完全下溢、+-inf、nan、+-0
+    std::vector<double> x;
+    for (int i = 0; i < num; i++) {
+        x.push_back(-750.0 + 1500.0 * i / std::max(num - 1, 1));
+    }
+    const double special[] = {709.782712893384,
+                              709.79,
+                              710.0,
+                              -708.396418532264,
+                              -708.4,
+                              -720.0,
+                              -745.0,
+                              -746.0,
+                              -1e5,
+                              1e5,
+                              HUGE_VAL,
+                              -HUGE_VAL,
+                              NAN,
+                              0.0,
+                              -0.0,
+                              1e-300};
+    x.insert(x.end(), std::begin(special), std::end(special));
+    int size = static_cast<int>(x.size());
+    std::vector<double> y(size);
+
+    std::cout << std::endl;
+    std::cout << "-------------------------------" << std::endl
+              << "Benchmark: exp, n = " << size << ", repeat = " << repeat
+              << std::endl;
+    std::printf("%-12s %12s %12s %10s %10s %10s\n", "kernel", "ns/exp",
+                "max rel err", "overflow", "underflow", "nan");
+    for (int kernel = SIMD_KERNEL_SCALAR; kernel <= getSimdKernel();
+         kernel++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; i++) {
+            DiodeTable::batchExp(kernel, size, x.data(), y.data());
+        }
+        double ns = elapsedMs(start) * 1e6 / repeat / size;
+
+        // 正规数结果比较相对误差；std::exp 为次正规数或 0 时内核可以取 0
+        double max_err = 0;
+        int over_bad = 0;
+        int under_bad = 0;
+        int nan_bad = 0;
+        for (int i = 0; i < size; i++) {
+            double ref = std::exp(x[i]);
+            if (std::isnan(ref)) {
+                nan_bad += std::isnan(y[i]) ? 0 : 1;
+            } else if (std::isinf(ref)) {
+                over_bad += y[i] == ref ? 0 : 1;
+            } else if (ref < DBL_MIN) {
+                under_bad += (y[i] == 0 || y[i] == ref) ? 0 : 1;
+            } else {
+                max_err = std::max(max_err, std::fabs(y[i] - ref) / ref);
+            }
+        }
+        std::printf("%-12s %12.3f %12.3e %10s %10s %10s\n",
+                    getSimdKernelName(kernel), ns, max_err,
+                    over_bad ? "FAILED" : "ok", under_bad ? "FAILED" : "ok",
+                    nan_bad ? "FAILED" : "ok");
+    }
+    std::cout << "-------------------------------" << std::endl;
+}
@@ -0,0 +1,374 @@
+#include "BlockLU.h"
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
+#include "Ordering.h"
+
+BlockLU::BlockLU()
+    : factored(false),
+      n(0),
+      ordering(ORDERING_AMD),
+      pivot_tol(0.1),
+      parallel_min_size(1000),
+      analyze_count(0),
+      factorize_count(0) {
+    thread_num = std::max(1u, std::thread::hardware_concurrency());
+}
+
+BlockLU::~BlockLU() {}
+
+void BlockLU::setStructure(const BlockTriangular& btf_) {
+    btf = btf_;
+    // 清空已有的分块，下一次 factorize 时按新的结构重新建立
+    Ap.clear();
+    Ai.clear();
+    factored = false;
+}
+
+void BlockLU::setOrdering(int method) {
+    ordering = method;
+    for (SparseLU& lu : block_lu) {
+        lu.setOrdering(method);
+    }
+}
+
+void BlockLU::setPivotTolerance(double tol) {
+    pivot_tol = tol;
+    for (SparseLU& lu : block_lu) {
+        lu.setPivotTolerance(tol);
+    }
+}
+
+void BlockLU::setThreadNum(int num) {
+    thread_num = std::max(num, 1);
+    for (SparseLU& lu : block_lu) {
+        lu.setThreadNum(thread_num);
+    }
+}
+
+void BlockLU::setParallelMinSize(int size) {
+    parallel_min_size = size;
+}
+
+bool BlockLU::loadValues(const arma::sp_mat& A) {
+    if (Ap.empty() || static_cast<int>(A.n_cols) != n ||
+        static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_nonzero) != static_cast<int>(Ai.size())) {
+        return false;
+    }
+    int p = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int col = static_cast<int>(it.col());
+        if (Ai[p] != static_cast<int>(it.row()) || p < Ap[col] ||
+            p >= Ap[col + 1]) {
+            return false;
+        }
+        int blk = dest_block[p];
+        if (blk < 0) {
+            off_val[dest_slot[p]] = (*it);
+        } else if (btf.getBlockSize(blk) == 1) {
+            block_diag[blk] = (*it);
+        } else {
+            block_values[blk][dest_slot[p]] = (*it);
+        }
+        p++;
+    }
+    return true;
+}
+
+void BlockLU::buildBlocks(const arma::sp_mat& A) {
+    n = static_cast<int>(A.n_cols);
+    int nnz = static_cast<int>(A.n_nonzero);
+    int block_num = btf.getBlockNum();
+    const std::vector<int>& pinv = btf.getRowPos();
+    const std::vector<int>& qinv = btf.getColPos();
+
+    Ap.assign(n + 1, 0);
+    Ai.clear();
+    Ai.reserve(nnz);
+    dest_block.assign(nnz, -1);
+    dest_slot.assign(nnz, -1);
+
+    // (块, 块内列, 块内行, k) 和 (排列后的行, 排列后的列, k)
+    std::vector<std::tuple<int, int, int, int>> inner;
+    std::vector<std::tuple<int, int, int>> outer;
+    int k = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+        int row = pinv[it.row()];
+        int col = qinv[it.col()];
+        int blk = btf.getBlockOf(row);
+        if (blk == btf.getBlockOf(col)) {
+            int start = btf.getBlockStart(blk);
+            inner.push_back(std::make_tuple(blk, col - start, row - start, k));
+        } else {
+            outer.push_back(std::make_tuple(row, col, k));
+        }
+        k++;
+    }
+    for (int col = 0; col < n; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+
+    // 对角块：逐块生成固定结构的 CSC 矩阵
+    std::sort(inner.begin(), inner.end());
+    block_mat.assign(block_num, arma::sp_mat());
+    block_values.assign(block_num, nullptr);
+    block_diag.assign(block_num, 0);
+    block_lu.assign(block_num, SparseLU());
+    block_b.assign(block_num, arma::vec());
+    block_x.assign(block_num, arma::vec());
+    block_status.assign(block_num, 0);
+    std::size_t pos = 0;
+    for (int blk = 0; blk < block_num; blk++) {
+        int size = btf.getBlockSize(blk);
+        std::size_t first = pos;
+        while (pos < inner.size() && std::get<0>(inner[pos]) == blk) {
+            pos++;
+        }
+        if (size == 1) {
+            for (std::size_t t = first; t < pos; t++) {
+                dest_block[std::get<3>(inner[t])] = blk;
+                dest_slot[std::get<3>(inner[t])] = 0;
+            }
+            continue;
+        }
+        int block_nnz = static_cast<int>(pos - first);
+        arma::uvec rowind(block_nnz);
+        arma::uvec colptr(size + 1, arma::fill::zeros);
+        for (std::size_t t = first; t < pos; t++) {
+            int slot = static_cast<int>(t - first);
+            rowind(slot) = std::get<2>(inner[t]);
+            colptr(std::get<1>(inner[t]) + 1)++;
+            dest_block[std::get<3>(inner[t])] = blk;
+            dest_slot[std::get<3>(inner[t])] = slot;
+        }
+        for (int col = 0; col < size; col++) {
+            colptr(col + 1) += colptr(col);
+        }
+        block_mat[blk] = arma::sp_mat(rowind, colptr,
+                                      arma::zeros<arma::vec>(block_nnz), size,
+                                      size, false);
+        block_lu[blk].setOrdering(ordering);
+        block_lu[blk].setPivotTolerance(pivot_tol);
+        block_lu[blk].setThreadNum(thread_num);
+        block_b[blk].zeros(size);
+    }
+    // block_mat 不再改变大小，此后数值数组的地址固定
+    for (int blk = 0; blk < block_num; blk++) {
+        if (btf.getBlockSize(blk) > 1) {
+            block_values[blk] = arma::access::rwp(block_mat[blk].values);
+        }
+    }
+
+    // 块外的非零元
+    std::sort(outer.begin(), outer.end());
+    off_ptr.assign(n + 1, 0);
+    off_col.resize(outer.size());
+    off_val.assign(outer.size(), 0);
+    for (std::size_t t = 0; t < outer.size(); t++) {
+        off_ptr[std::get<0>(outer[t]) + 1]++;
+        off_col[t] = std::get<1>(outer[t]);
+        dest_slot[std::get<2>(outer[t])] = static_cast<int>(t);
+    }
+    for (int row = 0; row < n; row++) {
+        off_ptr[row + 1] += off_ptr[row];
+    }
+
+    work_b.assign(n, 0);
+    work_x.assign(n, 0);
+    buildLevels();
+}
+
+void BlockLU::buildLevels() {
+    // 第 blk 块依赖块外非零元所在列的块，它们的编号都比 blk 大
+    int block_num = btf.getBlockNum();
+    std::vector<int> level(block_num, 0);
+    int max_level = 0;
+    for (int blk = block_num - 1; blk >= 0; blk--) {
+        int start = btf.getBlockStart(blk);
+        int stop = start + btf.getBlockSize(blk);
+        for (int ptr = off_ptr[start]; ptr < off_ptr[stop]; ptr++) {
+            int dep = btf.getBlockOf(off_col[ptr]);
+            level[blk] = std::max(level[blk], level[dep] + 1);
+        }
+        max_level = std::max(max_level, level[blk]);
+    }
+    levels.assign(block_num > 0 ? max_level + 1 : 0, std::vector<int>());
+    for (int blk = 0; blk < block_num; blk++) {
+        levels[level[blk]].push_back(blk);
+    }
+}
+
+void BlockLU::runBlocks(const std::vector<int>& blocks,
+                        const std::function<void(int)>& func) const {
+    int work = 0;
+    for (int blk : blocks) {
+        work += btf.getBlockSize(blk);
+    }
+    int threads = std::min(thread_num, static_cast<int>(blocks.size()));
+    if (threads <= 1 || work < parallel_min_size) {
+        for (int blk : blocks) {
+            func(blk);
+        }
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            int k = next++;
+            if (k >= static_cast<int>(blocks.size())) {
+                break;
+            }
+            func(blocks[k]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+bool BlockLU::factorize(const arma::sp_mat& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "BlockLU::factorize() matrix is not square.";
+        return false;
+    }
+    if (!loadValues(A)) {
+        // 结构变化，已有的分块不再适用时重新计算 BTF
+        if (!btf.fits(A)) {
+            btf.analyze(A);
+            analyze_count++;
+        }
+        buildBlocks(A);
+        loadValues(A);
+    }
+
+    factorize_count++;
+
+    // 对角块之间没有依赖，可以同时分解
+    std::vector<int> blocks(btf.getBlockNum());
+    for (int blk = 0; blk < btf.getBlockNum(); blk++) {
+        blocks[blk] = blk;
+    }
+    runBlocks(blocks, [this](int blk) { block_status[blk] = factorBlock(blk); });
+
+    factored = std::all_of(block_status.begin(), block_status.end(),
+                           [](char status) { return status != 0; });
+    return factored;
+}
+
+bool BlockLU::factorBlock(int blk) {
+    if (btf.getBlockSize(blk) == 1) {
+        return block_diag[blk] != 0;
+    }
+    return block_lu[blk].factorize(block_mat[blk]);
+}
+
+bool BlockLU::solveBlock(int blk) const {
+    int start = btf.getBlockStart(blk);
+    int size = btf.getBlockSize(blk);
+
+    // b_k - sum_{j > k} C_kj x_j
+    for (int row = start; row < start + size; row++) {
+        double sum = work_b[row];
+        for (int ptr = off_ptr[row]; ptr < off_ptr[row + 1]; ptr++) {
+            sum -= off_val[ptr] * work_x[off_col[ptr]];
+        }
+        work_b[row] = sum;
+    }
+
+    if (size == 1) {
+        work_x[start] = work_b[start] / block_diag[blk];
+        return true;
+    }
+    arma::vec& b = block_b[blk];
+    arma::vec& x = block_x[blk];
+    for (int i = 0; i < size; i++) {
+        b(i) = work_b[start + i];
+    }
+    if (!block_lu[blk].solve(b, x)) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        work_x[start + i] = x(i);
+    }
+    return true;
+}
+
+bool BlockLU::solve(const arma::vec& b, arma::vec& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        qDebug() << "BlockLU::solve() not factored or size mismatch.";
+        return false;
+    }
+    const std::vector<int>& p = btf.getRowPerm();
+    const std::vector<int>& q = btf.getColPerm();
+    for (int k = 0; k < n; k++) {
+        work_b[k] = b(p[k]);
+    }
+
+    // 逐层回代，同一层的块互不依赖
+    std::fill(block_status.begin(), block_status.end(), 1);
+    for (const std::vector<int>& level : levels) {
+        runBlocks(level,
+                  [this](int blk) { block_status[blk] = solveBlock(blk); });
+    }
+    if (!std::all_of(block_status.begin(), block_status.end(),
+                     [](char status) { return status != 0; })) {
+        return false;
+    }
+
+    x.set_size(n);
+    for (int k = 0; k < n; k++) {
+        x(q[k]) = work_x[k];
+    }
+    return true;
+}
+
+int BlockLU::getFactorNonzeroNum() const {
+    int nnz = static_cast<int>(off_val.size());
+    for (int blk = 0; blk < btf.getBlockNum(); blk++) {
+        if (btf.getBlockSize(blk) == 1) {
+            nnz++;
+        } else {
+            nnz += block_lu[blk].getFactorNonzeroNum();
+        }
+    }
+    return nnz;
+}
+
+int BlockLU::getFactorCount() const {
+    int count = 0;
+    for (const SparseLU& lu : block_lu) {
+        count += lu.getFactorCount();
+    }
+    return count;
+}
+
+int BlockLU::getRefactorCount() const {
+    int count = 0;
+    for (const SparseLU& lu : block_lu) {
+        count += lu.getRefactorCount();
+    }
+    return count;
+}
+
+void BlockLU::printStats() const {
+    std::cout << "BlockLU: n = " << n << ", blocks = " << btf.getBlockNum()
+              << ", max block = " << btf.getMaxBlockSize()
+              << ", levels = " << levels.size()
+              << ", nnz(off) = " << off_val.size()
+              << ", nnz(L+U) = " << getFactorNonzeroNum()
+              << ", btf = " << analyze_count
+              << ", factorize = " << factorize_count
+              << ", factor = " << getFactorCount()
+              << ", refactor = " << getRefactorCount() << std::endl;
+}
@@ -0,0 +1,292 @@
+#include "BlockTriangular.h"
+#include <QDebug>
+#include <algorithm>
+
+BlockTriangular::BlockTriangular()
+    : analyzed(false), n(0), structural_rank(0) {}
+
+BlockTriangular::~BlockTriangular() {}
+
+bool BlockTriangular::analyze(const arma::sp_mat& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "BlockTriangular::analyze() matrix is not square.";
+        return false;
+    }
+    int size = static_cast<int>(A.n_cols);
+    std::vector<int> Ap(size + 1, 0);
+    std::vector<int> Ai;
+    Ai.reserve(A.n_nonzero);
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+    }
+    for (int col = 0; col < size; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+    return analyze(size, Ap, Ai);
+}
+
+bool BlockTriangular::analyze(int n_,
+                              const std::vector<int>& Ap,
+                              const std::vector<int>& Ai) {
+    n = n_;
+    analyzed = false;
+
+    std::vector<int> row_match;
+    structural_rank = maxTransversal(Ap, Ai, row_match);
+    if (structural_rank < n) {
+        // 结构奇异，无法得到零自由对角，整体作为一个块
+        qDebug() << "BlockTriangular::analyze() structurally singular, rank:"
+                 << structural_rank << "of" << n;
+        setSingleBlock();
+        analyzed = true;
+        return false;
+    }
+
+    stronglyConnected(Ap, Ai, row_match);
+
+    pinv.assign(n, 0);
+    qinv.assign(n, 0);
+    for (int k = 0; k < n; k++) {
+        pinv[p[k]] = k;
+        qinv[q[k]] = k;
+    }
+    block_of.assign(n, 0);
+    for (int b = 0; b < getBlockNum(); b++) {
+        for (int k = r[b]; k < r[b + 1]; k++) {
+            block_of[k] = b;
+        }
+    }
+    analyzed = true;
+    return true;
+}
+
+int BlockTriangular::transversal(int n_,
+                                 const std::vector<int>& Ap,
+                                 const std::vector<int>& Ai,
+                                 std::vector<int>& row_match) {
+    n = n_;
+    analyzed = false;
+    structural_rank = maxTransversal(Ap, Ai, row_match);
+    return structural_rank;
+}
+
+int BlockTriangular::maxTransversal(const std::vector<int>& Ap,
+                                    const std::vector<int>& Ai,
+                                    std::vector<int>& row_match) {
+    // 增广路径法求二部图最大匹配，row_match[i] 为与行 i 匹配的列
+    row_match.assign(n, -1);
+    std::vector<int> col_match(n, -1);
+    int rank = 0;
+
+    // 先匹配对角元，保持节点方程原来的顺序，否则对角块的结构不再对称，
+    // 块内 AMD 排序的填充会大很多
+    for (int col = 0; col < n; col++) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (Ai[ptr] == col) {
+                row_match[col] = col;
+                col_match[col] = col;
+                rank++;
+                break;
+            }
+        }
+    }
+
+    // 再做一遍贪心匹配，大部分列在这里就能匹配上
+    for (int col = 0; col < n; col++) {
+        if (col_match[col] >= 0) {
+            continue;
+        }
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            int row = Ai[ptr];
+            if (row_match[row] < 0) {
+                row_match[row] = col;
+                col_match[col] = row;
+                rank++;
+                break;
+            }
+        }
+    }
+
+    // 入栈时先找未匹配的行，使增广路径尽量短（支路变量只绕到相邻节点）
+    auto cheap = [&](int col) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (row_match[Ai[ptr]] < 0) {
+                return Ai[ptr];
+            }
+        }
+        return -1;
+    };
+
+    // 非递归 DFS，col_stack 中保存当前的增广路径
+    std::vector<int> visited(n, -1);
+    std::vector<int> pos(n, 0);
+    std::vector<int> col_stack;
+    col_stack.reserve(n);
+    for (int start = 0; start < n; start++) {
+        if (col_match[start] >= 0) {
+            continue;
+        }
+        col_stack.clear();
+        col_stack.push_back(start);
+        pos[start] = Ap[start];
+        int found = cheap(start);
+        while (!col_stack.empty() && found < 0) {
+            int col = col_stack.back();
+            if (pos[col] >= Ap[col + 1]) {
+                col_stack.pop_back();
+                continue;
+            }
+            int row = Ai[pos[col]++];
+            if (visited[row] == start) {
+                continue;
+            }
+            visited[row] = start;
+            int next = row_match[row];
+            pos[next] = Ap[next];
+            col_stack.push_back(next);
+            found = cheap(next);
+        }
+        if (found < 0) {
+            continue;  // 该列无法匹配，结构奇异
+        }
+        // 沿路径翻转匹配
+        int row = found;
+        for (int k = static_cast<int>(col_stack.size()) - 1; k >= 0; k--) {
+            int col = col_stack[k];
+            int prev_row = col_match[col];
+            col_match[col] = row;
+            row_match[row] = col;
+            row = prev_row;
+        }
+        rank++;
+    }
+    return rank;
+}
+
+void BlockTriangular::stronglyConnected(const std::vector<int>& Ap,
+                                        const std::vector<int>& Ai,
+                                        const std::vector<int>& row_match) {
+    /**
+     * 顶点为列 j，对 A(i, j) != 0 连边 j -> row_match[i]，
+     * 表示与行 i 匹配的那一列所在的块要用到 x_j。
+     * Tarjan 算法按逆拓扑序输出强连通分量：使用 x_j 的块先输出，
+     * 恰好就是块上三角的顺序（前面的块依赖后面的块）。
+     */
+    std::vector<int> index(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<int> pos(n, 0);
+    std::vector<char> on_stack(n, 0);
+    std::vector<int> scc_stack;
+    std::vector<int> call_stack;
+    scc_stack.reserve(n);
+    call_stack.reserve(n);
+
+    p.clear();
+    q.clear();
+    r.assign(1, 0);
+    int counter = 0;
+    for (int start = 0; start < n; start++) {
+        if (index[start] >= 0) {
+            continue;
+        }
+        index[start] = low[start] = counter++;
+        pos[start] = Ap[start];
+        scc_stack.push_back(start);
+        on_stack[start] = 1;
+        call_stack.push_back(start);
+
+        while (!call_stack.empty()) {
+            int v = call_stack.back();
+            if (pos[v] < Ap[v + 1]) {
+                int w = row_match[Ai[pos[v]++]];
+                if (w == v) {
+                    continue;
+                }
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    pos[w] = Ap[w];
+                    scc_stack.push_back(w);
+                    on_stack[w] = 1;
+                    call_stack.push_back(w);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                int u = call_stack.back();
+                low[u] = std::min(low[u], low[v]);
+            }
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = scc_stack.back();
+                    scc_stack.pop_back();
+                    on_stack[w] = 0;
+                    q.push_back(w);
+                } while (w != v);
+                r.push_back(static_cast<int>(q.size()));
+            }
+        }
+    }
+
+    // 行排列：与第 k 列匹配的行
+    std::vector<int> col_match(n, -1);
+    for (int row = 0; row < n; row++) {
+        col_match[row_match[row]] = row;
+    }
+    p.resize(n);
+    for (int k = 0; k < n; k++) {
+        p[k] = col_match[q[k]];
+    }
+}
+
+void BlockTriangular::setSingleBlock() {
+    p.resize(n);
+    q.resize(n);
+    pinv.resize(n);
+    qinv.resize(n);
+    for (int k = 0; k < n; k++) {
+        p[k] = q[k] = pinv[k] = qinv[k] = k;
+    }
+    r.assign(1, 0);
+    r.push_back(n);
+    block_of.assign(n, 0);
+}
+
+bool BlockTriangular::fits(const arma::sp_mat& A) const {
+    if (!analyzed || static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_cols) != n) {
+        return false;
+    }
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        if (block_of[pinv[it.row()]] > block_of[qinv[it.col()]]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int BlockTriangular::getMaxBlockSize() const {
+    int max_size = 0;
+    for (int b = 0; b < getBlockNum(); b++) {
+        max_size = std::max(max_size, getBlockSize(b));
+    }
+    return max_size;
+}
+
+void BlockTriangular::printBlocks() const {
+    int singletons = 0;
+    for (int b = 0; b < getBlockNum(); b++) {
+        if (getBlockSize(b) == 1) {
+            singletons++;
+        }
+    }
+    std::cout << "BTF: n = " << n << ", blocks = " << getBlockNum()
+              << ", singletons = " << singletons
+              << ", max block = " << getMaxBlockSize()
+              << ", structural rank = " << structural_rank << std::endl;
+}
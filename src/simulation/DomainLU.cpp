@@ -0,0 +1,563 @@
+#include "DomainLU.h"
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
+
+DomainLU::DomainLU()
+    : factored(false),
+      use_whole(true),
+      n(0),
+      schur_values(nullptr),
+      analyze_count(0),
+      factorize_count(0),
+      fallback_count(0) {
+    thread_num = std::max(1u, std::thread::hardware_concurrency());
+    domain_num = thread_num;
+    schur_lu.setThreadNum(thread_num);
+    whole.setThreadNum(thread_num);
+}
+
+DomainLU::~DomainLU() {}
+
+void DomainLU::setStructure(const NestedDissection& nd_) {
+    nd = nd_;
+    // 清空已有的子区域，下一次 factorize 时按新的划分重新建立
+    Ap.clear();
+    Ai.clear();
+    factored = false;
+}
+
+void DomainLU::setThreadNum(int num) {
+    thread_num = std::max(num, 1);
+    schur_lu.setThreadNum(thread_num);
+    whole.setThreadNum(thread_num);
+}
+
+void DomainLU::setDomainNum(int num) {
+    domain_num = num;
+}
+
+bool DomainLU::loadValues(const arma::sp_mat& A) {
+    if (Ap.empty() || static_cast<int>(A.n_cols) != n ||
+        static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_nonzero) != static_cast<int>(Ai.size())) {
+        return false;
+    }
+    int p = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int col = static_cast<int>(it.col());
+        if (Ai[p] != static_cast<int>(it.row()) || p < Ap[col] ||
+            p >= Ap[col + 1]) {
+            return false;
+        }
+        p++;
+    }
+    if (use_whole) {
+        return true;  // 数值直接交给 BlockLU
+    }
+    p = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int slot = dest_slot[p];
+        switch (dest_kind[p]) {
+            case DEST_INTERIOR:
+                domains[dest_domain[p]].values[slot] = (*it);
+                break;
+            case DEST_DOMAIN_SEP:
+                domains[dest_domain[p]].ds_val[slot] = (*it);
+                break;
+            case DEST_SEP_DOMAIN:
+                domains[dest_domain[p]].sd_val[slot] = (*it);
+                break;
+            default:
+                schur_base[slot] = (*it);
+        }
+        p++;
+    }
+    return true;
+}
+
+// 由 (列, 行, k) 三元组（已排序）生成 CSC 结构，k 处的非零元写到 slot
+static void buildCSC(const std::vector<std::tuple<int, int, int>>& entries,
+                     int n_cols,
+                     std::vector<int>& ptr,
+                     std::vector<int>& row,
+                     std::vector<int>& dest_slot) {
+    ptr.assign(n_cols + 1, 0);
+    row.resize(entries.size());
+    for (std::size_t t = 0; t < entries.size(); t++) {
+        ptr[std::get<0>(entries[t]) + 1]++;
+        row[t] = std::get<1>(entries[t]);
+        dest_slot[std::get<2>(entries[t])] = static_cast<int>(t);
+    }
+    for (int col = 0; col < n_cols; col++) {
+        ptr[col + 1] += ptr[col];
+    }
+}
+
+void DomainLU::loadPattern(const arma::sp_mat& A) {
+    n = static_cast<int>(A.n_cols);
+    Ap.assign(n + 1, 0);
+    Ai.clear();
+    Ai.reserve(A.n_nonzero);
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+    }
+    for (int col = 0; col < n; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+}
+
+void DomainLU::buildDomains(const arma::sp_mat& A) {
+    int nnz = static_cast<int>(A.n_nonzero);
+    int dn = nd.getDomainNum();
+    int sep_start = nd.getSeparatorStart();
+    int sep_size = nd.getSeparatorSize();
+    const std::vector<int>& pos = nd.getPos();
+
+    dest_kind.assign(nnz, DEST_SEP);
+    dest_domain.assign(nnz, -1);
+    dest_slot.assign(nnz, -1);
+
+    // 按种类和子区域分开，行列均为局部编号：
+    // 子区域内 / A_dS / A_Sd 为 (d, 列, 行, k)，A_SS 为 (列, 行, k)
+    std::vector<std::tuple<int, int, int, int>> inner;
+    std::vector<std::tuple<int, int, int, int>> to_sep;
+    std::vector<std::tuple<int, int, int, int>> from_sep;
+    std::vector<std::tuple<int, int, int>> sep;
+    std::vector<std::vector<int>> boundary(dn);
+    int k = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int d_row = nd.getDomainOf(it.row());
+        int d_col = nd.getDomainOf(it.col());
+        int row = pos[it.row()];
+        int col = pos[it.col()];
+        if (d_row >= 0 && d_col >= 0) {
+            int start = nd.getDomainStart(d_row);
+            inner.push_back(
+                std::make_tuple(d_row, col - start, row - start, k));
+        } else if (d_row >= 0) {
+            to_sep.push_back(std::make_tuple(
+                d_row, col - sep_start, row - nd.getDomainStart(d_row), k));
+            boundary[d_row].push_back(col - sep_start);
+        } else if (d_col >= 0) {
+            from_sep.push_back(std::make_tuple(
+                d_col, col - nd.getDomainStart(d_col), row - sep_start, k));
+            boundary[d_col].push_back(row - sep_start);
+        } else {
+            sep.push_back(
+                std::make_tuple(col - sep_start, row - sep_start, k));
+        }
+        k++;
+    }
+    std::sort(inner.begin(), inner.end());
+    std::sort(to_sep.begin(), to_sep.end());
+    std::sort(from_sep.begin(), from_sep.end());
+    std::sort(sep.begin(), sep.end());
+
+    // S 的结构：A_SS 加上各子区域边界上的稠密块
+    std::vector<std::pair<int, int>> schur_entries;
+    for (const auto& entry : sep) {
+        schur_entries.push_back(
+            std::make_pair(std::get<0>(entry), std::get<1>(entry)));
+    }
+    for (int d = 0; d < dn; d++) {
+        std::vector<int>& bnd = boundary[d];
+        std::sort(bnd.begin(), bnd.end());
+        bnd.erase(std::unique(bnd.begin(), bnd.end()), bnd.end());
+        for (int col : bnd) {
+            for (int row : bnd) {
+                schur_entries.push_back(std::make_pair(col, row));
+            }
+        }
+    }
+    std::sort(schur_entries.begin(), schur_entries.end());
+    schur_entries.erase(
+        std::unique(schur_entries.begin(), schur_entries.end()),
+        schur_entries.end());
+    int schur_nnz = static_cast<int>(schur_entries.size());
+    arma::uvec rowind(schur_nnz);
+    arma::uvec colptr(sep_size + 1, arma::fill::zeros);
+    for (int t = 0; t < schur_nnz; t++) {
+        rowind(t) = schur_entries[t].second;
+        colptr(schur_entries[t].first + 1)++;
+    }
+    for (int col = 0; col < sep_size; col++) {
+        colptr(col + 1) += colptr(col);
+    }
+    schur_mat = arma::sp_mat(rowind, colptr, arma::zeros<arma::vec>(schur_nnz),
+                             sep_size, sep_size, false);
+    schur_values = arma::access::rwp(schur_mat.values);
+    schur_base.assign(schur_nnz, 0);
+    auto schurSlot = [&](int col, int row) {
+        return static_cast<int>(
+            std::lower_bound(schur_entries.begin(), schur_entries.end(),
+                             std::make_pair(col, row)) -
+            schur_entries.begin());
+    };
+    for (const auto& entry : sep) {
+        dest_slot[std::get<2>(entry)] =
+            schurSlot(std::get<0>(entry), std::get<1>(entry));
+    }
+
+    // 各子区域
+    domains.assign(dn, Domain());
+    std::size_t inner_pos = 0;
+    std::size_t to_pos = 0;
+    std::size_t from_pos = 0;
+    std::vector<std::tuple<int, int, int>> local;
+    for (int d = 0; d < dn; d++) {
+        Domain& dom = domains[d];
+        int size = nd.getDomainSize(d);
+        dom.boundary = boundary[d];
+        int nb = static_cast<int>(dom.boundary.size());
+
+        // A_dd
+        local.clear();
+        for (; inner_pos < inner.size() && std::get<0>(inner[inner_pos]) == d;
+             inner_pos++) {
+            const auto& entry = inner[inner_pos];
+            local.push_back(std::make_tuple(
+                std::get<1>(entry), std::get<2>(entry), std::get<3>(entry)));
+            dest_kind[std::get<3>(entry)] = DEST_INTERIOR;
+            dest_domain[std::get<3>(entry)] = d;
+        }
+        std::vector<int> ptr;
+        std::vector<int> row;
+        buildCSC(local, size, ptr, row, dest_slot);
+        arma::uvec mat_rowind(row.size());
+        arma::uvec mat_colptr(size + 1);
+        for (std::size_t t = 0; t < row.size(); t++) {
+            mat_rowind(t) = row[t];
+        }
+        for (int col = 0; col <= size; col++) {
+            mat_colptr(col) = ptr[col];
+        }
+        dom.mat = arma::sp_mat(mat_rowind, mat_colptr,
+                               arma::zeros<arma::vec>(row.size()), size, size,
+                               false);
+        dom.lu.setThreadNum(1);  // 并行在子区域之间
+
+        // A_dS，列换成边界编号
+        local.clear();
+        for (; to_pos < to_sep.size() && std::get<0>(to_sep[to_pos]) == d;
+             to_pos++) {
+            const auto& entry = to_sep[to_pos];
+            int col = static_cast<int>(
+                std::lower_bound(dom.boundary.begin(), dom.boundary.end(),
+                                 std::get<1>(entry)) -
+                dom.boundary.begin());
+            local.push_back(std::make_tuple(col, std::get<2>(entry),
+                                            std::get<3>(entry)));
+            dest_kind[std::get<3>(entry)] = DEST_DOMAIN_SEP;
+            dest_domain[std::get<3>(entry)] = d;
+        }
+        std::sort(local.begin(), local.end());
+        buildCSC(local, nb, dom.ds_ptr, dom.ds_row, dest_slot);
+        dom.ds_val.assign(local.size(), 0);
+
+        // A_Sd，行换成边界编号
+        local.clear();
+        for (; from_pos < from_sep.size() &&
+               std::get<0>(from_sep[from_pos]) == d;
+             from_pos++) {
+            const auto& entry = from_sep[from_pos];
+            int brow = static_cast<int>(
+                std::lower_bound(dom.boundary.begin(), dom.boundary.end(),
+                                 std::get<2>(entry)) -
+                dom.boundary.begin());
+            local.push_back(std::make_tuple(std::get<1>(entry), brow,
+                                            std::get<3>(entry)));
+            dest_kind[std::get<3>(entry)] = DEST_SEP_DOMAIN;
+            dest_domain[std::get<3>(entry)] = d;
+        }
+        std::sort(local.begin(), local.end());
+        buildCSC(local, size, dom.sd_ptr, dom.sd_row, dest_slot);
+        dom.sd_val.assign(local.size(), 0);
+
+        dom.schur.assign(nb * nb, 0);
+        dom.schur_slot.assign(nb * nb, 0);
+        for (int bj = 0; bj < nb; bj++) {
+            for (int bi = 0; bi < nb; bi++) {
+                dom.schur_slot[bj * nb + bi] =
+                    schurSlot(dom.boundary[bj], dom.boundary[bi]);
+            }
+        }
+        dom.work_b.zeros(size);
+        dom.work_s.assign(nb, 0);
+        dom.status = false;
+    }
+    // domains 不再改变大小，此后数值数组的地址固定
+    for (Domain& dom : domains) {
+        dom.values = arma::access::rwp(dom.mat.values);
+    }
+
+    work_b.assign(n, 0);
+    work_x.assign(n, 0);
+    sep_b.zeros(sep_size);
+}
+
+void DomainLU::runDomains(const std::function<void(int)>& func) const {
+    int dn = static_cast<int>(domains.size());
+    int threads = std::min(thread_num, dn);
+    if (threads <= 1) {
+        for (int d = 0; d < dn; d++) {
+            func(d);
+        }
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            int d = next++;
+            if (d >= dn) {
+                break;
+            }
+            func(d);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+bool DomainLU::factorDomain(int d) {
+    Domain& dom = domains[d];
+    int size = nd.getDomainSize(d);
+    int nb = static_cast<int>(dom.boundary.size());
+    std::fill(dom.schur.begin(), dom.schur.end(), 0);
+    if (size == 0) {
+        return true;
+    }
+    dom.work_b.zeros(size);
+    if (!dom.lu.factorize(dom.mat)) {
+        return false;
+    }
+
+    // 每个边界列一次回代：z = A_dd^{-1} A_dS(:, c)，S_d(:, c) = A_Sd z
+    for (int c = 0; c < nb; c++) {
+        if (dom.ds_ptr[c] == dom.ds_ptr[c + 1]) {
+            continue;
+        }
+        for (int p = dom.ds_ptr[c]; p < dom.ds_ptr[c + 1]; p++) {
+            dom.work_b(dom.ds_row[p]) = dom.ds_val[p];
+        }
+        if (!dom.lu.solve(dom.work_b, dom.work_x)) {
+            return false;
+        }
+        for (int p = dom.ds_ptr[c]; p < dom.ds_ptr[c + 1]; p++) {
+            dom.work_b(dom.ds_row[p]) = 0;
+        }
+        double* column = dom.schur.data() + c * nb;
+        for (int j = 0; j < size; j++) {
+            double z = dom.work_x(j);
+            if (z == 0) {
+                continue;
+            }
+            for (int p = dom.sd_ptr[j]; p < dom.sd_ptr[j + 1]; p++) {
+                column[dom.sd_row[p]] += dom.sd_val[p] * z;
+            }
+        }
+    }
+    return true;
+}
+
+bool DomainLU::factorize(const arma::sp_mat& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "DomainLU::factorize() matrix is not square.";
+        return false;
+    }
+    if (!loadValues(A)) {
+        // 结构变化，已有的划分不再适用时重新划分
+        if (!nd.fits(A)) {
+            nd.analyze(A, domain_num);
+            analyze_count++;
+        }
+        use_whole = !nd.isAnalyzed();
+        loadPattern(A);
+        if (use_whole) {
+            domains.clear();
+        } else {
+            buildDomains(A);
+        }
+        loadValues(A);
+    }
+    factorize_count++;
+
+    if (!use_whole) {
+        runDomains([this](int d) { domains[d].status = factorDomain(d); });
+        bool status = std::all_of(
+            domains.begin(), domains.end(),
+            [](const Domain& dom) { return dom.status; });
+
+        // S = A_SS - sum_d S_d
+        if (status && schur_mat.n_rows > 0) {
+            std::copy(schur_base.begin(), schur_base.end(), schur_values);
+            for (const Domain& dom : domains) {
+                for (std::size_t t = 0; t < dom.schur.size(); t++) {
+                    schur_values[dom.schur_slot[t]] -= dom.schur[t];
+                }
+            }
+            status = schur_lu.factorize(schur_mat);
+        }
+        if (status) {
+            factored = true;
+            return true;
+        }
+        // 子区域内的主元选择受限，失败时整体分解，结构不变前不再尝试
+        fallback_count++;
+        use_whole = true;
+    }
+    factored = whole.factorize(A);
+    return factored;
+}
+
+bool DomainLU::solveInterior(int d) const {
+    const Domain& dom = domains[d];
+    int start = nd.getDomainStart(d);
+    int size = nd.getDomainSize(d);
+    if (size == 0) {
+        return true;
+    }
+    for (int i = 0; i < size; i++) {
+        dom.work_b(i) = work_b[start + i];
+    }
+    if (!dom.lu.solve(dom.work_b, dom.work_x)) {
+        return false;
+    }
+    // 边界上的 A_Sd y_d
+    std::fill(dom.work_s.begin(), dom.work_s.end(), 0);
+    for (int j = 0; j < size; j++) {
+        double y = dom.work_x(j);
+        for (int p = dom.sd_ptr[j]; p < dom.sd_ptr[j + 1]; p++) {
+            dom.work_s[dom.sd_row[p]] += dom.sd_val[p] * y;
+        }
+    }
+    return true;
+}
+
+bool DomainLU::solveDomain(int d) const {
+    const Domain& dom = domains[d];
+    int start = nd.getDomainStart(d);
+    int size = nd.getDomainSize(d);
+    if (size == 0) {
+        return true;
+    }
+    // b_d - A_dS x_S
+    for (int i = 0; i < size; i++) {
+        dom.work_b(i) = work_b[start + i];
+    }
+    int sep_start = nd.getSeparatorStart();
+    for (int c = 0; c < static_cast<int>(dom.boundary.size()); c++) {
+        double xs = work_x[sep_start + dom.boundary[c]];
+        for (int p = dom.ds_ptr[c]; p < dom.ds_ptr[c + 1]; p++) {
+            dom.work_b(dom.ds_row[p]) -= dom.ds_val[p] * xs;
+        }
+    }
+    if (!dom.lu.solve(dom.work_b, dom.work_x)) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        work_x[start + i] = dom.work_x(i);
+    }
+    return true;
+}
+
+bool DomainLU::solve(const arma::vec& b, arma::vec& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        qDebug() << "DomainLU::solve() not factored or size mismatch.";
+        return false;
+    }
+    if (use_whole) {
+        return whole.solve(b, x);
+    }
+    const std::vector<int>& perm = nd.getPerm();
+    for (int k = 0; k < n; k++) {
+        work_b[k] = b(perm[k]);
+    }
+    auto allDone = [this]() {
+        return std::all_of(domains.begin(), domains.end(),
+                           [](const Domain& dom) { return dom.status; });
+    };
+
+    // 子区域内部，再汇总到分隔集
+    runDomains([this](int d) { domains[d].status = solveInterior(d); });
+    if (!allDone()) {
+        return false;
+    }
+    int sep_start = nd.getSeparatorStart();
+    int sep_size = nd.getSeparatorSize();
+    if (sep_size > 0) {
+        for (int s = 0; s < sep_size; s++) {
+            sep_b(s) = work_b[sep_start + s];
+        }
+        for (const Domain& dom : domains) {
+            for (int c = 0; c < static_cast<int>(dom.boundary.size()); c++) {
+                sep_b(dom.boundary[c]) -= dom.work_s[c];
+            }
+        }
+        if (!schur_lu.solve(sep_b, sep_x)) {
+            return false;
+        }
+        for (int s = 0; s < sep_size; s++) {
+            work_x[sep_start + s] = sep_x(s);
+        }
+    }
+
+    // 代回分隔集的解
+    runDomains([this](int d) { domains[d].status = solveDomain(d); });
+    if (!allDone()) {
+        return false;
+    }
+
+    x.set_size(n);
+    for (int k = 0; k < n; k++) {
+        x(perm[k]) = work_x[k];
+    }
+    return true;
+}
+
+int DomainLU::getDomainNum() const {
+    return use_whole ? 0 : nd.getDomainNum();
+}
+
+int DomainLU::getSeparatorSize() const {
+    return use_whole ? 0 : nd.getSeparatorSize();
+}
+
+int DomainLU::getFactorNonzeroNum() const {
+    if (use_whole) {
+        return whole.getFactorNonzeroNum();
+    }
+    int nnz = schur_lu.getFactorNonzeroNum();
+    for (const Domain& dom : domains) {
+        nnz += dom.lu.getFactorNonzeroNum();
+        nnz += static_cast<int>(dom.ds_val.size() + dom.sd_val.size());
+    }
+    return nnz;
+}
+
+void DomainLU::printStats() const {
+    if (use_whole) {
+        std::cout << "DomainLU: n = " << n << ", not decomposed"
+                  << ", fallback = " << fallback_count << std::endl;
+        whole.printStats();
+        return;
+    }
+    std::cout << "DomainLU: n = " << n << ", domains = " << getDomainNum()
+              << ", max domain = " << nd.getMaxDomainSize()
+              << ", separator = " << getSeparatorSize()
+              << ", nnz(S) = " << schur_mat.n_nonzero
+              << ", nnz(L+U) = " << getFactorNonzeroNum()
+              << ", nd = " << analyze_count
+              << ", factorize = " << factorize_count
+              << ", threads = " << thread_num << std::endl;
+}
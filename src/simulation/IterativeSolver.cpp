@@ -0,0 +1,730 @@
+#include "IterativeSolver.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include "BlockTriangular.h"
+
+static double dot(const std::vector<double>& x, const std::vector<double>& y) {
+    double sum = 0;
+    for (std::size_t i = 0; i < x.size(); i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+static double norm2(const std::vector<double>& x) {
+    return std::sqrt(dot(x, x));
+}
+
+IterativeSolver::IterativeSolver()
+    : n(0),
+      method(LINEAR_SOLVER_GMRES),
+      precond(PRECOND_ILU0),
+      precond_valid(false),
+      precond_iterations(0),
+      recycle_dirty(false),
+      recycle_num(4),
+      tol(1e-12),
+      max_iter(1000),
+      restart(50),
+      drop_tol(1e-4),
+      fill(20),
+      solve_count(0),
+      iteration_count(0),
+      last_iterations(0),
+      precond_count(0),
+      fail_count(0) {}
+
+IterativeSolver::~IterativeSolver() {}
+
+void IterativeSolver::setMethod(int method_) {
+    if (method_ != LINEAR_SOLVER_GMRES && method_ != LINEAR_SOLVER_BICGSTAB) {
+        qDebug() << "IterativeSolver::setMethod() Unknown method:" << method_;
+        return;
+    }
+    method = method_;
+}
+
+void IterativeSolver::setPreconditioner(int precond_) {
+    if (precond_ != precond) {
+        precond = precond_;
+        precond_valid = false;
+    }
+}
+
+void IterativeSolver::loadPattern(const arma::sp_mat& A) {
+    n = static_cast<int>(A.n_cols);
+    int nnz = static_cast<int>(A.n_nonzero);
+    Ap.assign(n + 1, 0);
+    Ai.clear();
+    Ai.reserve(nnz);
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+    }
+    for (int col = 0; col < n; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+
+    // 最大横截：与第 j 列匹配的行放到第 j 行，对角元结构非零
+    row_perm.resize(n);
+    for (int i = 0; i < n; i++) {
+        row_perm[i] = i;
+    }
+    BlockTriangular btf;
+    if (btf.analyze(n, Ap, Ai)) {
+        const std::vector<int>& p = btf.getRowPerm();
+        const std::vector<int>& qinv = btf.getColPos();
+        for (int col = 0; col < n; col++) {
+            row_perm[col] = p[qinv[col]];
+        }
+    }
+    std::vector<int> row_pos(n);
+    for (int i = 0; i < n; i++) {
+        row_pos[row_perm[i]] = i;
+    }
+
+    // 按列遍历 CSC，每行的列号自然递增
+    Rp.assign(n + 1, 0);
+    for (int k = 0; k < nnz; k++) {
+        Rp[row_pos[Ai[k]] + 1]++;
+    }
+    for (int i = 0; i < n; i++) {
+        Rp[i + 1] += Rp[i];
+    }
+    std::vector<int> next(Rp.begin(), Rp.end() - 1);
+    Rj.resize(nnz);
+    Rx.assign(nnz, 0);
+    csc_to_csr.resize(nnz);
+    diag_pos.assign(n, -1);
+    for (int col = 0; col < n; col++) {
+        for (int k = Ap[col]; k < Ap[col + 1]; k++) {
+            int row = row_pos[Ai[k]];
+            int slot = next[row]++;
+            Rj[slot] = col;
+            csc_to_csr[k] = slot;
+            if (row == col) {
+                diag_pos[row] = slot;
+            }
+        }
+    }
+
+    row_scale.assign(n, 1.0);
+    work_b.assign(n, 0);
+    work_r.assign(n, 0);
+    work_z.assign(n, 0);
+    precond_valid = false;
+    recycle_u.clear();
+    recycle_c.clear();
+}
+
+bool IterativeSolver::loadValues(const arma::sp_mat& A) {
+    if (Ap.empty() || static_cast<int>(A.n_cols) != n ||
+        static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_nonzero) != static_cast<int>(Ai.size())) {
+        return false;
+    }
+    int k = 0;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int col = static_cast<int>(it.col());
+        if (Ai[k] != static_cast<int>(it.row()) || k < Ap[col] ||
+            k >= Ap[col + 1]) {
+            return false;
+        }
+        Rx[csc_to_csr[k]] = (*it);
+        k++;
+    }
+    return true;
+}
+
+bool IterativeSolver::scaleRows() {
+    // 行缩放，使每行最大元为 1。二极管正偏时某些行的元素和右端项
+    // 可能达到 1e20 以上，不缩放时 ||r|| / ||b|| 只反映这些行
+    for (int i = 0; i < n; i++) {
+        double row_max = 0;
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            row_max = std::max(row_max, std::abs(Rx[p]));
+        }
+        if (!std::isfinite(row_max)) {
+            return false;
+        }
+        row_scale[i] = row_max > 0 ? 1.0 / row_max : 1.0;
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            Rx[p] *= row_scale[i];
+        }
+    }
+    return true;
+}
+
+bool IterativeSolver::factorize(const arma::sp_mat& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "IterativeSolver::factorize() matrix is not square.";
+        return false;
+    }
+    if (!loadValues(A)) {
+        loadPattern(A);
+        loadValues(A);
+    }
+    if (!scaleRows()) {
+        qDebug() << "IterativeSolver::factorize() matrix has inf or nan.";
+        return false;
+    }
+    recycle_dirty = true;
+
+    // 矩阵变化不大时沿用旧的预条件子
+    if (!precond_valid) {
+        return buildPreconditioner();
+    }
+    return true;
+}
+
+double IterativeSolver::guardPivot(double pivot, double row_norm) const {
+    // 结构零或数值过小的主元，用一个小量代替，保证预条件子可逆
+    double small = 1e-8 * (row_norm > 0 ? row_norm : 1.0);
+    if (std::abs(pivot) < small) {
+        return pivot < 0 ? -small : small;
+    }
+    return pivot;
+}
+
+bool IterativeSolver::buildPreconditioner() {
+    switch (precond) {
+        case PRECOND_NONE:
+            Lp.assign(n + 1, 0);
+            Up.assign(n + 1, 0);
+            Lj.clear();
+            Lx.clear();
+            Uj.clear();
+            Ux.clear();
+            Ud.assign(n, 1.0);
+            break;
+        case PRECOND_ILU0:
+            buildILU0();
+            break;
+        case PRECOND_ILUT:
+            buildILUT();
+            break;
+        default:
+            qDebug() << "IterativeSolver::buildPreconditioner() Unknown "
+                        "preconditioner:"
+                     << precond;
+            return false;
+    }
+    precond_valid = true;
+    precond_iterations = -1;
+    precond_count++;
+    return true;
+}
+
+void IterativeSolver::buildILU0() {
+    // 与 PA 结构相同的不完全分解，IKJ 形式
+    std::vector<double> LU = Rx;
+    std::vector<int> marker(n, -1);
+    Ud.assign(n, 0);
+    for (int i = 0; i < n; i++) {
+        double row_norm = 0;
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            marker[Rj[p]] = p;
+            row_norm += Rx[p] * Rx[p];
+        }
+        row_norm = std::sqrt(row_norm);
+
+        for (int p = Rp[i]; p < Rp[i + 1] && Rj[p] < i; p++) {
+            int k = Rj[p];
+            LU[p] /= Ud[k];
+            double mult = LU[p];
+            for (int pk = Rp[k]; pk < Rp[k + 1]; pk++) {
+                int j = Rj[pk];
+                if (j > k && marker[j] >= 0) {
+                    LU[marker[j]] -= mult * LU[pk];
+                }
+            }
+        }
+        Ud[i] = guardPivot(diag_pos[i] >= 0 ? LU[diag_pos[i]] : 0, row_norm);
+
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            marker[Rj[p]] = -1;
+        }
+    }
+
+    // 拆成 L, U
+    Lp.assign(n + 1, 0);
+    Up.assign(n + 1, 0);
+    Lj.clear();
+    Lx.clear();
+    Uj.clear();
+    Ux.clear();
+    for (int i = 0; i < n; i++) {
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            if (Rj[p] < i) {
+                Lj.push_back(Rj[p]);
+                Lx.push_back(LU[p]);
+            } else if (Rj[p] > i) {
+                Uj.push_back(Rj[p]);
+                Ux.push_back(LU[p]);
+            }
+        }
+        Lp[i + 1] = static_cast<int>(Lj.size());
+        Up[i + 1] = static_cast<int>(Uj.size());
+    }
+}
+
+void IterativeSolver::buildILUT() {
+    // Saad 的 ILUT(tau, p)：按行消去，丢弃小于 tau * ||a_i|| 的元素，
+    // L, U 每行各保留最大的 p 个
+    std::vector<double> w(n, 0);
+    std::vector<char> in_row(n, 0);
+    std::vector<int> nonzeros;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> lower;
+    std::vector<std::pair<double, int>> kept;
+
+    Lp.assign(n + 1, 0);
+    Up.assign(n + 1, 0);
+    Lj.clear();
+    Lx.clear();
+    Uj.clear();
+    Ux.clear();
+    Ud.assign(n, 0);
+    for (int i = 0; i < n; i++) {
+        double row_norm = 0;
+        nonzeros.clear();
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            int j = Rj[p];
+            w[j] = Rx[p];
+            in_row[j] = 1;
+            nonzeros.push_back(j);
+            if (j < i) {
+                lower.push(j);
+            }
+            row_norm += Rx[p] * Rx[p];
+        }
+        row_norm = std::sqrt(row_norm);
+        double tau = drop_tol * row_norm;
+
+        while (!lower.empty()) {
+            int k = lower.top();
+            lower.pop();
+            while (!lower.empty() && lower.top() == k) {
+                lower.pop();
+            }
+            if (w[k] == 0) {
+                continue;
+            }
+            w[k] /= Ud[k];
+            if (std::abs(w[k]) < tau) {
+                w[k] = 0;
+                continue;
+            }
+            double mult = w[k];
+            for (int pk = Up[k]; pk < Up[k + 1]; pk++) {
+                int j = Uj[pk];
+                if (!in_row[j]) {
+                    in_row[j] = 1;
+                    nonzeros.push_back(j);
+                    if (j < i) {
+                        lower.push(j);
+                    }
+                }
+                w[j] -= mult * Ux[pk];
+            }
+        }
+
+        // L 部分
+        kept.clear();
+        for (int j : nonzeros) {
+            if (j < i && std::abs(w[j]) >= tau && w[j] != 0) {
+                kept.push_back(std::make_pair(-std::abs(w[j]), j));
+            }
+        }
+        if (static_cast<int>(kept.size()) > fill) {
+            std::nth_element(kept.begin(), kept.begin() + fill, kept.end());
+            kept.resize(fill);
+        }
+        std::sort(kept.begin(), kept.end(),
+                  [](const std::pair<double, int>& a,
+                     const std::pair<double, int>& b) {
+                      return a.second < b.second;
+                  });
+        for (const auto& entry : kept) {
+            Lj.push_back(entry.second);
+            Lx.push_back(w[entry.second]);
+        }
+        Lp[i + 1] = static_cast<int>(Lj.size());
+
+        // U 部分
+        Ud[i] = guardPivot(w[i], row_norm);
+        kept.clear();
+        for (int j : nonzeros) {
+            if (j > i && std::abs(w[j]) >= tau && w[j] != 0) {
+                kept.push_back(std::make_pair(-std::abs(w[j]), j));
+            }
+        }
+        if (static_cast<int>(kept.size()) > fill) {
+            std::nth_element(kept.begin(), kept.begin() + fill, kept.end());
+            kept.resize(fill);
+        }
+        std::sort(kept.begin(), kept.end(),
+                  [](const std::pair<double, int>& a,
+                     const std::pair<double, int>& b) {
+                      return a.second < b.second;
+                  });
+        for (const auto& entry : kept) {
+            Uj.push_back(entry.second);
+            Ux.push_back(w[entry.second]);
+        }
+        Up[i + 1] = static_cast<int>(Uj.size());
+
+        for (int j : nonzeros) {
+            w[j] = 0;
+            in_row[j] = 0;
+        }
+    }
+}
+
+int IterativeSolver::getPreconditionerNonzeroNum() const {
+    return static_cast<int>(Lj.size() + Uj.size() + Ud.size());
+}
+
+void IterativeSolver::multiply(const std::vector<double>& x,
+                               std::vector<double>& y) const {
+    for (int i = 0; i < n; i++) {
+        double sum = 0;
+        for (int p = Rp[i]; p < Rp[i + 1]; p++) {
+            sum += Rx[p] * x[Rj[p]];
+        }
+        y[i] = sum;
+    }
+}
+
+void IterativeSolver::residual(const std::vector<double>& x,
+                               std::vector<double>& r) const {
+    multiply(x, r);
+    for (int i = 0; i < n; i++) {
+        r[i] = work_b[i] - r[i];
+    }
+}
+
+void IterativeSolver::precondition(const std::vector<double>& r,
+                                   std::vector<double>& z) const {
+    // L y = r
+    for (int i = 0; i < n; i++) {
+        double sum = r[i];
+        for (int p = Lp[i]; p < Lp[i + 1]; p++) {
+            sum -= Lx[p] * z[Lj[p]];
+        }
+        z[i] = sum;
+    }
+    // U z = y
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = z[i];
+        for (int p = Up[i]; p < Up[i + 1]; p++) {
+            sum -= Ux[p] * z[Uj[p]];
+        }
+        z[i] = sum / Ud[i];
+    }
+}
+
+double IterativeSolver::stopResidual(const std::vector<double>& x) const {
+    // 行缩放后 ||DPA|| 为 O(1)，用 tol * (||b|| + ||x||) 作为收敛界，
+    // 右端项很小（例如扫描经过 0 点）时不会要求超出舍入误差的精度
+    return tol * (norm2(work_b) + norm2(x));
+}
+
+void IterativeSolver::projectRecycled(std::vector<double>& x,
+                                      std::vector<double>& r) {
+    if (recycle_u.empty()) {
+        return;
+    }
+    if (recycle_dirty) {
+        // 矩阵变化后重新计算 C = A U，并用 MGS 正交归一（U 同步变换）
+        std::vector<std::vector<double>> u_list;
+        std::vector<std::vector<double>> c_list;
+        std::vector<double> c(n);
+        for (std::vector<double>& u : recycle_u) {
+            multiply(u, c);
+            for (std::size_t k = 0; k < c_list.size(); k++) {
+                double h = dot(c_list[k], c);
+                for (int i = 0; i < n; i++) {
+                    c[i] -= h * c_list[k][i];
+                    u[i] -= h * u_list[k][i];
+                }
+            }
+            double c_norm = norm2(c);
+            if (c_norm == 0 || !std::isfinite(c_norm)) {
+                continue;  // 与已有方向线性相关
+            }
+            for (int i = 0; i < n; i++) {
+                c[i] /= c_norm;
+                u[i] /= c_norm;
+            }
+            u_list.push_back(u);
+            c_list.push_back(c);
+        }
+        recycle_u.swap(u_list);
+        recycle_c.swap(c_list);
+        recycle_dirty = false;
+    }
+
+    // 在 span(C) 上的最小残差投影
+    for (std::size_t k = 0; k < recycle_c.size(); k++) {
+        double y = dot(recycle_c[k], r);
+        for (int i = 0; i < n; i++) {
+            x[i] += y * recycle_u[k][i];
+            r[i] -= y * recycle_c[k][i];
+        }
+    }
+}
+
+void IterativeSolver::updateRecycled(const std::vector<double>& dx) {
+    if (recycle_num <= 0 || norm2(dx) == 0) {
+        return;
+    }
+    recycle_u.push_back(dx);
+    if (static_cast<int>(recycle_u.size()) > recycle_num) {
+        recycle_u.erase(recycle_u.begin());
+    }
+    recycle_dirty = true;
+}
+
+bool IterativeSolver::runGMRES(std::vector<double>& x) {
+    // 右预条件 GMRES(m)，Givens 旋转求解最小二乘
+    int m = std::max(1, std::min(restart, n));
+    std::vector<std::vector<double>> V(m + 1, std::vector<double>(n));
+    std::vector<std::vector<double>> H(m + 1, std::vector<double>(m, 0));
+    std::vector<double> cs(m), sn(m), g(m + 1), y(m);
+    std::vector<double>& r = work_r;
+    std::vector<double>& z = work_z;
+
+    residual(x, r);
+    double beta = norm2(r);
+    while (last_iterations < max_iter) {
+        double target = stopResidual(x);
+        if (beta <= target) {
+            return true;
+        }
+        for (int i = 0; i < n; i++) {
+            V[0][i] = r[i] / beta;
+        }
+        std::fill(g.begin(), g.end(), 0);
+        g[0] = beta;
+
+        int steps = 0;
+        for (int j = 0; j < m && last_iterations < max_iter; j++) {
+            precondition(V[j], z);
+            multiply(z, V[j + 1]);
+            std::vector<double>& w = V[j + 1];
+            for (int i = 0; i <= j; i++) {
+                H[i][j] = dot(w, V[i]);
+                for (int t = 0; t < n; t++) {
+                    w[t] -= H[i][j] * V[i][t];
+                }
+            }
+            H[j + 1][j] = norm2(w);
+            if (H[j + 1][j] != 0) {
+                for (int t = 0; t < n; t++) {
+                    w[t] /= H[j + 1][j];
+                }
+            }
+
+            for (int i = 0; i < j; i++) {
+                double tmp = cs[i] * H[i][j] + sn[i] * H[i + 1][j];
+                H[i + 1][j] = -sn[i] * H[i][j] + cs[i] * H[i + 1][j];
+                H[i][j] = tmp;
+            }
+            double denom = std::hypot(H[j][j], H[j + 1][j]);
+            if (denom == 0) {
+                break;
+            }
+            cs[j] = H[j][j] / denom;
+            sn[j] = H[j + 1][j] / denom;
+            H[j][j] = denom;
+            H[j + 1][j] = 0;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+
+            steps = j + 1;
+            last_iterations++;
+            if (std::abs(g[j + 1]) <= target) {
+                break;
+            }
+        }
+        if (steps == 0) {
+            return false;  // breakdown
+        }
+
+        // x += M^{-1} V y
+        for (int i = steps - 1; i >= 0; i--) {
+            double sum = g[i];
+            for (int k = i + 1; k < steps; k++) {
+                sum -= H[i][k] * y[k];
+            }
+            y[i] = sum / H[i][i];
+        }
+        std::fill(r.begin(), r.end(), 0);
+        for (int k = 0; k < steps; k++) {
+            for (int i = 0; i < n; i++) {
+                r[i] += y[k] * V[k][i];
+            }
+        }
+        precondition(r, z);
+        for (int i = 0; i < n; i++) {
+            x[i] += z[i];
+        }
+
+        // 用真实残差判断收敛
+        residual(x, r);
+        beta = norm2(r);
+    }
+    return beta <= stopResidual(x);
+}
+
+bool IterativeSolver::runBiCGSTAB(std::vector<double>& x) {
+    // 右预条件 BiCGSTAB。递推残差收敛而真实残差不满足时，
+    // 或出现 breakdown 时，以真实残差重新开始
+    std::vector<double>& r = work_r;
+    std::vector<double> r_hat(n), p(n), v(n), s(n), t(n);
+    std::vector<double> p_hat(n), s_hat(n);
+
+    while (last_iterations < max_iter) {
+        residual(x, r);
+        if (norm2(r) <= stopResidual(x)) {
+            return true;
+        }
+        r_hat = r;
+        std::fill(p.begin(), p.end(), 0);
+        std::fill(v.begin(), v.end(), 0);
+        double rho = 1, alpha = 1, omega = 1;
+        while (last_iterations < max_iter) {
+            last_iterations++;
+            double rho_new = dot(r_hat, r);
+            if (rho_new == 0) {
+                break;
+            }
+            double beta = (rho_new / rho) * (alpha / omega);
+            for (int i = 0; i < n; i++) {
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            }
+            precondition(p, p_hat);
+            multiply(p_hat, v);
+            double rv = dot(r_hat, v);
+            if (rv == 0) {
+                break;
+            }
+            alpha = rho_new / rv;
+            for (int i = 0; i < n; i++) {
+                s[i] = r[i] - alpha * v[i];
+            }
+            if (norm2(s) <= stopResidual(x)) {
+                for (int i = 0; i < n; i++) {
+                    x[i] += alpha * p_hat[i];
+                }
+                break;
+            }
+            precondition(s, s_hat);
+            multiply(s_hat, t);
+            double tt = dot(t, t);
+            omega = tt != 0 ? dot(t, s) / tt : 0;
+            for (int i = 0; i < n; i++) {
+                x[i] += alpha * p_hat[i] + omega * s_hat[i];
+                r[i] = s[i] - omega * t[i];
+            }
+            if (omega == 0 || norm2(r) <= stopResidual(x)) {
+                break;
+            }
+            rho = rho_new;
+        }
+    }
+
+    residual(x, r);
+    return norm2(r) <= stopResidual(x);
+}
+
+bool IterativeSolver::solve(const arma::vec& b, arma::vec& x, bool recycle) {
+    if (!precond_valid || static_cast<int>(b.n_elem) != n) {
+        qDebug() << "IterativeSolver::solve() not factorized or size "
+                    "mismatch.";
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        work_b[i] = b(row_perm[i]) * row_scale[i];
+    }
+    std::vector<double> x0(n, 0);
+    if (static_cast<int>(x.n_elem) == n && x.is_finite()) {
+        for (int i = 0; i < n; i++) {
+            x0[i] = x(i);
+        }
+    }
+
+    bool converged = false;
+    std::vector<double> xk;
+    for (int attempt = 0; attempt < 2 && !converged; attempt++) {
+        xk = x0;
+        residual(xk, work_r);
+        if (norm2(work_r) <= stopResidual(xk)) {
+            // 初值已经满足精度，原样返回，不引入投影带来的舍入误差
+            last_iterations = 0;
+            converged = true;
+            break;
+        }
+        projectRecycled(xk, work_r);
+
+        last_iterations = 0;
+        if (method == LINEAR_SOLVER_BICGSTAB) {
+            converged = runBiCGSTAB(xk);
+        } else {
+            converged = runGMRES(xk);
+        }
+        iteration_count += last_iterations;
+
+        if (precond_iterations < 0) {
+            precond_iterations = last_iterations;
+        }
+        if (!converged && precond_iterations != last_iterations) {
+            // 旧的预条件子已经不适用，用当前矩阵重新构造后再试一次
+            buildPreconditioner();
+        } else {
+            break;
+        }
+    }
+    solve_count++;
+
+    if (!converged) {
+        fail_count++;
+        return false;
+    }
+
+    // 迭代次数明显变多时，下一次 factorize 重新构造预条件子
+    if (last_iterations > 2 * precond_iterations + 10) {
+        precond_valid = false;
+    }
+
+    if (recycle) {
+        std::vector<double> dx(n);
+        for (int i = 0; i < n; i++) {
+            dx[i] = xk[i] - x0[i];
+        }
+        updateRecycled(dx);
+    }
+
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(i) = xk[i];
+    }
+    return true;
+}
+
+void IterativeSolver::printStats() const {
+    std::cout << "IterativeSolver: n = " << n << ", method = "
+              << (method == LINEAR_SOLVER_BICGSTAB ? "BiCGSTAB" : "GMRES")
+              << ", precond = "
+              << (precond == PRECOND_ILUT   ? "ILUT"
+                  : precond == PRECOND_ILU0 ? "ILU0"
+                                            : "none")
+              << ", nnz(M) = " << getPreconditionerNonzeroNum()
+              << ", solves = " << solve_count
+              << ", iterations = " << iteration_count
+              << ", precond builds = " << precond_count
+              << ", fails = " << fail_count << std::endl;
+}
@@ -0,0 +1,749 @@
+#include "LinearSolver.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include "linetype.h"
+
+template <typename eT>
+bool LinearSolver<eT>::solve(const arma::Mat<eT>& B, arma::Mat<eT>& X) {
+    // 默认逐列求解，分解只做一次
+    int n = static_cast<int>(B.n_rows);
+    int m = static_cast<int>(B.n_cols);
+    X.set_size(n, m);
+    arma::Col<eT> b(n);
+    arma::Col<eT> x;
+    for (int col = 0; col < m; col++) {
+        for (int i = 0; i < n; i++) {
+            b(i) = B(i, col);
+        }
+        x.zeros(n);  // 迭代法从零开始
+        if (!solve(b, x)) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            X(i, col) = x(i);
+        }
+    }
+    return true;
+}
+
+template <typename eT>
+bool LinearSolver<eT>::solveTransposed(const arma::Mat<eT>& B,
+                                       arma::Mat<eT>& X) {
+    int n = static_cast<int>(B.n_rows);
+    int m = static_cast<int>(B.n_cols);
+    X.set_size(n, m);
+    arma::Col<eT> b(n);
+    arma::Col<eT> x;
+    for (int col = 0; col < m; col++) {
+        for (int i = 0; i < n; i++) {
+            b(i) = B(i, col);
+        }
+        if (!solveTransposed(b, x)) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            X(i, col) = x(i);
+        }
+    }
+    return true;
+}
+
+template <typename eT>
+bool DenseLUSolver<eT>::factorize(const arma::SpMat<eT>& A) {
+    factored = false;
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "DenseLUSolver::factorize() matrix is not square.";
+        return false;
+    }
+    use_small = A.n_rows <= SMALL_DENSE_MAX_SIZE;
+    if (use_small) {
+        factored = small.factorize(A);
+        return factored;
+    }
+    if (!arma::lu(L, U, P, arma::Mat<eT>(A))) {
+        return false;
+    }
+    // 对角元为零时 LAPACK 不会报错，这里检查
+    for (arma::uword k = 0; k < U.n_rows; k++) {
+        if (U(k, k) == eT(0)) {
+            return false;
+        }
+    }
+    factored = true;
+    return true;
+}
+
+template <typename eT>
+bool DenseLUSolver<eT>::solve(const arma::Col<eT>& b, arma::Col<eT>& x) {
+    if (use_small) {
+        return small.solve(b, x);
+    }
+    if (!factored || b.n_elem != U.n_rows) {
+        return false;
+    }
+    arma::Col<eT> y;
+    return arma::solve(y, arma::trimatl(L), P * b) &&
+           arma::solve(x, arma::trimatu(U), y);
+}
+
+template <typename eT>
+bool DenseLUSolver<eT>::solve(const arma::Mat<eT>& B, arma::Mat<eT>& X) {
+    if (use_small) {
+        return LinearSolver<eT>::solve(B, X);  // 逐列求解
+    }
+    if (!factored || B.n_rows != U.n_rows) {
+        return false;
+    }
+    arma::Mat<eT> Y;
+    return arma::solve(Y, arma::trimatl(L), P * B) &&
+           arma::solve(X, arma::trimatu(U), Y);
+}
+
+template <typename eT>
+bool DenseLUSolver<eT>::solveTransposed(const arma::Col<eT>& b,
+                                        arma::Col<eT>& x) {
+    if (use_small) {
+        return small.solveTransposed(b, x);
+    }
+    if (!factored || b.n_elem != U.n_rows) {
+        return false;
+    }
+    // A = P^T L U，A^T = U^T L^T P
+    arma::Col<eT> y;
+    arma::Col<eT> z;
+    if (!arma::solve(y, arma::trimatl(arma::Mat<eT>(U.st())), b) ||
+        !arma::solve(z, arma::trimatu(arma::Mat<eT>(L.st())), y)) {
+        return false;
+    }
+    x = P.st() * z;
+    return true;
+}
+
+template <typename eT>
+void DenseLUSolver<eT>::printStats() const {
+    if (use_small) {
+        small.printStats();
+    } else {
+        std::cout << "DenseLU: LAPACK, n = " << U.n_rows << std::endl;
+    }
+}
+
+template <typename eT>
+bool SuperLUSolver<eT>::factorize(const arma::SpMat<eT>& A) {
+    matrix = A;
+    return A.n_rows == A.n_cols;
+}
+
+template <typename eT>
+bool SuperLUSolver<eT>::solve(const arma::Col<eT>& b, arma::Col<eT>& x) {
+    return arma::spsolve(x, matrix, b, "superlu");
+}
+
+template <typename eT>
+bool SuperLUSolver<eT>::solve(const arma::Mat<eT>& B, arma::Mat<eT>& X) {
+    return arma::spsolve(X, matrix, B, "superlu");
+}
+
+template <typename eT>
+bool SuperLUSolver<eT>::solveTransposed(const arma::Col<eT>& b,
+                                        arma::Col<eT>& x) {
+    return arma::spsolve(x, arma::SpMat<eT>(matrix.st()), b, "superlu");
+}
+
+// r = b - A y，返回分量后向误差 max |r_i| / (|A| |y| + |b|)_i
+template <typename eT>
+static double residual(const arma::SpMat<eT>& A,
+                       const arma::Col<eT>& b,
+                       const arma::Col<eT>& y,
+                       arma::Col<eT>& r) {
+    int n = static_cast<int>(b.n_elem);
+    r = b;
+    std::vector<double> bound(n);
+    for (int i = 0; i < n; i++) {
+        bound[i] = std::abs(b(i));
+    }
+    for (int j = 0; j < n; j++) {
+        eT yj = y(j);
+        double yj_mag = std::abs(yj);
+        for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+            arma::uword i = A.row_indices[p];
+            r(i) -= A.values[p] * yj;
+            bound[i] += std::abs(A.values[p]) * yj_mag;
+        }
+    }
+    double berr = 0;
+    for (int i = 0; i < n; i++) {
+        double r_mag = std::abs(r(i));
+        if (!std::isfinite(r_mag)) {
+            return INFINITY;  // 视为求解失败
+        }
+        // 反偏二极管的行可能下溢到非规格化数，这些分量不参与判断
+        if (bound[i] >= std::numeric_limits<double>::min()) {
+            berr = std::max(berr, r_mag / bound[i]);
+        }
+    }
+    return berr;
+}
+
+// 转置方程的残差 r = b - A^T y，后向误差同 residual()
+template <typename eT>
+static double residualTransposed(const arma::SpMat<eT>& A,
+                                 const arma::Col<eT>& b,
+                                 const arma::Col<eT>& y,
+                                 arma::Col<eT>& r) {
+    int n = static_cast<int>(b.n_elem);
+    r = b;
+    double berr = 0;
+    for (int j = 0; j < n; j++) {
+        double bound = std::abs(b(j));
+        for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+            eT yi = y(A.row_indices[p]);
+            r(j) -= A.values[p] * yi;
+            bound += std::abs(A.values[p]) * std::abs(yi);
+        }
+        double r_mag = std::abs(r(j));
+        if (!std::isfinite(r_mag)) {
+            return INFINITY;
+        }
+        if (bound >= std::numeric_limits<double>::min()) {
+            berr = std::max(berr, r_mag / bound);
+        }
+    }
+    return berr;
+}
+
+template <typename eT>
+EquilibratedSolver<eT>::EquilibratedSolver(LinearSolver<eT>* inner_)
+    : inner(inner_),
+      equilibrate_passes(0),
+      solve_count(0),
+      refine_count(0),
+      max_backward_error(0) {}
+
+template <typename eT>
+EquilibratedSolver<eT>::~EquilibratedSolver() {
+    delete inner;
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::equilibrate(const arma::SpMat<eT>& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "EquilibratedSolver::equilibrate() matrix is not square.";
+        return false;
+    }
+    int n = static_cast<int>(A.n_rows);
+
+    // 结构相同时只复制数值，避免每次 Newton 迭代重新分配
+    bool same_pattern =
+        scaled.n_rows == A.n_rows && scaled.n_nonzero == A.n_nonzero &&
+        std::equal(A.col_ptrs, A.col_ptrs + n + 1, scaled.col_ptrs) &&
+        std::equal(A.row_indices, A.row_indices + A.n_nonzero,
+                   scaled.row_indices);
+    if (!same_pattern) {
+        scaled = A;
+    }
+
+    // Ruiz：每轮同时用行、列最大元的平方根去除
+    row_scale.ones(n);
+    col_scale.ones(n);
+    std::vector<double> row_max(n);
+    std::vector<double> col_max(n);
+    equilibrate_passes = 0;
+    for (int pass = 0; pass < EQUILIBRATE_MAX_PASSES; pass++) {
+        std::fill(row_max.begin(), row_max.end(), 0.0);
+        std::fill(col_max.begin(), col_max.end(), 0.0);
+        for (int j = 0; j < n; j++) {
+            for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+                int i = static_cast<int>(A.row_indices[p]);
+                double mag =
+                    std::abs(A.values[p]) * row_scale(i) * col_scale(j);
+                if (!std::isfinite(mag)) {
+                    return false;
+                }
+                row_max[i] = std::max(row_max[i], mag);
+                col_max[j] = std::max(col_max[j], mag);
+            }
+        }
+        bool converged = true;
+        for (int i = 0; i < n; i++) {
+            if (row_max[i] > 0) {
+                row_scale(i) /= std::sqrt(row_max[i]);
+                converged = converged &&
+                            std::fabs(1 - row_max[i]) <= EQUILIBRATE_TOL;
+            }
+            if (col_max[i] > 0) {
+                col_scale(i) /= std::sqrt(col_max[i]);
+                converged = converged &&
+                            std::fabs(1 - col_max[i]) <= EQUILIBRATE_TOL;
+            }
+        }
+        equilibrate_passes++;
+        if (converged) {
+            break;
+        }
+    }
+
+    // 取 2 的幂，A_s 与 A 只差指数
+    for (int i = 0; i < n; i++) {
+        row_scale(i) = std::exp2(std::round(std::log2(row_scale(i))));
+        col_scale(i) = std::exp2(std::round(std::log2(col_scale(i))));
+    }
+    eT* values = arma::access::rwp(scaled.values);
+    for (int j = 0; j < n; j++) {
+        for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+            values[p] =
+                A.values[p] * (row_scale(A.row_indices[p]) * col_scale(j));
+        }
+    }
+    return true;
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::factorize(const arma::SpMat<eT>& A) {
+    return equilibrate(A) && inner->factorize(scaled);
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::refactor(const arma::SpMat<eT>& A) {
+    return equilibrate(A) && inner->refactor(scaled);
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::solve(const arma::Col<eT>& b,
+                                   arma::Col<eT>& x) {
+    int n = static_cast<int>(row_scale.n_elem);
+    if (static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+
+    // b_s = D_r b；迭代法时 x 的输入值作为初值，y = D_c^{-1} x
+    work_b.set_size(n);
+    for (int i = 0; i < n; i++) {
+        work_b(i) = b(i) * row_scale(i);
+    }
+    if (x.n_elem == b.n_elem) {
+        work_y.set_size(n);
+        for (int i = 0; i < n; i++) {
+            work_y(i) = x(i) / col_scale(i);
+        }
+    } else {
+        work_y.zeros(n);
+    }
+    if (!solveScaled(false)) {
+        return false;
+    }
+
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(i) = work_y(i) * col_scale(i);
+    }
+    solve_count++;
+    return true;
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::solveTransposed(const arma::Col<eT>& b,
+                                             arma::Col<eT>& x) {
+    int n = static_cast<int>(row_scale.n_elem);
+    if (static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+
+    // A^T x = b  <=>  A_s^T y = D_c b，x = D_r y
+    work_b.set_size(n);
+    for (int i = 0; i < n; i++) {
+        work_b(i) = b(i) * col_scale(i);
+    }
+    work_y.zeros(n);
+    if (!solveScaled(true)) {
+        return false;
+    }
+
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(i) = work_y(i) * row_scale(i);
+    }
+    solve_count++;
+    return true;
+}
+
+template <typename eT>
+bool EquilibratedSolver<eT>::solveScaled(bool transposed) {
+    int n = static_cast<int>(work_b.n_elem);
+    auto inner_solve = [&](const arma::Col<eT>& b, arma::Col<eT>& y) {
+        return transposed ? inner->solveTransposed(b, y) : inner->solve(b, y);
+    };
+    // 修正方程单独求解，迭代法不把它记入回收子空间
+    auto inner_correct = [&](const arma::Col<eT>& r, arma::Col<eT>& d) {
+        return transposed ? inner->solveTransposed(r, d)
+                          : inner->solveCorrection(r, d);
+    };
+    auto scaled_residual = [&](const arma::Col<eT>& y, arma::Col<eT>& r) {
+        return transposed ? residualTransposed(scaled, work_b, y, r)
+                          : residual(scaled, work_b, y, r);
+    };
+    if (!inner_solve(work_b, work_y)) {
+        return false;
+    }
+
+    // 迭代精化，后向误差没有减半时停止并保留之前的解
+    double berr = scaled_residual(work_y, work_r);
+    for (int step = 0; step < REFINE_MAX_STEPS && berr > REFINE_BACKWARD_ERROR;
+         step++) {
+        work_d.zeros(n);
+        if (!inner_correct(work_r, work_d)) {
+            break;
+        }
+        work_y_new = work_y + work_d;
+        double berr_new = scaled_residual(work_y_new, work_r_new);
+        if (!(berr_new < 0.5 * berr)) {
+            break;
+        }
+        std::swap(work_y, work_y_new);
+        std::swap(work_r, work_r_new);
+        berr = berr_new;
+        refine_count++;
+    }
+    if (!std::isfinite(berr)) {
+        return false;
+    }
+    max_backward_error = std::max(max_backward_error, berr);
+    return true;
+}
+
+template <typename eT>
+void EquilibratedSolver<eT>::printStats() const {
+    std::cout << "Equilibration: passes = " << equilibrate_passes
+              << ", solve = " << solve_count << ", refine = " << refine_count
+              << ", max backward error = " << max_backward_error << std::endl;
+    inner->printStats();
+}
+
+template class LinearSolver<double>;
+template class LinearSolver<std::complex<double>>;
+template class DenseLUSolver<double>;
+template class DenseLUSolver<std::complex<double>>;
+template class SuperLUSolver<double>;
+template class SuperLUSolver<std::complex<double>>;
+template class EquilibratedSolver<double>;
+template class EquilibratedSolver<std::complex<double>>;
+
+SparseLUSolver::SparseLUSolver(const BlockTriangular* btf) {
+    // 使用 preProcess 时算好的 BTF，结构不符时会自己重新计算
+    if (btf != nullptr) {
+        lu.setStructure(*btf);
+    }
+}
+
+bool SparseLUSolver::factorize(const arma::sp_mat& A) {
+    return lu.factorize(A);
+}
+
+bool SparseLUSolver::solve(const arma::vec& b, arma::vec& x) {
+    return lu.solve(b, x);
+}
+
+bool ComplexSparseLUSolver::factorize(const arma::sp_cx_mat& A) {
+    return lu.factorize(A);
+}
+
+bool ComplexSparseLUSolver::refactor(const arma::sp_cx_mat& A) {
+    return lu.refactor(A);
+}
+
+bool ComplexSparseLUSolver::solve(const arma::cx_vec& b, arma::cx_vec& x) {
+    return lu.solve(b, x);
+}
+
+bool ComplexSparseLUSolver::solveTransposed(const arma::cx_vec& b,
+                                            arma::cx_vec& x) {
+    return lu.solveTransposed(b, x);
+}
+
+DomainLUSolver::DomainLUSolver(const NestedDissection* nd) {
+    // 使用 preProcess 时算好的划分，结构不符时会自己重新划分
+    if (nd != nullptr && nd->isAnalyzed()) {
+        lu.setStructure(*nd);
+    }
+}
+
+bool DomainLUSolver::factorize(const arma::sp_mat& A) {
+    return lu.factorize(A);
+}
+
+bool DomainLUSolver::solve(const arma::vec& b, arma::vec& x) {
+    return lu.solve(b, x);
+}
+
+MixedPrecisionSolver::MixedPrecisionSolver(const BlockTriangular* btf)
+    : lu_double(btf),
+      use_double(false),
+      double_only(false),
+      solve_count(0),
+      refine_count(0),
+      stall_count(0),
+      fallback_count(0) {}
+
+bool MixedPrecisionSolver::factorize(const arma::sp_mat& A) {
+    // 结构相同时只转换数值
+    bool same_pattern =
+        matrix_f.n_rows == A.n_rows && matrix_f.n_nonzero == A.n_nonzero &&
+        std::equal(A.col_ptrs, A.col_ptrs + A.n_cols + 1, matrix_f.col_ptrs) &&
+        std::equal(A.row_indices, A.row_indices + A.n_nonzero,
+                   matrix_f.row_indices);
+    matrix = A;
+    if (same_pattern) {
+        float* values = arma::access::rwp(matrix_f.values);
+        for (arma::uword p = 0; p < A.n_nonzero; p++) {
+            values[p] = static_cast<float>(A.values[p]);
+        }
+    } else {
+        arma::Col<float> values(A.n_nonzero);
+        for (arma::uword p = 0; p < A.n_nonzero; p++) {
+            values(p) = static_cast<float>(A.values[p]);
+        }
+        matrix_f = arma::SpMat<float>(
+            arma::uvec(A.row_indices, A.n_nonzero),
+            arma::uvec(A.col_ptrs, A.n_cols + 1), values, A.n_rows, A.n_cols);
+    }
+
+    use_double = double_only;
+    if (!use_double) {
+        if (lu_f.factorize(matrix_f)) {
+            return true;
+        }
+        // 单精度下溢出或奇异
+        use_double = true;
+        fallback_count++;
+    }
+    return factorizeDouble();
+}
+
+bool MixedPrecisionSolver::factorizeDouble() {
+    return lu_double.factorize(matrix);
+}
+
+bool MixedPrecisionSolver::solveFloat(const arma::vec& b, arma::vec& x) {
+    int n = static_cast<int>(b.n_elem);
+    // 精化时的残差很小，先按 2 的幂缩放到 1 附近，避免在单精度下下溢
+    double b_max = 0;
+    for (int i = 0; i < n; i++) {
+        b_max = std::max(b_max, std::fabs(b(i)));
+    }
+    if (b_max == 0) {
+        x.zeros(n);
+        return true;
+    }
+    int exponent = std::ilogb(b_max);
+    work_bf.set_size(n);
+    for (int i = 0; i < n; i++) {
+        work_bf(i) = static_cast<float>(std::ldexp(b(i), -exponent));
+    }
+    if (!lu_f.solve(work_bf, work_xf)) {
+        return false;
+    }
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(i) = std::ldexp(static_cast<double>(work_xf(i)), exponent);
+    }
+    return true;
+}
+
+bool MixedPrecisionSolver::solve(const arma::vec& b, arma::vec& x) {
+    if (use_double) {
+        return lu_double.solve(b, x);
+    }
+
+    // 单精度的解作为初值，残差和修正量的累加都用双精度
+    bool converged = false;
+    if (solveFloat(b, x)) {
+        double berr = residual(matrix, b, x, work_r);
+        for (int step = 0; step < MIXED_PRECISION_MAX_STEPS; step++) {
+            if (berr <= REFINE_BACKWARD_ERROR) {
+                converged = true;
+                break;
+            }
+            if (!solveFloat(work_r, work_d)) {
+                break;
+            }
+            work_x_new = x + work_d;
+            double berr_new = residual(matrix, b, work_x_new, work_r_new);
+            if (!(berr_new < 0.5 * berr)) {
+                break;
+            }
+            std::swap(x, work_x_new);
+            std::swap(work_r, work_r_new);
+            berr = berr_new;
+            refine_count++;
+        }
+        converged = converged || berr <= REFINE_BACKWARD_ERROR;
+    }
+    if (converged) {
+        solve_count++;
+        return true;
+    }
+
+    // 精化停滞，当前矩阵改用双精度
+    stall_count++;
+    fallback_count++;
+    if (stall_count >= MIXED_PRECISION_MAX_STALLS) {
+        double_only = true;
+    }
+    use_double = true;
+    return factorizeDouble() && lu_double.solve(b, x);
+}
+
+void MixedPrecisionSolver::printStats() const {
+    std::cout << "MixedPrecision: solve = " << solve_count
+              << ", refine = " << refine_count
+              << ", fallback = " << fallback_count
+              << (double_only ? " (double only)" : "") << std::endl;
+    lu_f.printStats();
+    if (fallback_count > 0) {
+        lu_double.printStats();
+    }
+}
+
+IterativeLinearSolver::IterativeLinearSolver(int method, int precond) {
+    solver.setMethod(method);
+    solver.setPreconditioner(precond);
+}
+
+const char* IterativeLinearSolver::getName() const {
+    return getLinearSolverName(solver.getMethod());
+}
+
+bool IterativeLinearSolver::factorize(const arma::sp_mat& A) {
+    return solver.factorize(A);
+}
+
+bool IterativeLinearSolver::solve(const arma::vec& b, arma::vec& x) {
+    if (x.n_elem != b.n_elem) {
+        x.zeros(b.n_elem);  // 没有初值时从零开始
+    }
+    return solver.solve(b, x);
+}
+
+bool IterativeLinearSolver::solveCorrection(const arma::vec& r,
+                                            arma::vec& d) {
+    if (d.n_elem != r.n_elem) {
+        d.zeros(r.n_elem);
+    }
+    return solver.solve(r, d, false);
+}
+
+int selectLinearSolver(int requested,
+                       int size,
+                       int nonzero_num,
+                       int analysis_type,
+                       bool complex) {
+    if (requested != LINEAR_SOLVER_AUTO) {
+        if (complex && (requested == LINEAR_SOLVER_GMRES ||
+                        requested == LINEAR_SOLVER_BICGSTAB ||
+                        requested == LINEAR_SOLVER_DOMAIN)) {
+            return LINEAR_SOLVER_DIRECT;  // 复数方程没有迭代法和区域分解
+        }
+        return requested;
+    }
+
+    // 小规模或很稠密的矩阵，稀疏存储和排序的开销不值得
+    double density =
+        size > 0 ? static_cast<double>(nonzero_num) / size / size : 1;
+    if (size <= LINEAR_SOLVER_DENSE_MAX_SIZE ||
+        (size <= LINEAR_SOLVER_DENSE_DENSITY_SIZE &&
+         density >= LINEAR_SOLVER_DENSE_MIN_DENSITY)) {
+        return LINEAR_SOLVER_DENSE;
+    }
+    // 规模很大时直接法的填充可能放不进内存；AC 是复数方程，仍用直接法
+    if (!complex && analysis_type != ANALYSIS_AC &&
+        size >= LINEAR_SOLVER_ITERATIVE_MIN_SIZE) {
+        return LINEAR_SOLVER_BICGSTAB;
+    }
+    // 较大的电路（电源网络、电阻网格）在多核上按子区域并行分解
+    if (!complex && analysis_type != ANALYSIS_AC &&
+        size >= LINEAR_SOLVER_DOMAIN_MIN_SIZE &&
+        static_cast<int>(std::thread::hardware_concurrency()) >=
+            LINEAR_SOLVER_DOMAIN_MIN_THREADS) {
+        return LINEAR_SOLVER_DOMAIN;
+    }
+    return LINEAR_SOLVER_DIRECT;
+}
+
+RealLinearSolver* createLinearSolver(int type,
+                                     int precond,
+                                     const BlockTriangular* btf,
+                                     bool mixed_precision,
+                                     const NestedDissection* nd) {
+    RealLinearSolver* solver;
+    switch (type) {
+        case LINEAR_SOLVER_DIRECT:
+            if (mixed_precision) {
+                solver = new MixedPrecisionSolver(btf);
+            } else {
+                solver = new SparseLUSolver(btf);
+            }
+            break;
+        case LINEAR_SOLVER_GMRES:
+        case LINEAR_SOLVER_BICGSTAB:
+            solver = new IterativeLinearSolver(type, precond);
+            break;
+        case LINEAR_SOLVER_DENSE:
+            solver = new DenseLUSolver<double>();
+            break;
+        case LINEAR_SOLVER_SUPERLU:
+            solver = new SuperLUSolver<double>();
+            break;
+        case LINEAR_SOLVER_DOMAIN:
+            solver = new DomainLUSolver(nd);
+            break;
+        default:
+            qDebug() << "createLinearSolver() Unknown solver type:" << type;
+            solver = new SparseLUSolver(btf);
+    }
+    return new EquilibratedSolver<double>(solver);
+}
+
+ComplexLinearSolver* createComplexLinearSolver(int type) {
+    ComplexLinearSolver* solver;
+    switch (type) {
+        case LINEAR_SOLVER_DIRECT:
+            solver = new ComplexSparseLUSolver();
+            break;
+        case LINEAR_SOLVER_DENSE:
+            solver = new DenseLUSolver<std::complex<double>>();
+            break;
+        case LINEAR_SOLVER_SUPERLU:
+            solver = new SuperLUSolver<std::complex<double>>();
+            break;
+        default:
+            qDebug() << "createComplexLinearSolver() Unknown solver type:"
+                     << type;
+            solver = new ComplexSparseLUSolver();
+    }
+    return new EquilibratedSolver<std::complex<double>>(solver);
+}
+
+const char* getLinearSolverName(int type) {
+    switch (type) {
+        case LINEAR_SOLVER_AUTO:
+            return "auto";
+        case LINEAR_SOLVER_DIRECT:
+            return "sparselu";
+        case LINEAR_SOLVER_GMRES:
+            return "gmres";
+        case LINEAR_SOLVER_BICGSTAB:
+            return "bicgstab";
+        case LINEAR_SOLVER_DENSE:
+            return "dense";
+        case LINEAR_SOLVER_SUPERLU:
+            return "superlu";
+        case LINEAR_SOLVER_DOMAIN:
+            return "domain";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,165 @@
+#include "LowRankLU.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+LowRankLU::LowRankLU()
+    : based(false), residual_tol(1e-10), update_count(0), rebase_count(0) {}
+
+LowRankLU::~LowRankLU() {}
+
+void LowRankLU::setStructure(const BlockTriangular& btf) {
+    base_lu.setStructure(btf);
+}
+
+void LowRankLU::setUpdate(const arma::sp_mat& U_, const arma::sp_mat& V_) {
+    if (U_.n_rows != V_.n_rows || U_.n_cols != V_.n_cols) {
+        qDebug() << "LowRankLU::setUpdate() U and V size mismatch.";
+        return;
+    }
+    U = U_;
+    V = V_;
+    based = false;
+}
+
+bool LowRankLU::rebase(const arma::sp_mat& A, const arma::vec& g) {
+    based = false;
+    if (!base_lu.factorize(A)) {
+        return false;
+    }
+    int n = static_cast<int>(A.n_rows);
+    int k = static_cast<int>(U.n_cols);
+
+    // W = B^{-1} U，每列一次回代
+    W.set_size(n, k);
+    work_u.zeros(n);
+    for (int col = 0; col < k; col++) {
+        for (arma::uword p = U.col_ptrs[col]; p < U.col_ptrs[col + 1]; p++) {
+            work_u(U.row_indices[p]) = U.values[p];
+        }
+        if (!base_lu.solve(work_u, work_w)) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            W(i, col) = work_w(i);
+        }
+        for (arma::uword p = U.col_ptrs[col]; p < U.col_ptrs[col + 1]; p++) {
+            work_u(U.row_indices[p]) = 0;
+        }
+    }
+
+    // V^T W
+    VtW.zeros(k, k);
+    for (int row = 0; row < k; row++) {
+        for (arma::uword p = V.col_ptrs[row]; p < V.col_ptrs[row + 1]; p++) {
+            for (int col = 0; col < k; col++) {
+                VtW(row, col) += V.values[p] * W(V.row_indices[p], col);
+            }
+        }
+    }
+
+    g_base = g;
+    based = true;
+    rebase_count++;
+    return true;
+}
+
+bool LowRankLU::solveUpdated(const arma::vec& b, arma::vec& x) {
+    int k = static_cast<int>(U.n_cols);
+
+    if (!base_lu.solve(b, work_y)) {
+        return false;
+    }
+
+    // S = I + V^T W D, t = V^T y
+    arma::mat S(k, k);
+    arma::vec t(k);
+    for (int row = 0; row < k; row++) {
+        for (int col = 0; col < k; col++) {
+            S(row, col) = VtW(row, col) * delta(col);
+        }
+        S(row, row) += 1;
+        double sum = 0;
+        for (arma::uword p = V.col_ptrs[row]; p < V.col_ptrs[row + 1]; p++) {
+            sum += V.values[p] * work_y(V.row_indices[p]);
+        }
+        t(row) = sum;
+    }
+    arma::vec z;
+    if (!arma::solve(z, S, t)) {
+        return false;
+    }
+
+    // x = y - W D z
+    x = work_y;
+    int n = static_cast<int>(x.n_elem);
+    for (int col = 0; col < k; col++) {
+        double dz = delta(col) * z(col);
+        if (dz == 0) {
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            x(i) -= W(i, col) * dz;
+        }
+    }
+    return x.is_finite();
+}
+
+bool LowRankLU::checkResidual(const arma::sp_mat& A,
+                              const arma::vec& b,
+                              const arma::vec& x) const {
+    // 分量后向误差 |b - Ax|_i <= tol * (|A||x| + |b|)_i
+    int n = static_cast<int>(A.n_rows);
+    std::vector<double> r(n);
+    std::vector<double> scale(n);
+    for (int i = 0; i < n; i++) {
+        r[i] = b(i);
+        scale[i] = std::abs(b(i));
+    }
+    for (int col = 0; col < n; col++) {
+        double xj = x(col);
+        for (arma::uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+            double t = A.values[p] * xj;
+            r[A.row_indices[p]] -= t;
+            scale[A.row_indices[p]] += std::abs(t);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (!(std::abs(r[i]) <= residual_tol * scale[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LowRankLU::solve(const arma::sp_mat& A,
+                      const arma::vec& g,
+                      const arma::vec& b,
+                      arma::vec& x) {
+    if (A.n_rows != U.n_rows || g.n_elem != U.n_cols) {
+        qDebug() << "LowRankLU::solve() size mismatch.";
+        return false;
+    }
+    if (!based || g_base.n_elem != g.n_elem) {
+        return rebase(A, g) && base_lu.solve(b, x);
+    }
+
+    delta = g - g_base;
+    bool status = arma::norm(delta, "inf") == 0 ? base_lu.solve(b, x)
+                                                : solveUpdated(b, x);
+    if (status && checkResidual(A, b, x)) {
+        update_count++;
+        return true;
+    }
+
+    // 电导变化过大，更新后的精度不够，在当前矩阵处重新分解
+    return rebase(A, g) && base_lu.solve(b, x);
+}
+
+void LowRankLU::printStats() const {
+    std::cout << "LowRankLU: rank = " << getRank()
+              << ", update = " << update_count
+              << ", rebase = " << rebase_count << std::endl;
+    base_lu.printStats();
+}
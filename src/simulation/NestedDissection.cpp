@@ -0,0 +1,376 @@
+#include "NestedDissection.h"
+#include <QDebug>
+#include <algorithm>
+#include "solvertype.h"
+
+NestedDissection::NestedDissection() : analyzed(false), n(0), leaf_base(1) {}
+
+NestedDissection::~NestedDissection() {}
+
+void NestedDissection::clear() {
+    analyzed = false;
+    perm.clear();
+    pos.clear();
+    domain_of.clear();
+    r.clear();
+}
+
+bool NestedDissection::analyze(const arma::sp_mat& A, int domain_num) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "NestedDissection::analyze() matrix is not square.";
+        return false;
+    }
+    int size = static_cast<int>(A.n_cols);
+    std::vector<int> Ap(size + 1, 0);
+    std::vector<int> Ai;
+    Ai.reserve(A.n_nonzero);
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+    }
+    for (int col = 0; col < size; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+    return analyze(size, Ap, Ai, domain_num);
+}
+
+bool NestedDissection::analyze(int n_,
+                               const std::vector<int>& Ap,
+                               const std::vector<int>& Ai,
+                               int domain_num) {
+    clear();
+    n = n_;
+
+    // 二分的层数，2^depth 个子区域
+    domain_num = std::min(domain_num, n / DOMAIN_MIN_SIZE);
+    int depth = 0;
+    while ((2 << depth) <= domain_num) {
+        depth++;
+    }
+    if (depth == 0) {
+        return false;
+    }
+
+    std::vector<int> group;
+    int group_num = matchGroups(Ap, Ai, group);
+    if (group_num < 0) {
+        qDebug() << "NestedDissection::analyze() structurally singular.";
+        return false;
+    }
+
+    // A + A^T 的邻接表（不含对角元）
+    std::vector<int> sym_ptr(n + 1, 0);
+    for (int col = 0; col < n; col++) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (Ai[ptr] != col) {
+                sym_ptr[Ai[ptr] + 1]++;
+                sym_ptr[col + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        sym_ptr[i + 1] += sym_ptr[i];
+    }
+    std::vector<int> sym(sym_ptr[n]);
+    std::vector<int> fill(sym_ptr.begin(), sym_ptr.end() - 1);
+    for (int col = 0; col < n; col++) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (Ai[ptr] != col) {
+                sym[fill[Ai[ptr]]++] = col;
+                sym[fill[col]++] = Ai[ptr];
+            }
+        }
+    }
+
+    // 同一组的变量合并为一个顶点，权重为组内变量数
+    std::vector<int> member_ptr(group_num + 1, 0);
+    for (int i = 0; i < n; i++) {
+        member_ptr[group[i] + 1]++;
+    }
+    for (int g = 0; g < group_num; g++) {
+        member_ptr[g + 1] += member_ptr[g];
+    }
+    std::vector<int> members(n);
+    fill.assign(member_ptr.begin(), member_ptr.end() - 1);
+    for (int i = 0; i < n; i++) {
+        members[fill[group[i]]++] = i;
+    }
+    std::vector<int> weight(group_num);
+    std::vector<int> adj_ptr(group_num + 1, 0);
+    std::vector<int> adj;
+    adj.reserve(sym.size());
+    std::vector<int> mark(group_num, -1);
+    for (int g = 0; g < group_num; g++) {
+        weight[g] = member_ptr[g + 1] - member_ptr[g];
+        mark[g] = g;
+        for (int k = member_ptr[g]; k < member_ptr[g + 1]; k++) {
+            int i = members[k];
+            for (int ptr = sym_ptr[i]; ptr < sym_ptr[i + 1]; ptr++) {
+                int h = group[sym[ptr]];
+                if (mark[h] != g) {
+                    mark[h] = g;
+                    adj.push_back(h);
+                }
+            }
+        }
+        adj_ptr[g + 1] = static_cast<int>(adj.size());
+    }
+
+    // 递归二分，label 为 0 表示分隔集，叶子编号为 leaf_base + 子区域号
+    leaf_base = 1 << depth;
+    std::vector<int> label(group_num, 1);
+    std::vector<int> vertices(group_num);
+    for (int g = 0; g < group_num; g++) {
+        vertices[g] = g;
+    }
+    work_level.assign(group_num, -1);
+    bisect(adj_ptr, adj, weight, label, vertices, 1, depth);
+    work_level.clear();
+
+    // 按子区域排列，分隔集放在最后
+    int domains = leaf_base;
+    domain_of.assign(n, -1);
+    r.assign(domains + 2, 0);
+    for (int i = 0; i < n; i++) {
+        int tag = label[group[i]];
+        domain_of[i] = tag == 0 ? -1 : tag - leaf_base;
+        r[(tag == 0 ? domains : domain_of[i]) + 1]++;
+    }
+    for (int d = 0; d <= domains; d++) {
+        r[d + 1] += r[d];
+    }
+    perm.assign(n, 0);
+    pos.assign(n, 0);
+    fill.assign(r.begin(), r.end() - 1);
+    for (int i = 0; i < n; i++) {
+        int d = domain_of[i] < 0 ? domains : domain_of[i];
+        pos[i] = fill[d]++;
+        perm[pos[i]] = i;
+    }
+
+    if (getSeparatorSize() > DOMAIN_MAX_SEPARATOR_RATIO * n) {
+        // 图的连接太密（不像网格），分隔集上的 Schur 补代价过高
+        clear();
+        return false;
+    }
+    analyzed = true;
+    return true;
+}
+
+int NestedDissection::matchGroups(const std::vector<int>& Ap,
+                                  const std::vector<int>& Ai,
+                                  std::vector<int>& group) {
+    // 零自由对角的匹配：先取对角元，其余列用增广路径补上
+    std::vector<int> row_match(n, -1);
+    std::vector<int> col_match(n, -1);
+    for (int col = 0; col < n; col++) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (Ai[ptr] == col) {
+                row_match[col] = col;
+                col_match[col] = col;
+                break;
+            }
+        }
+    }
+
+    // 入栈时先找未匹配的行，使增广路径尽量短（支路变量只绕到相邻节点）
+    auto cheap = [&](int col) {
+        for (int ptr = Ap[col]; ptr < Ap[col + 1]; ptr++) {
+            if (row_match[Ai[ptr]] < 0) {
+                return Ai[ptr];
+            }
+        }
+        return -1;
+    };
+    std::vector<int> visited(n, -1);
+    std::vector<int> next_ptr(n, 0);
+    std::vector<int> col_stack;
+    for (int start = 0; start < n; start++) {
+        if (col_match[start] >= 0) {
+            continue;
+        }
+        col_stack.clear();
+        col_stack.push_back(start);
+        next_ptr[start] = Ap[start];
+        int found = cheap(start);
+        while (!col_stack.empty() && found < 0) {
+            int col = col_stack.back();
+            if (next_ptr[col] >= Ap[col + 1]) {
+                col_stack.pop_back();
+                continue;
+            }
+            int row = Ai[next_ptr[col]++];
+            if (visited[row] == start) {
+                continue;
+            }
+            visited[row] = start;
+            int next = row_match[row];
+            next_ptr[next] = Ap[next];
+            col_stack.push_back(next);
+            found = cheap(next);
+        }
+        if (found < 0) {
+            return -1;  // 结构奇异
+        }
+        int row = found;
+        for (int k = static_cast<int>(col_stack.size()) - 1; k >= 0; k--) {
+            int col = col_stack[k];
+            int prev_row = col_match[col];
+            col_match[col] = row;
+            row_match[row] = col;
+            row = prev_row;
+        }
+    }
+
+    // 匹配 (行 i, 列 col_match[i]) 构成的环合并为一组
+    group.assign(n, -1);
+    int group_num = 0;
+    for (int i = 0; i < n; i++) {
+        if (group[i] >= 0) {
+            continue;
+        }
+        for (int j = i; group[j] < 0; j = col_match[j]) {
+            group[j] = group_num;
+        }
+        group_num++;
+    }
+    return group_num;
+}
+
+void NestedDissection::bisect(const std::vector<int>& adj_ptr,
+                              const std::vector<int>& adj,
+                              const std::vector<int>& weight,
+                              std::vector<int>& label,
+                              const std::vector<int>& vertices,
+                              int tag,
+                              int depth) {
+    if (vertices.empty()) {
+        return;
+    }
+    if (depth == 0) {
+        for (int v : vertices) {
+            label[v] = tag;
+        }
+        return;
+    }
+
+    // 只在 label == tag 的顶点上做 BFS，work_level 记录层号
+    std::vector<int> order;
+    order.reserve(vertices.size());
+    auto bfs = [&](int root, int base) {
+        std::size_t head = order.size();
+        work_level[root] = base;
+        order.push_back(root);
+        int max_level = base;
+        for (; head < order.size(); head++) {
+            int v = order[head];
+            for (int ptr = adj_ptr[v]; ptr < adj_ptr[v + 1]; ptr++) {
+                int u = adj[ptr];
+                if (label[u] == tag && work_level[u] < 0) {
+                    work_level[u] = work_level[v] + 1;
+                    max_level = std::max(max_level, work_level[u]);
+                    order.push_back(u);
+                }
+            }
+        }
+        return max_level;
+    };
+
+    // 各连通分量依次分层，层号不重叠；每个分量从伪外围顶点出发
+    int total_weight = 0;
+    int base = 0;
+    for (int v : vertices) {
+        total_weight += weight[v];
+        if (work_level[v] >= 0) {
+            continue;
+        }
+        std::size_t first = order.size();
+        bfs(v, base);
+        int far = order.back();
+        for (std::size_t k = first; k < order.size(); k++) {
+            work_level[order[k]] = -1;
+        }
+        order.resize(first);
+        base = bfs(far, base) + 2;
+    }
+
+    // 按权重取中位的一层，只有与更深一层相连的顶点才需要进入分隔集
+    int split = 0;
+    int acc = 0;
+    for (int v : order) {
+        acc += weight[v];
+        if (2 * acc >= total_weight) {
+            split = work_level[v];
+            break;
+        }
+    }
+    std::vector<int> part0;
+    std::vector<int> part1;
+    std::vector<int> separator;
+    for (int v : order) {
+        int level = work_level[v];
+        if (level > split) {
+            part1.push_back(v);
+        } else if (level < split) {
+            part0.push_back(v);
+        } else {
+            bool cut = false;
+            for (int ptr = adj_ptr[v]; ptr < adj_ptr[v + 1] && !cut; ptr++) {
+                int u = adj[ptr];
+                cut = label[u] == tag && work_level[u] > split;
+            }
+            if (cut) {
+                separator.push_back(v);
+            } else {
+                part0.push_back(v);
+            }
+        }
+    }
+    for (int v : order) {
+        work_level[v] = -1;
+    }
+    for (int v : separator) {
+        label[v] = 0;
+    }
+    for (int v : part0) {
+        label[v] = 2 * tag;
+    }
+    for (int v : part1) {
+        label[v] = 2 * tag + 1;
+    }
+    bisect(adj_ptr, adj, weight, label, part0, 2 * tag, depth - 1);
+    bisect(adj_ptr, adj, weight, label, part1, 2 * tag + 1, depth - 1);
+}
+
+bool NestedDissection::fits(const arma::sp_mat& A) const {
+    if (!analyzed || static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_cols) != n) {
+        return false;
+    }
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int d_row = domain_of[it.row()];
+        int d_col = domain_of[it.col()];
+        if (d_row >= 0 && d_col >= 0 && d_row != d_col) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int NestedDissection::getMaxDomainSize() const {
+    int max_size = 0;
+    for (int d = 0; d < getDomainNum(); d++) {
+        max_size = std::max(max_size, getDomainSize(d));
+    }
+    return max_size;
+}
+
+void NestedDissection::printDomains() const {
+    if (!analyzed) {
+        std::cout << "ND: n = " << n << ", not decomposed" << std::endl;
+        return;
+    }
+    std::cout << "ND: n = " << n << ", domains = " << getDomainNum()
+              << ", max domain = " << getMaxDomainSize()
+              << ", separator = " << getSeparatorSize() << std::endl;
+}
@@ -0,0 +1,215 @@
+#include "Ordering.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+static void sortUnique(std::vector<std::vector<int>>& adj) {
+    for (auto& neighbors : adj) {
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                        neighbors.end());
+    }
+}
+
+std::vector<int> computeOrdering(int method,
+                                 int n,
+                                 const std::vector<int>& Ap,
+                                 const std::vector<int>& Ai) {
+    switch (method) {
+        case ORDERING_AMD:
+            return orderAMD(n, Ap, Ai);
+        case ORDERING_COLAMD:
+            return orderCOLAMD(n, Ap, Ai);
+        case ORDERING_NATURAL:
+            break;
+        default:
+            qDebug() << "computeOrdering() Unknown ordering method:" << method;
+            break;
+    }
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    return perm;
+}
+
+std::vector<int> orderAMD(int n,
+                          const std::vector<int>& Ap,
+                          const std::vector<int>& Ai) {
+    // A + A^T 的图，去掉对角元
+    std::vector<std::vector<int>> adj(n);
+    for (int col = 0; col < n; col++) {
+        for (int p = Ap[col]; p < Ap[col + 1]; p++) {
+            int row = Ai[p];
+            if (row != col) {
+                adj[row].push_back(col);
+                adj[col].push_back(row);
+            }
+        }
+    }
+    sortUnique(adj);
+    return orderApproximateMinimumDegree(adj);
+}
+
+std::vector<int> orderCOLAMD(int n,
+                             const std::vector<int>& Ap,
+                             const std::vector<int>& Ai) {
+    // A^T A 的图：同一行中的列两两相连
+    std::vector<std::vector<int>> rows(n);
+    for (int col = 0; col < n; col++) {
+        for (int p = Ap[col]; p < Ap[col + 1]; p++) {
+            rows[Ai[p]].push_back(col);
+        }
+    }
+
+    // 与 COLAMD 相同，忽略稠密行（例如电源节点），避免 A^T A 变成稠密
+    std::size_t dense_row = std::max(16.0, 10 * std::sqrt(n));
+    std::vector<std::vector<int>> adj(n);
+    for (const auto& row : rows) {
+        if (row.size() > dense_row) {
+            continue;
+        }
+        for (int a : row) {
+            for (int b : row) {
+                if (a != b) {
+                    adj[a].push_back(b);
+                }
+            }
+        }
+    }
+    sortUnique(adj);
+    return orderApproximateMinimumDegree(adj);
+}
+
+std::vector<int> orderApproximateMinimumDegree(
+    std::vector<std::vector<int>>& adj) {
+    /**
+     * 商图 (quotient graph) 上的近似最小度排序
+     * 已消去的节点成为 element，变量通过 element 间接相连，不显式生成填充。
+     * 度数使用 Amestoy-Davis-Duff 的近似上界：
+     *   d(i) = |A_i| + |L_p \ i| + sum_{e in E_i, e != p} |L_e \ L_p|
+     * 并做 element absorption（包括 aggressive absorption）。
+     */
+    const int VARIABLE = 0;
+    const int ELEMENT = 1;
+    const int ABSORBED = 2;
+
+    int n = static_cast<int>(adj.size());
+    std::vector<int> status(n, VARIABLE);
+    std::vector<std::vector<int>>& var_adj = adj;  // A_i
+    std::vector<std::vector<int>> elem_adj(n);     // E_i
+    std::vector<std::vector<int>> elem_vars(n);    // L_e
+
+    std::vector<int> degree(n);
+    std::set<std::pair<int, int>> degree_queue;  // (degree, node)
+    for (int i = 0; i < n; i++) {
+        degree[i] = static_cast<int>(var_adj[i].size());
+        degree_queue.insert(std::make_pair(degree[i], i));
+    }
+
+    std::vector<int> mark(n, -1);     // mark[i] == p 表示 i 属于 L_p
+    std::vector<int> w(n, 0);         // w[e] = |L_e \ L_p|
+    std::vector<int> w_stamp(n, -1);  // w[e] 是否已为当前 p 初始化
+
+    std::vector<int> perm;
+    perm.reserve(n);
+    std::vector<int> lp;
+    for (int k = 0; k < n; k++) {
+        int p = degree_queue.begin()->second;
+        degree_queue.erase(degree_queue.begin());
+        perm.push_back(p);
+
+        // L_p = A_p ∪ (∪_{e in E_p} L_e) \ {p}，E_p 中的 element 被 p 吸收
+        lp.clear();
+        mark[p] = p;
+        for (int v : var_adj[p]) {
+            if (status[v] == VARIABLE && mark[v] != p) {
+                mark[v] = p;
+                lp.push_back(v);
+            }
+        }
+        for (int e : elem_adj[p]) {
+            if (status[e] != ELEMENT) {
+                continue;
+            }
+            for (int v : elem_vars[e]) {
+                if (status[v] == VARIABLE && mark[v] != p) {
+                    mark[v] = p;
+                    lp.push_back(v);
+                }
+            }
+            status[e] = ABSORBED;
+            std::vector<int>().swap(elem_vars[e]);
+        }
+        status[p] = ELEMENT;
+        elem_vars[p] = lp;
+        std::vector<int>().swap(var_adj[p]);
+        std::vector<int>().swap(elem_adj[p]);
+
+        // 计算与 L_p 相邻的 element 的 w[e]
+        for (int i : lp) {
+            for (int e : elem_adj[i]) {
+                if (status[e] != ELEMENT || e == p) {
+                    continue;
+                }
+                if (w_stamp[e] != p) {
+                    w_stamp[e] = p;
+                    // 顺便清理 L_e 中已消去的变量
+                    auto& vars = elem_vars[e];
+                    vars.erase(std::remove_if(vars.begin(), vars.end(),
+                                              [&status](int v) {
+                                                  return status[v] != VARIABLE;
+                                              }),
+                               vars.end());
+                    w[e] = static_cast<int>(vars.size());
+                }
+                w[e]--;
+            }
+        }
+
+        // 更新 L_p 中每个变量的邻接关系和近似度数
+        int lp_size = static_cast<int>(lp.size());
+        for (int i : lp) {
+            auto& elems = elem_adj[i];
+            int elem_degree = 0;
+            std::size_t kept = 0;
+            for (std::size_t t = 0; t < elems.size(); t++) {
+                int e = elems[t];
+                if (status[e] != ELEMENT || e == p) {
+                    continue;
+                }
+                if (w_stamp[e] == p && w[e] == 0) {
+                    // aggressive absorption: L_e 是 L_p 的子集
+                    status[e] = ABSORBED;
+                    std::vector<int>().swap(elem_vars[e]);
+                    continue;
+                }
+                elem_degree += w[e];
+                elems[kept++] = e;
+            }
+            elems.resize(kept);
+            elems.push_back(p);
+
+            // A_i 中已被 L_p 覆盖的变量可以去掉
+            auto& vars = var_adj[i];
+            vars.erase(std::remove_if(vars.begin(), vars.end(),
+                                      [&status, &mark, p](int v) {
+                                          return status[v] != VARIABLE ||
+                                                 mark[v] == p;
+                                      }),
+                       vars.end());
+
+            int d = static_cast<int>(vars.size()) + (lp_size - 1) +
+                    elem_degree;
+            d = std::min(d, degree[i] + lp_size - 1);
+            d = std::min(d, n - k - 2);
+            d = std::max(d, 0);
+
+            degree_queue.erase(std::make_pair(degree[i], i));
+            degree[i] = d;
+            degree_queue.insert(std::make_pair(degree[i], i));
+        }
+    }
+    return perm;
+}
@@ -0,0 +1,247 @@
+#include "PortCondenser.h"
+#include <QDebug>
+#include <algorithm>
+#include <iostream>
+#include "BlockTriangular.h"
+
+PortCondenser::PortCondenser()
+    : ready(false), n(0), setup_count(0), condense_count(0) {}
+
+PortCondenser::~PortCondenser() {}
+
+bool PortCondenser::setup(const arma::sp_mat& A,
+                          const std::vector<int>& ports_) {
+    ready = false;
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "PortCondenser::setup() matrix is not square.";
+        return false;
+    }
+    n = static_cast<int>(A.n_rows);
+
+    // 划分端口和内部变量
+    port_index.assign(n, -1);
+    interior_index.assign(n, -1);
+    ports.clear();
+    interior.clear();
+    for (int i : ports_) {
+        if (i >= 0 && i < n && port_index[i] < 0) {
+            port_index[i] = 0;
+            ports.push_back(i);
+        }
+    }
+    extendPorts(A);
+    std::sort(ports.begin(), ports.end());
+    for (int k = 0; k < static_cast<int>(ports.size()); k++) {
+        port_index[ports[k]] = k;
+    }
+    for (int i = 0; i < n; i++) {
+        if (port_index[i] < 0) {
+            interior_index[i] = static_cast<int>(interior.size());
+            interior.push_back(i);
+        }
+    }
+    int n_port = static_cast<int>(ports.size());
+    int n_interior = static_cast<int>(interior.size());
+
+    // 拆分 A，A_PP 直接写入 S，A_IP 按列保存用于求 Z
+    schur.zeros(n_port, n_port);
+    std::vector<std::vector<std::pair<int, double>>> ip_cols(n_port);
+    std::vector<arma::uword> ii_loc;
+    std::vector<double> ii_val;
+    std::vector<arma::uword> pi_loc;
+    std::vector<double> pi_val;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it) {
+        int row = static_cast<int>(it.row());
+        int col = static_cast<int>(it.col());
+        int prow = port_index[row];
+        int pcol = port_index[col];
+        if (prow >= 0 && pcol >= 0) {
+            schur(prow, pcol) += (*it);
+        } else if (prow >= 0) {
+            pi_loc.push_back(prow);
+            pi_loc.push_back(interior_index[col]);
+            pi_val.push_back(*it);
+        } else if (pcol >= 0) {
+            ip_cols[pcol].push_back(std::make_pair(interior_index[row], *it));
+        } else {
+            ii_loc.push_back(interior_index[row]);
+            ii_loc.push_back(interior_index[col]);
+            ii_val.push_back(*it);
+        }
+    }
+    A_II = arma::sp_mat(arma::umat(ii_loc.data(), 2, ii_val.size()),
+                        arma::vec(ii_val.data(), ii_val.size()), n_interior,
+                        n_interior);
+    A_PI = arma::sp_mat(arma::umat(pi_loc.data(), 2, pi_val.size()),
+                        arma::vec(pi_val.data(), pi_val.size()), n_port,
+                        n_interior);
+
+    Z.zeros(n_interior, n_port);
+    y_interior.zeros(n_interior);
+    if (n_interior > 0) {
+        if (!interior_lu.factorize(A_II)) {
+            qDebug() << "PortCondenser::setup() interior matrix is singular.";
+            return false;
+        }
+
+        // Z = A_II^{-1} A_IP，每个端口一次回代
+        arma::vec col_b(n_interior, arma::fill::zeros);
+        arma::vec col_x;
+        for (int p = 0; p < n_port; p++) {
+            if (ip_cols[p].empty()) {
+                continue;
+            }
+            for (const auto& entry : ip_cols[p]) {
+                col_b(entry.first) += entry.second;
+            }
+            if (!interior_lu.solve(col_b, col_x)) {
+                return false;
+            }
+            for (int k = 0; k < n_interior; k++) {
+                Z(k, p) = col_x(k);
+            }
+            for (const auto& entry : ip_cols[p]) {
+                col_b(entry.first) = 0;
+            }
+        }
+
+        // S = A_PP - A_PI Z
+        for (int j = 0; j < n_interior; j++) {
+            for (arma::uword p = A_PI.col_ptrs[j]; p < A_PI.col_ptrs[j + 1];
+                 p++) {
+                int prow = static_cast<int>(A_PI.row_indices[p]);
+                double value = A_PI.values[p];
+                for (int pcol = 0; pcol < n_port; pcol++) {
+                    schur(prow, pcol) -= value * Z(j, pcol);
+                }
+            }
+        }
+    }
+
+    ready = true;
+    setup_count++;
+    return true;
+}
+
+void PortCondenser::extendPorts(const arma::sp_mat& A) {
+    // 只取器件端口时，A_II 可能结构奇异：例如驱动二极管一端的电压源
+    // (V1 in 0; D1 in out)，支路方程只含端口节点，在 A_II 中整行为零。
+    // 对 A_II 的非零结构求最大横截，没有匹配上的行和列（以及对应的
+    // 变量）移到端口中，重复到 A_II 有完整的横截为止
+    std::vector<int> local(n);
+    std::vector<int> global;
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+    std::vector<int> row_match;
+    BlockTriangular matching;
+    while (true) {
+        global.clear();
+        for (int i = 0; i < n; i++) {
+            local[i] = port_index[i] < 0 ? static_cast<int>(global.size())
+                                         : -1;
+            if (local[i] >= 0) {
+                global.push_back(i);
+            }
+        }
+        int m = static_cast<int>(global.size());
+        if (m == 0) {
+            return;
+        }
+        Ap.assign(m + 1, 0);
+        Ai.clear();
+        for (int jj = 0; jj < m; jj++) {
+            int j = global[jj];
+            for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+                int ii = local[A.row_indices[p]];
+                if (ii >= 0 && A.values[p] != 0) {
+                    Ai.push_back(ii);
+                }
+            }
+            Ap[jj + 1] = static_cast<int>(Ai.size());
+        }
+        if (matching.transversal(m, Ap, Ai, row_match) == m) {
+            return;
+        }
+
+        std::vector<char> col_matched(m, 0);
+        std::vector<int> moved;
+        for (int ii = 0; ii < m; ii++) {
+            if (row_match[ii] >= 0) {
+                col_matched[row_match[ii]] = 1;
+            } else {
+                moved.push_back(global[ii]);
+            }
+        }
+        for (int jj = 0; jj < m; jj++) {
+            if (!col_matched[jj]) {
+                moved.push_back(global[jj]);
+            }
+        }
+        for (int i : moved) {
+            if (port_index[i] < 0) {
+                port_index[i] = 0;
+                ports.push_back(i);
+            }
+        }
+    }
+}
+
+bool PortCondenser::condenseRHS(const arma::vec& b, arma::vec& b_port) {
+    if (!ready || static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+    int n_port = static_cast<int>(ports.size());
+    int n_interior = static_cast<int>(interior.size());
+
+    b_port.set_size(n_port);
+    for (int p = 0; p < n_port; p++) {
+        b_port(p) = b(ports[p]);
+    }
+    if (n_interior == 0) {
+        condense_count++;
+        return true;
+    }
+
+    // y_I = A_II^{-1} b_I，b_P -= A_PI y_I
+    work_b.set_size(n_interior);
+    for (int k = 0; k < n_interior; k++) {
+        work_b(k) = b(interior[k]);
+    }
+    if (!interior_lu.solve(work_b, y_interior)) {
+        return false;
+    }
+    for (int j = 0; j < n_interior; j++) {
+        double yj = y_interior(j);
+        for (arma::uword p = A_PI.col_ptrs[j]; p < A_PI.col_ptrs[j + 1]; p++) {
+            b_port(A_PI.row_indices[p]) -= A_PI.values[p] * yj;
+        }
+    }
+    condense_count++;
+    return true;
+}
+
+void PortCondenser::recover(const arma::vec& x_port, arma::vec& x) const {
+    int n_port = static_cast<int>(ports.size());
+    int n_interior = static_cast<int>(interior.size());
+
+    // x_I = y_I - Z x_P
+    x.set_size(n);
+    for (int p = 0; p < n_port; p++) {
+        x(ports[p]) = x_port(p);
+    }
+    for (int k = 0; k < n_interior; k++) {
+        double sum = y_interior(k);
+        for (int p = 0; p < n_port; p++) {
+            sum -= Z(k, p) * x_port(p);
+        }
+        x(interior[k]) = sum;
+    }
+}
+
+void PortCondenser::printStats() const {
+    std::cout << "PortCondenser: n = " << n << ", ports = " << ports.size()
+              << ", interior = " << interior.size()
+              << ", setup = " << setup_count
+              << ", condense = " << condense_count << std::endl;
+    interior_lu.printStats();
+}
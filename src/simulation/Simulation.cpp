@@ -1,31 +1,69 @@
 #include "Simulation.h"
 #include <QDebug>
+#include <algorithm>
+#include <thread>
+#include "DeviceStamps.h"
 
 const arma::sp_mat* Simulation::MNA_T = nullptr;
 const arma::vec* Simulation::RHS_T = nullptr;
-
-Simulation::Simulation(Analysis& analysis_,
-                       Netlist& netlist_,
-                       Nodes& nodes_,
-                       Branches& branches_,
+const BlockTriangular* Simulation::BTF_T = nullptr;
+const NestedDissection* Simulation::ND_T = nullptr;
+const DeviceTables* Simulation::DEV_T = nullptr;
+
+Simulation::Simulation(const Analysis& analysis_,
+                       const Netlist& netlist_,
+                       const Nodes& nodes_,
+                       const Branches& branches_,
                        const arma::sp_mat* MNA_T_,
-                       const arma::vec* RHS_T_)
+                       const arma::vec* RHS_T_,
+                       const BlockTriangular* BTF_T_,
+                       const NestedDissection* ND_T_,
+                       const DeviceTables* DEV_T_)
     : analysis(analysis_),
       netlist(netlist_),
       nodes(nodes_),
-      branches(branches_) {
+      branches(branches_),
+      op_solver(nullptr),
+      op_solver_type(LINEAR_SOLVER_AUTO),
+      op_low_rank(false),
+      solver_threads(0),
+      op_gmin(0),
+      op_pseudo_g(0),
+      newton_point_count(0),
+      newton_iter_count(0),
+      gmin_stepping_count(0),
+      source_stepping_count(0),
+      ptran_count(0),
+      ptran_step_count(0),
+      homotopy_count(0),
+      homotopy_step_count(0),
+      newton_fail_count(0),
+      diode_eval_count(0),
+      diode_bypass_count(0),
+      op_base_version(-1) {
     if (MNA_T_ != nullptr && RHS_T_ != nullptr) {
         MNA_T = MNA_T_;
         RHS_T = RHS_T_;
     }
+    if (BTF_T_ != nullptr) {
+        BTF_T = BTF_T_;
+    }
+    if (ND_T_ != nullptr) {
+        ND_T = ND_T_;
+    }
+    if (DEV_T_ != nullptr) {
+        DEV_T = DEV_T_;
+    }
     // 应当从 netlist 中获取默认参数
     // 这里暂时使用默认参数
     rel_tol = 1e-3;
     abs_tol = 5e-5;
-    max_iter = 100;
+    max_iter = NEWTON_MAX_ITER;
 }
 
-Simulation::~Simulation() {}
+Simulation::~Simulation() {
+    delete op_solver;
+}
 
 void Simulation::runSimulation() {
     // do nothing
@@ -36,54 +74,319 @@ void Simulation::runSimulation() {
     return;
 }
 
-arma::vec Simulation::solveOneOP(arma::sp_mat& MNA,
+bool Simulation::solveLinear(const arma::sp_mat& A,
+                             const arma::vec& b,
+                             arma::vec& x) {
+    if (op_solver == nullptr) {
+        return false;
+    }
+    return op_solver->factorize(A) && op_solver->solve(b, x);
+}
+
+int Simulation::getThreadNum() const {
+    if (analysis.sweep_threads > 0) {
+        return analysis.sweep_threads;
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void Simulation::mergeSolverStats(const Simulation& other) {
+    newton_point_count += other.newton_point_count;
+    newton_iter_count += other.newton_iter_count;
+    gmin_stepping_count += other.gmin_stepping_count;
+    source_stepping_count += other.source_stepping_count;
+    newton_fail_count += other.newton_fail_count;
+    ptran_count += other.ptran_count;
+    ptran_step_count += other.ptran_step_count;
+    homotopy_count += other.homotopy_count;
+    homotopy_step_count += other.homotopy_step_count;
+    diode_eval_count += other.diode_eval_count;
+    diode_bypass_count += other.diode_bypass_count;
+}
+
+long long Simulation::solveUncountedOP(const arma::sp_mat& MNA,
+                                      arma::vec& RHS,
+                                      arma::vec& x) {
+    // 后备策略（gmin 步进等）的计数照常累加
+    long long point_start = newton_point_count;
+    long long iter_start = newton_iter_count;
+    x = solveOneOP(MNA, RHS, x);
+    long long iterations = newton_iter_count - iter_start;
+    newton_point_count = point_start;
+    newton_iter_count = iter_start;
+    return iterations;
+}
+
+bool Simulation::solveJacobian(const arma::vec& b, arma::vec& x) {
+    if (!op_stamps.isCompiled() ||
+        op_stamps.getSize() != static_cast<int>(b.n_elem)) {
+        return false;
+    }
+    restampDiodes();
+    return solveLinear(op_stamps.getMatrix(), b, x);
+}
+
+void Simulation::printLinearSolverStats() const {
+    if (op_condenser.isReady()) {
+        op_condenser.printStats();
+    } else if (op_low_rank) {
+        op_lowrank.printStats();
+    } else if (op_solver != nullptr) {
+        std::cout << "Linear solver: " << op_solver->getName() << std::endl;
+        op_solver->printStats();
+    }
+}
+
+void Simulation::printSolverStats() const {
+    printLinearSolverStats();
+    if (newton_point_count > 0) {
+        std::cout << "Newton: points = " << newton_point_count
+                  << ", iterations = " << newton_iter_count
+                  << " (avg = "
+                  << static_cast<double>(newton_iter_count) / newton_point_count
+                  << "), gmin stepping = " << gmin_stepping_count
+                  << ", source stepping = " << source_stepping_count
+                  << ", failed = " << newton_fail_count << std::endl;
+    }
+    if (ptran_count + homotopy_count > 0) {
+        std::cout << "Continuation: pseudo-transient = " << ptran_count
+                  << " (steps = " << ptran_step_count
+                  << "), homotopy = " << homotopy_count
+                  << " (steps = " << homotopy_step_count << ")" << std::endl;
+    }
+    if (DEV_T != nullptr && DEV_T->diodes.size() > 0) {
+        std::cout << "Device bypass: "
+                  << (analysis.device_bypass ? "on" : "off")
+                  << ", evaluated = " << diode_eval_count
+                  << ", bypassed = " << diode_bypass_count << std::endl;
+    }
+}
+
+void Simulation::buildOPStampMap(const arma::sp_mat& MNA) {
+    int matrix_size = static_cast<int>(MNA.n_rows);
+
+    const DiodeTable& diodes = DEV_T->diodes;
+    op_stamps.clear();
+    op_stamps.addPattern(MNA);
+    PatternSink pattern(op_stamps);
+    DiodeStamp(diodes).stampNewtonPattern(pattern);
+    // 伪瞬态的伪电容加在每个节点的对角元上（支路方程不加），
+    // 只接电压源、电感等支路的节点在 MNA 中没有对角元，也要登记，
+    // 与 solvePseudoTransient 中每个节点的右端项对应
+    int node_num = std::min(nodes.getNodeNumExgnd(), matrix_size);
+    for (int i = 0; i < node_num; i++) {
+        op_stamps.addEntry(i, i);
+    }
+    op_stamps.compile(matrix_size);
+
+    pseudo_slots.clear();
+    for (int i = 0; i < node_num; i++) {
+        pseudo_slots.push_back(op_stamps.getSlot(i, i));
+    }
+
+    rhs_base.zeros(matrix_size);
+    rhs_iter.zeros(matrix_size);
+
+    // 按规模、密度和分析类型选择线性求解器，.OPTIONS SOLVER= 可以指定；
+    // 稀疏 LU 使用 preProcess 时算好的 BTF（区域分解使用划分），
+    // 结构不符时会自己重新计算
+    delete op_solver;
+    op_solver_type = selectLinearSolver(
+        analysis.linear_solver, matrix_size, op_stamps.getNonzeroNum(),
+        analysis.analysis_type);
+    op_solver = createLinearSolver(op_solver_type, analysis.preconditioner,
+                                   BTF_T, analysis.mixed_precision, ND_T);
+    if (solver_threads > 0) {
+        op_solver->setThreadNum(solver_threads);
+        op_lowrank.setThreadNum(solver_threads);
+        op_condenser.setThreadNum(solver_threads);
+    }
+    if (BTF_T != nullptr) {
+        op_lowrank.setStructure(*BTF_T);
+    }
+
+    // 每个二极管的贡献为秩 1：g (d + e_branch) d^T，d = e_nplus - e_nminus
+    int diode_num = diodes.size();
+    // 混合精度时低秩更新的双精度基分解会抵消节省的内存，不使用
+    op_low_rank = op_solver_type == LINEAR_SOLVER_DIRECT &&
+                  !analysis.mixed_precision && diode_num > 0 &&
+                  diode_num <= LOW_RANK_MAX_RANK &&
+                  4 * diode_num <= matrix_size;
+    if (op_low_rank) {
+        arma::sp_mat U(matrix_size, diode_num);
+        arma::sp_mat V(matrix_size, diode_num);
+        for (int k = 0; k < diode_num; k++) {
+            int id_nplus = diodes.nplus[k];
+            int id_nminus = diodes.nminus[k];
+
+            stampSet(U, id_nplus, k, 1.0);
+            stampSet(U, id_nminus, k, -1.0);
+            stampSet(U, diodes.branch[k], k, 1.0);
+            stampSet(V, id_nplus, k, 1.0);
+            stampSet(V, id_nminus, k, -1.0);
+        }
+        op_lowrank.setUpdate(U, V);
+    }
+    diode_v.set_size(diode_num);
+    diode_v.fill(arma::datum::nan);
+    diode_i.zeros(diode_num);
+    diode_g.zeros(diode_num);
+    diode_stamped_g.zeros(diode_num);
+    diode_stamped_j.zeros(diode_num);
+    diode_peak_g.zeros(diode_num);
+    diode_peak_j.zeros(diode_num);
+    eval_index.reserve(diode_num);
+    eval_v.resize(diode_num);
+    eval_i.resize(diode_num);
+    eval_g.resize(diode_num);
+    op_base_version = -1;
+}
+
+arma::vec Simulation::solveOneOP(const arma::sp_mat& MNA,
                                  arma::vec& RHS,
-                                 arma::vec& x_prev) const {
-    // 创建 x_previter
-    arma::vec x_previter = x_prev;
-    // arma::vec x_previter_gnd = x_prev_gnd;
+                                 arma::vec& x_prev) {
+    // 结构只在第一次或 MNA 出现新的非零元时编译，之后只更新数值
+    if (!op_stamps.isCompiled() ||
+        op_stamps.getSize() != static_cast<int>(MNA.n_rows) ||
+        !op_stamps.loadBase(MNA)) {
+        buildOPStampMap(MNA);
+        op_stamps.loadBase(MNA);
+    }
+    rhs_base = RHS;
+    // 线性部分变化（例如瞬态步长改变）后低秩更新的基准分解失效，
+    // 端口凝聚也需要重新计算
+    if (op_stamps.getBaseVersion() != op_base_version) {
+        op_base_version = op_stamps.getBaseVersion();
+        op_lowrank.invalidate();
+        if (analysis.condense_ports) {
+            setupCondensation();
+        }
+    }
+
+    rhs_source = RHS;
+    newton_point_count++;
 
     arma::vec x = x_prev;  // 保存当前迭代的解
-    // arma::vec x = arma::zeros(x_prev.n_elem);  // 保存当前迭代的解
+    if (op_condenser.isReady() && solveOneOPCondensed(x_prev, x)) {
+        return x;
+    }
 
-    // 对非线性器件进行迭代求解
-    for (int iter = 0; iter < max_iter; iter++) {
-        arma::sp_mat MNA_iter = MNA;
-        arma::vec RHS_iter = RHS;
+    // 直接 Newton（结电压限制 + 自适应阻尼）
+    x = x_prev;
+    if (solveNewton(x, max_iter)) {
+        return x;
+    }
+    arma::vec x_direct = x;
+
+    // 不收敛时依次尝试 gmin 步进、源步进、伪瞬态和同伦，
+    // 都从 x_prev 重新开始
+    x = x_prev;
+    if (solveGminStepping(x)) {
+        gmin_stepping_count++;
+        return x;
+    }
+    x = x_prev;
+    if (solveSourceStepping(x)) {
+        source_stepping_count++;
+        return x;
+    }
+    x = x_prev;
+    if (solvePseudoTransient(x)) {
+        ptran_count++;
+        return x;
+    }
+    x = x_prev;
+    if (solveHomotopy(x)) {
+        homotopy_count++;
+        return x;
+    }
 
+    newton_fail_count++;
+    std::cout << "solveOneOP() Warning: sim_value = " << sim_value
+              << ", cannot converge." << std::endl;
+    return x_direct;
+}
+
+bool Simulation::solveNewton(arma::vec& x, int iter_limit) {
+    // 创建 x_previter
+    arma::vec x_previter = x;
+
+    // 对非线性器件进行迭代求解
+    const DiodeTable& diodes = DEV_T->diodes;
+    double damping = 1.0;
+    double last_step = arma::datum::inf;
+    for (int iter = 0; iter < iter_limit; iter++) {
+        newton_iter_count++;
         x_previter = x;
-        // 为 x_prev 补一个 0，与 index 对应（地节点的电压就是 0）
-        arma::vec x_previter_gnd = x_previter;
-        x_previter_gnd.insert_rows(0, arma::zeros(1));
-
-        for (Diode* diode : netlist.diodes) {
-            int id_nplus = diode->getIdNplus();
-            int id_nminus = diode->getIdNminus();
-            int id_branch = diode->getIdBranch();
-            DiodeModel* model = diode->getModel();
-
-            // 从上一轮迭代的解开始迭代
-            double vk = x_previter_gnd(id_nplus) - x_previter_gnd(id_nminus);
-            double ik = model->calcCurrentAtVoltage(vk);
-            double gk = model->calcConductanceAtVoltage(vk);
-            double jk = ik - gk * vk;
-
-            MNA_iter(id_nplus, id_nplus) += gk;
-            MNA_iter(id_nplus, id_nminus) -= gk;
-            MNA_iter(id_nminus, id_nminus) += gk;
-            MNA_iter(id_nminus, id_nplus) -= gk;
-            RHS_iter(id_nplus) -= jk;
-            RHS_iter(id_nminus) += jk;
-            MNA_iter(id_branch, id_nplus) = gk;
-            MNA_iter(id_branch, id_nminus) = -gk;
-            // MNA_iter(id_branch, id_branch) = -1;
-            RHS_iter(id_branch) = -jk;
-        }
-
-        // exclude ground node
-        MNA_iter.shed_row(0);
-        MNA_iter.shed_col(0);
-        RHS_iter.shed_row(0);
+
+        // 从上一轮迭代的解开始迭代（地节点的电压就是 0）。
+        // 结电压相对上次求值的结电压做 pnjlim 限制（第一次求值时相对 0），
+        // 有结电压被限制时本次迭代不能判为收敛。
+        // 器件旁路：结电压相对上次求值的变化、以及按上次线性化预测的
+        // 电流变化都在容差内时，沿用上次的电流和电导，不求值也不重新装配
+        bool limited = false;
+        eval_index.clear();
+        for (int k = 0; k < diodes.size(); k++) {
+            int id_nplus = diodes.nplus[k];
+            int id_nminus = diodes.nminus[k];
+            double v_nplus = id_nplus >= 0 ? x_previter(id_nplus) : 0;
+            double v_nminus = id_nminus >= 0 ? x_previter(id_nminus) : 0;
+            double v_old = diode_v(k);
+            bool limited_k;
+            double vk = diodes.limitVoltage(k, v_nplus - v_nminus,
+                                            std::isnan(v_old) ? 0 : v_old,
+                                            limited_k);
+            limited = limited || limited_k;
+            if (analysis.device_bypass) {
+                double i_old = diode_i(k);
+                double dv = vk - v_old;
+                double di = diode_g(k) * dv;
+                double v_max = std::max(std::abs(vk), std::abs(v_old));
+                double i_max = std::max(std::abs(i_old + di), std::abs(i_old));
+                double v_tol =
+                    DEVICE_BYPASS_RELTOL * v_max + DEVICE_BYPASS_VNTOL;
+                double i_tol =
+                    DEVICE_BYPASS_RELTOL * i_max + DEVICE_BYPASS_ABSTOL;
+                if (std::abs(dv) < v_tol && std::abs(di) < i_tol) {
+                    diode_bypass_count++;
+                    continue;
+                }
+            }
+            eval_v[eval_index.size()] = vk;
+            eval_index.push_back(k);
+        }
+
+        // 需要求值的二极管一次算出电流和电导
+        int eval_num = static_cast<int>(eval_index.size());
+        diodes.evaluate(eval_num, eval_index.data(), eval_v.data(),
+                        eval_i.data(), eval_g.data());
+        for (int e = 0; e < eval_num; e++) {
+            int k = eval_index[e];
+            diode_v(k) = eval_v[e];
+            diode_i(k) = eval_i[e];
+            diode_g(k) = eval_g[e];
+        }
+        diode_eval_count += eval_num;
+
+        // 第一次迭代装配全部二极管（包括沿用上次结果的），之后只把重新
+        // 求值的二极管与已装配值之差加上去。电导或等效电流比装配过的
+        // 最大值小很多时（例如从过冲的大电流收敛回来），增量会被舍入误差
+        // 淹没，这时整体重新装配
+        bool restamp = iter == 0;
+        for (int e = 0; e < eval_num && !restamp; e++) {
+            int k = eval_index[e];
+            double gk = diode_g(k) + op_gmin;
+            double jk = diode_i(k) - diode_g(k) * diode_v(k);
+            restamp = diode_peak_g(k) > DEVICE_RESTAMP_RATIO * std::abs(gk) ||
+                      diode_peak_j(k) > DEVICE_RESTAMP_RATIO * std::abs(jk);
+        }
+        if (restamp) {
+            restampDiodes();
+        } else {
+            for (int e = 0; e < eval_num; e++) {
+                stampDiodeUpdate(eval_index[e]);
+            }
+        }
 
         /*
         // check if the matrix is singular
@@ -95,67 +398,339 @@ arma::vec Simulation::solveOneOP(arma::sp_mat& MNA,
         }
         */
 
-        // MNA_iter.print("MNA_iter");
-        // RHS_iter.print("RHS_iter");
-
-        bool status = arma::spsolve(x, MNA_iter, RHS_iter);
+        // 结构固定，除第一次外只做数值分解（迭代法时复用预条件子），
+        // 低秩更新时只做回代和 k x k 的稠密求解，失败时再解完整方程
+        // 伪电导改变了线性部分，此时不能用低秩更新
+        bool status =
+            (op_low_rank && op_pseudo_g == 0 &&
+             op_lowrank.solve(op_stamps.getMatrix(), diode_stamped_g, rhs_iter,
+                              x)) ||
+            solveLinear(op_stamps.getMatrix(), rhs_iter, x);
         // printf("status: %d\n", status);
         if (!status) {
-            qDebug() << "solveOneOP() solve failed, iter: " << iter;
-
+            // 平衡和精化之后仍然失败说明 Jacobian 确实奇异，
+            // 同一点上重试只会得到同样的结果，交给后备策略
+            qDebug() << "solveNewton() solve failed, iter:" << iter;
             x = x_previter;
-            // 无解时，添加随机噪声
-            arma::vec noise = arma::randn(x.n_elem) * abs_tol;
-            x += noise;
+            return false;
+        }
+
+        // 检查是否收敛：用完整的 Newton 步长判断
+        arma::vec dx = x - x_previter;
+        arma::vec err = arma::abs(dx);
+        bool status_abs = all(err <= abs_tol);
+        bool status_rel = all(err <= rel_tol * arma::abs(x_previter));
+        if (status_abs && status_rel && !limited) {
+            // qDebug() << "solveNewton() converged, iter: " << iter;
+            return true;
+        }
+
+        // 自适应阻尼：步长比上一步大（发散或振荡）时减半，否则逐步恢复
+        double step = arma::max(err);
+        if (step > last_step) {
+            damping = std::max(0.5 * damping, NEWTON_MIN_DAMPING);
         } else {
-            // 使用阻尼技术，避免振荡解
-            // double damping_factor = 0.5;
-            // x = damping_factor * x + (1 - damping_factor) * x_previter;
+            damping = std::min(2 * damping, 1.0);
+        }
+        last_step = step;
+        if (damping < 1) {
+            x = x_previter + damping * dx;
+        }
+    }
+    return false;
+}
 
-            // x.print("solveOneOP() x:");
-            // 检查是否收敛
-            arma::vec err = arma::abs(x - x_previter);
-            bool status_abs = all(err <= abs_tol);
-            bool status_rel = all(err <= rel_tol * arma::abs(x_previter));
-            if (status_abs && status_rel) {
-                // qDebug() << "solveOneOP() converged, iter: " << iter;
-                return x;
+bool Simulation::solveGminStepping(arma::vec& x) {
+    // 每个结并联 gmin：先用很大的 gmin 把结电压钳住，逐级减小，
+    // 每级从上一级的解出发；某一级不收敛时退回并缩小减小的倍数。
+    // 最后在 gmin = 0 上求解
+    double gmin = GMIN_STEPPING_START;
+    double factor = GMIN_STEPPING_FACTOR;
+    op_gmin = gmin;
+    bool converged = solveNewton(x, NEWTON_STEPPING_MAX_ITER);
+    arma::vec x_good = x;
+    while (converged && gmin > GMIN_STEPPING_END) {
+        op_gmin = gmin / factor;
+        if (solveNewton(x, NEWTON_STEPPING_MAX_ITER)) {
+            gmin = op_gmin;
+            x_good = x;
+            factor = std::min(factor * factor, GMIN_STEPPING_FACTOR);
+        } else {
+            x = x_good;
+            factor = std::sqrt(factor);
+            converged = factor >= GMIN_STEPPING_MIN_FACTOR;
+        }
+    }
+    op_gmin = 0;
+    return converged && solveNewton(x, max_iter);
+}
+
+bool Simulation::solveSourceStepping(arma::vec& x) {
+    // 所有独立源（整个 RHS）按比例从 0 增大到 1，步长自适应。
+    // 源为 0 时二极管都没有电流，解就是 0
+    x.zeros();
+    arma::vec x_good = x;
+    double scale = 0;
+    double step = SOURCE_STEPPING_INITIAL_STEP;
+    while (scale < 1 && step >= SOURCE_STEPPING_MIN_STEP) {
+        double next = std::min(scale + step, 1.0);
+        rhs_base = next * rhs_source;
+        if (solveNewton(x, NEWTON_STEPPING_MAX_ITER)) {
+            scale = next;
+            x_good = x;
+            step *= 2;
+        } else {
+            x = x_good;
+            step /= 4;
+        }
+    }
+    rhs_base = rhs_source;
+    return scale >= 1;
+}
+
+bool Simulation::solvePseudoTransient(arma::vec& x) {
+    // 每个节点到地接一个 1 F 的伪电容，对伪时间做后向 Euler：
+    //   (A(x) + D / dtau) x_{n+1} = b + D x_n / dtau
+    // 每一步都是良态的 Newton 问题。一步内收敛得快时放大 dtau，
+    // 不收敛时退回上一步并缩小 dtau；伪电导足够小后在原方程上求解
+    arma::vec x_step = x;
+    double dtau = PTRAN_INITIAL_STEP;
+    bool reached = false;
+    for (int step = 0; step < PTRAN_MAX_STEPS && !reached;) {
+        op_pseudo_g = 1 / dtau;
+        rhs_base = rhs_source;
+        int node_num = std::min(nodes.getNodeNumExgnd(),
+                                static_cast<int>(rhs_base.n_elem));
+        for (int i = 0; i < node_num; i++) {
+            rhs_base(i) += op_pseudo_g * x_step(i);
+        }
+
+        long long iter_start = newton_iter_count;
+        if (solveNewton(x, NEWTON_STEPPING_MAX_ITER)) {
+            step++;
+            ptran_step_count++;
+            x_step = x;
+            reached = op_pseudo_g < PTRAN_END_CONDUCTANCE;
+            if (newton_iter_count - iter_start <= PTRAN_FAST_ITER) {
+                dtau *= PTRAN_STEP_GROW;
             }
+        } else {
+            x = x_step;
+            dtau /= PTRAN_STEP_SHRINK;
+            if (dtau < PTRAN_MIN_STEP) {
+                break;
+            }
+        }
+    }
+    op_pseudo_g = 0;
+    rhs_base = rhs_source;
+    return reached && solveNewton(x, max_iter);
+}
 
-            /*
-            else if (iter == max_iter - 1) {
-                // MNA_iter.print("MNA_iter");
-                // RHS_iter.print("RHS_iter");
-                std::cout << "sim_value = " << sim_value << std::endl;
-                x_prev.print("x_prev");
-                x.print("x");
-                x_previter.print("x_previter");
-                arma::vec err = arma::abs(x - x_previter);
-                arma::vec err_rel = rel_tol * arma::abs(x_previter);
-                err.print("err");
-                err_rel.print("err_rel");
-                qDebug() << "status_abs: " << status_abs
-                         << " status_rel: " << status_rel;
+bool Simulation::solveHomotopy(arma::vec& x) {
+    // Newton 同伦：H(x, t) = F(x) - (1 - t) F(x_0)，t 从 0 增大到 1。
+    // t = 0 时初值 x_0 就是解，只需把 (1 - t) F(x_0) 加到 RHS 上
+    arma::vec r0;
+    computeResidual(x, r0);
+    if (!r0.is_finite()) {
+        qDebug() << "solveHomotopy() Residual at the initial guess"
+                 << "is not finite";
+        return false;
+    }
+    arma::vec x_good = x;
+    double t = 0;
+    double step = HOMOTOPY_INITIAL_STEP;
+    while (t < 1 && step >= HOMOTOPY_MIN_STEP) {
+        double next = std::min(t + step, 1.0);
+        rhs_base = rhs_source + (1 - next) * r0;
+        if (solveNewton(x, NEWTON_STEPPING_MAX_ITER)) {
+            homotopy_step_count++;
+            t = next;
+            x_good = x;
+            step *= 2;
+        } else {
+            x = x_good;
+            step /= 4;
+        }
+    }
+    rhs_base = rhs_source;
+    return t >= 1;
+}
+
+void Simulation::computeResidual(const arma::vec& x, arma::vec& r) {
+    // 结电压与 solveNewton 一样做 pnjlim 限制，失败的初值可能带着
+    // 几十伏的结电压，直接求值 exp 会溢出成 inf。限制后得到的是二极管
+    // 在限制电压处线性化后的残差，是 F(x) 的一阶近似
+    const DiodeTable& diodes = DEV_T->diodes;
+    for (int k = 0; k < diodes.size(); k++) {
+        int id_nplus = diodes.nplus[k];
+        int id_nminus = diodes.nminus[k];
+        double v_nplus = id_nplus >= 0 ? x(id_nplus) : 0;
+        double v_nminus = id_nminus >= 0 ? x(id_nminus) : 0;
+        double v_old = diode_v(k);
+        bool limited_k;
+        diode_v(k) = diodes.limitVoltage(k, v_nplus - v_nminus,
+                                         std::isnan(v_old) ? 0 : v_old,
+                                         limited_k);
+    }
+    diodes.evaluate(diode_v.memptr(), diode_i.memptr(), diode_g.memptr());
+    diode_eval_count += diodes.size();
+    restampDiodes();
+    r = op_stamps.getMatrix() * x - rhs_iter;
+}
+
+void Simulation::stampDiodeUpdate(int k) {
+    // gmin 与结并联，只改变电导，不改变等效电流源
+    double gk = diode_g(k) + op_gmin;
+    double jk = diode_i(k) - diode_g(k) * diode_v(k);
+    StampMapSink<arma::vec> sink(op_stamps, rhs_iter);
+    DiodeStamp(DEV_T->diodes)
+        .newton(k, gk - diode_stamped_g(k), jk - diode_stamped_j(k), sink);
+
+    diode_stamped_g(k) = gk;
+    diode_stamped_j(k) = jk;
+    diode_peak_g(k) = std::max(diode_peak_g(k), std::abs(gk));
+    diode_peak_j(k) = std::max(diode_peak_j(k), std::abs(jk));
+}
+
+void Simulation::restampDiodes() {
+    op_stamps.resetValues();
+    rhs_iter = rhs_base;
+    diode_stamped_g.zeros();
+    diode_stamped_j.zeros();
+    diode_peak_g.zeros();
+    diode_peak_j.zeros();
+    if (op_pseudo_g != 0) {
+        for (int slot : pseudo_slots) {
+            op_stamps.addValue(slot, op_pseudo_g);
+        }
+    }
+    for (int k = 0; k < DEV_T->diodes.size(); k++) {
+        stampDiodeUpdate(k);
+    }
+}
+
+void Simulation::setupCondensation() {
+    // 端口：每个二极管的两端节点和支路
+    const DiodeTable& diodes = DEV_T->diodes;
+    std::vector<int> ports;
+    for (int k = 0; k < diodes.size(); k++) {
+        ports.push_back(diodes.nplus[k]);
+        ports.push_back(diodes.nminus[k]);
+        ports.push_back(diodes.branch[k]);
+    }
+
+    // values = base，即不含二极管的线性部分
+    op_stamps.resetValues();
+    if (!op_condenser.setup(op_stamps.getMatrix(), ports)) {
+        qDebug() << "Simulation::setupCondensation() failed, "
+                    "solving the full system instead.";
+        return;
+    }
+
+    diode_ports.clear();
+    for (int k = 0; k < diodes.size(); k++) {
+        DiodePorts local;
+        local.nplus = op_condenser.getPortIndex(diodes.nplus[k]);
+        local.nminus = op_condenser.getPortIndex(diodes.nminus[k]);
+        local.branch = op_condenser.getPortIndex(diodes.branch[k]);
+        diode_ports.push_back(local);
+    }
+}
+
+bool Simulation::solveOneOPCondensed(const arma::vec& x_prev, arma::vec& x) {
+    arma::vec rhs_port;
+    if (!op_condenser.condenseRHS(rhs_base, rhs_port)) {
+        return false;
+    }
+
+    const std::vector<int>& ports = op_condenser.getPorts();
+    int port_num = op_condenser.getPortNum();
+    arma::vec x_port(port_num);
+    for (int p = 0; p < port_num; p++) {
+        x_port(p) = x_prev(ports[p]);
+    }
+    arma::vec x_port_prev = x_port;
+
+    // 与 solveNewton 相同的 Newton 迭代（有结电压限制，没有阻尼），
+    // 只是方程换成端口上的稠密方程，收敛判据也只检查端口变量
+    // （内部变量是端口变量的线性函数）；不收敛时回到完整方程
+    const DiodeTable& diodes = DEV_T->diodes;
+    DiodeStamp diode_stamp(diodes);
+    arma::mat MNA_port;
+    arma::vec RHS_port;
+    for (int iter = 0; iter < max_iter; iter++) {
+        newton_iter_count++;
+        MNA_port = op_condenser.getSchur();
+        RHS_port = rhs_port;
+
+        x_port_prev = x_port;
+
+        bool limited = false;
+        for (int k = 0; k < diodes.size(); k++) {
+            const DiodePorts& local = diode_ports[k];
+            double v_nplus = local.nplus >= 0 ? x_port_prev(local.nplus) : 0;
+            double v_nminus =
+                local.nminus >= 0 ? x_port_prev(local.nminus) : 0;
+            double v_old = diode_v(k);
+            bool limited_k;
+            diode_v(k) = diodes.limitVoltage(k, v_nplus - v_nminus,
+                                             std::isnan(v_old) ? 0 : v_old,
+                                             limited_k);
+            limited = limited || limited_k;
+        }
+        diodes.evaluate(diode_v.memptr(), diode_i.memptr(), diode_g.memptr());
+
+        // Schur 补和凝聚后的右端项在二极管支路行上为 0，直接累加
+        IndexedMatrixSink<arma::mat, arma::vec> sink(
+            op_condenser.getPortIndex(), MNA_port, RHS_port);
+        for (int k = 0; k < diodes.size(); k++) {
+            diode_stamp.newton(k, diode_g(k),
+                               diode_i(k) - diode_g(k) * diode_v(k), sink);
+        }
+
+        bool status = arma::solve(x_port, MNA_port, RHS_port);
+        if (!status) {
+            // 回到完整方程上求解（带行列平衡和迭代精化）
+            qDebug() << "solveOneOPCondensed() solve failed, iter: " << iter;
+            return false;
+        } else {
+            arma::vec err = arma::abs(x_port - x_port_prev);
+            bool status_abs = all(err <= abs_tol);
+            bool status_rel = all(err <= rel_tol * arma::abs(x_port_prev));
+            if (status_abs && status_rel && !limited) {
+                // 只在收敛的工作点恢复完整解
+                op_condenser.recover(x_port, x);
+                return true;
             }
-            */
         }
     }
 
-    std::cout << "solveOneOP() Warning: sim_value = " << sim_value
-              << ", max_iter reached, cannot converge." << std::endl;
-    // x.print("x");
-    return x;
+    // 交给完整方程上的 Newton 和后备策略
+    qDebug() << "solveOneOPCondensed() max_iter reached, sim_value ="
+             << sim_value;
+    return false;
 }
 
-DCSimulation::DCSimulation(Analysis& analysis_,
-                           Netlist& netlist_,
-                           Nodes& nodes_,
-                           Branches& branches_)
-    : Simulation(analysis_, netlist_, nodes_, branches_) {
+DCSimulation::DCSimulation(const Analysis& analysis_,
+                           const Netlist& netlist_,
+                           const Nodes& nodes_,
+                           const Branches& branches_)
+    : Simulation(analysis_, netlist_, nodes_, branches_),
+      sweep_first(0),
+      segment_num(1),
+      hysteresis_count(0),
+      seed_iter_count(0),
+      check_iter_count(0) {
     MNA_DC_T = new arma::sp_mat(*MNA_T);
     RHS_DC_T = new arma::vec(*RHS_T);
 }
 
+DCSimulation::~DCSimulation() {
+    delete MNA_DC_T;
+    delete RHS_DC_T;
+}
+
 void DCSimulation::runSimulation() {
     if (MNA_DC_T == nullptr || RHS_DC_T == nullptr) {
         qDebug() << "MNA_DC_T or RHS_DC_T is nullptr.";
@@ -168,8 +743,11 @@ void DCSimulation::runSimulation() {
     qDebug() << "DCSimulation::runSimulation()";
 
     arma::vec x = *RHS_DC_T;  // (偷懒)直接用 RHS_DC_T 作为默认值
-    x.shed_row(0);            // 去掉 ground node
 
+    // 扫描点的 RHS = rhs_fixed + value * drhs，drhs 也是切线预测使用的
+    // RHS 对扫描值的导数
+    rhs_fixed = *RHS_DC_T;
+    drhs.zeros(RHS_DC_T->n_elem);
     switch (source_type) {
         case (COMPONENT_VOLTAGE_SOURCE): {
             qDebug() << "DCSimulation::runSimulation() source: "
@@ -183,18 +761,8 @@ void DCSimulation::runSimulation() {
             int id_vsrc =
                 dynamic_cast<VoltageSource*>(voltage_source)->getIdBranch();
 
-            for (double voltage : analysis.sim_values) {
-                sim_value = voltage;
-
-                arma::sp_mat MNA_DC = *MNA_DC_T;
-                arma::vec RHS_DC = *RHS_DC_T;
-                arma::vec x_prev = x;
-
-                RHS_DC(id_vsrc) = voltage;
-
-                x = solveOneOP(MNA_DC, RHS_DC, x_prev);
-                sim_results.push_back(x);
-            }
+            rhs_fixed(id_vsrc) = 0;
+            drhs(id_vsrc) = 1;
             break;
         }
         case (COMPONENT_CURRENT_SOURCE): {
@@ -213,27 +781,231 @@ void DCSimulation::runSimulation() {
                 dynamic_cast<CurrentSource*>(netlist.getComponentPtr(source))
                     ->getIdNminus();
 
-            for (double current : analysis.sim_values) {
-                sim_value = current;
-
-                arma::sp_mat MNA_DC = *MNA_DC_T;
-                arma::vec RHS_DC = *RHS_DC_T;
-                arma::vec x_prev = x;
-
-                RHS_DC(id_nplus) = -current;
-                RHS_DC(id_nminus) = current;
-
-                x = solveOneOP(MNA_DC, RHS_DC, x_prev);
-                sim_results.push_back(x);
-            }
+            stampSet(rhs_fixed, id_nplus, 0.0);
+            stampSet(rhs_fixed, id_nminus, 0.0);
+            stampSet(drhs, id_nplus, -1.0);
+            stampSet(drhs, id_nminus, 1.0);
             break;
         }
         default:
             qDebug() << "DCSimulation::runSimulation() Unknown source type.";
-            break;
+            return;
+    }
+
+    // 分段多线程扫描：各段先在段首独立求一次工作点作为初值，结果与顺序扫描
+    // 只在 Newton 容差内一致，所以只在 .OPTIONS THREADS=<n> (n > 1)
+    // 显式指定、且点数足够多时分段，默认仍按顺序扫描
+    int point_num = static_cast<int>(analysis.sim_values.size());
+    segment_num = 1;
+    if (analysis.sweep_threads > 1) {
+        segment_num = std::max(
+            1, std::min(analysis.sweep_threads,
+                        point_num / DC_SWEEP_MIN_SEGMENT_POINTS));
+    }
+    if (segment_num > 1) {
+        sweepSegments(x);
+    } else {
+        sweepRange(0, point_num, x);
+    }
+    if (analysis.print_stats) {
+        printSolverStats();
+        printSweepStats();
     }
 }
 
+void DCSimulation::sweepRange(int first, int last, arma::vec& x) {
+    if (sim_results.empty()) {
+        sweep_first = first;
+    }
+    for (int i = first; i < last; i++) {
+        solveSweepPoint(analysis.sim_values[i], x);
+    }
+}
+
+void DCSimulation::sweepSegments(const arma::vec& x_init) {
+    // 每段一个独立的 DCSimulation（各自的固定结构矩阵、线性求解器和
+    // 二极管缓存），先从 x_init 在段首的扫描值处独立求一次工作点
+    // （带完整的后备策略），以它为初值在段内顺序扫描。
+    // 各段的求解器分摊硬件线程，不再各自按硬件线程数并行
+    const std::vector<double>& values = analysis.sim_values;
+    int point_num = static_cast<int>(values.size());
+    std::vector<int> bounds(segment_num + 1);
+    std::vector<DCSimulation*> workers(segment_num);
+    for (int s = 0; s <= segment_num; s++) {
+        bounds[s] = static_cast<int>(static_cast<long long>(point_num) * s /
+                                     segment_num);
+    }
+    int inner_threads = std::max(
+        1, static_cast<int>(std::thread::hardware_concurrency()) / segment_num);
+    for (int s = 0; s < segment_num; s++) {
+        workers[s] = new DCSimulation(analysis, netlist, nodes, branches);
+        workers[s]->solver_threads = inner_threads;
+        workers[s]->rhs_fixed = rhs_fixed;
+        workers[s]->drhs = drhs;
+    }
+
+    auto sweep_segment = [&](int s) {
+        arma::vec x = x_init;
+        workers[s]->solveExtraPoint(values[bounds[s]], x,
+                                    workers[s]->seed_iter_count);
+        workers[s]->sweepRange(bounds[s], bounds[s + 1], x);
+    };
+    std::vector<std::thread> pool;
+    for (int s = 1; s < segment_num; s++) {
+        pool.emplace_back(sweep_segment, s);
+    }
+    sweep_segment(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    // 段间交叉检查：从前一段的末尾继续扫描到下一段的第一个点，
+    // 与该段独立求得的解比较。不同说明解是多值的（滞回），
+    // 按顺序扫描的语义以延续的解为准，由前一段的 worker 重新扫描这一段。
+    // 检查用的求解不计入工作点和 Newton 的统计，单独报告
+    DCSimulation* owner = workers[0];
+    appendResults(*owner, 0);
+    for (int s = 1; s < segment_num; s++) {
+        DCSimulation* next = workers[s];
+        arma::vec x = owner->predictSweepPoint(values[bounds[s]],
+                                               owner->sim_results.back());
+        size_t mark = owner->sim_results.size();
+        owner->solveExtraPoint(values[bounds[s]], x, check_iter_count);
+        if (isSameSolution(x, next->sim_results.front())) {
+            appendResults(*next, 0);
+            owner = next;
+        } else {
+            hysteresis_count++;
+            std::cout << "DCSimulation: sim_value = " << values[bounds[s]]
+                      << ", segment start differs from the continued sweep "
+                         "(multi-valued solution), re-sweeping the segment."
+                      << std::endl;
+            owner->sweepRange(bounds[s], bounds[s + 1], x);
+            appendResults(*owner, mark);
+        }
+    }
+
+    // 分段时本对象没有建立求解器，线性求解器的统计取第一段的（各段
+    // 结构相同，只是计数不同）；Newton 和旁路的计数合并后由调用者输出
+    if (analysis.print_stats) {
+        std::cout << "Linear solver statistics of segment 1 of "
+                  << segment_num << ":" << std::endl;
+        workers[0]->printLinearSolverStats();
+    }
+    for (DCSimulation* worker : workers) {
+        mergeSolverStats(*worker);
+        seed_iter_count += worker->seed_iter_count;
+        delete worker;
+    }
+}
+
+void DCSimulation::appendResults(const DCSimulation& other, size_t first) {
+    for (size_t i = first; i < other.sim_results.size(); i++) {
+        sim_results.push_back(other.sim_results[i]);
+        point_iterations.push_back(other.point_iterations[i]);
+    }
+}
+
+bool DCSimulation::isSameSolution(const arma::vec& a,
+                                  const arma::vec& b) const {
+    // 与 Newton 收敛判据同一量级的容差
+    for (arma::uword i = 0; i < a.n_elem; i++) {
+        double err = std::abs(a(i) - b(i));
+        double scale = std::max(std::abs(a(i)), std::abs(b(i)));
+        if (err > DC_SWEEP_MATCH_FACTOR * (abs_tol + rel_tol * scale)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DCSimulation::solveSweepPoint(double value, arma::vec& x) {
+    sim_value = value;
+    arma::vec x_prev = predictSweepPoint(value, x);
+    arma::vec RHS_DC = rhs_fixed + value * drhs;
+
+    long long iter_start = getNewtonIterCount();
+    x = solveOneOP(*MNA_DC_T, RHS_DC, x_prev);
+    point_iterations.push_back(
+        static_cast<int>(getNewtonIterCount() - iter_start));
+    sim_results.push_back(x);
+}
+
+void DCSimulation::solveExtraPoint(double value,
+                                   arma::vec& x,
+                                   long long& iterations) {
+    sim_value = value;
+    arma::vec RHS_DC = rhs_fixed + value * drhs;
+    iterations += solveUncountedOP(*MNA_DC_T, RHS_DC, x);
+}
+
+arma::vec DCSimulation::predictSweepPoint(double value,
+                                          const arma::vec& x_last) {
+    int n = static_cast<int>(sim_results.size());
+    int predictor = analysis.sweep_predictor;
+    if (n == 0 || predictor == SWEEP_PREDICTOR_NONE) {
+        return x_last;
+    }
+
+    // sim_results[i] 对应 analysis.sim_values[sweep_first + i]
+    const double* values = analysis.sim_values.data() + sweep_first;
+    const arma::vec& x1 = sim_results[n - 1];
+    double v1 = values[n - 1];
+    if (predictor == SWEEP_PREDICTOR_TANGENT) {
+        // F(x, value) = A(x) x - b(value) = 0 两边对扫描值求导：
+        // J dx/dvalue = db/dvalue，J 用上一点最后一次的线性化
+        arma::vec tangent(x1.n_elem, arma::fill::zeros);
+        if (!solveJacobian(drhs, tangent)) {
+            return x1;
+        }
+        return x1 + (value - v1) * tangent;
+    }
+    if (n == 1 || values[n - 2] == v1) {
+        return x1;
+    }
+    const arma::vec& x0 = sim_results[n - 2];
+    double v0 = values[n - 2];
+    if (predictor == SWEEP_PREDICTOR_QUADRATIC && n >= 3 &&
+        values[n - 3] != v0 && values[n - 3] != v1) {
+        // 过前三点的二次 Lagrange 插值多项式在 value 处的值
+        const arma::vec& xm = sim_results[n - 3];
+        double vm = values[n - 3];
+        double lm = (value - v0) * (value - v1) / ((vm - v0) * (vm - v1));
+        double l0 = (value - vm) * (value - v1) / ((v0 - vm) * (v0 - v1));
+        double l1 = (value - vm) * (value - v0) / ((v1 - vm) * (v1 - v0));
+        return lm * xm + l0 * x0 + l1 * x1;
+    }
+    // 线性外推
+    return x1 + ((value - v1) / (v1 - v0)) * (x1 - x0);
+}
+
+void DCSimulation::printSweepStats() const {
+    if (point_iterations.empty()) {
+        return;
+    }
+    static const char* names[] = {"none", "linear", "quadratic", "tangent"};
+    int predictor = analysis.sweep_predictor;
+    long long total = 0;
+    int max_point = 0;
+    for (int iterations : point_iterations) {
+        total += iterations;
+        max_point = std::max(max_point, iterations);
+    }
+    std::cout << "Sweep: predictor = "
+              << (predictor >= 0 && predictor <= 3 ? names[predictor] : "?")
+              << ", points = " << point_iterations.size()
+              << ", iterations = " << total << " (avg = "
+              << static_cast<double>(total) / point_iterations.size()
+              << ", max = " << max_point << ")";
+    if (segment_num > 1) {
+        std::cout << ", segments = " << segment_num
+                  << ", hysteresis = " << hysteresis_count
+                  << ", seed iterations = " << seed_iter_count
+                  << ", check iterations = " << check_iter_count;
+    }
+    std::cout << std::endl;
+}
+
 const std::vector<arma::vec>& DCSimulation::getIterResults() {
     if (sim_results.empty()) {
         qDebug() << "DCSimulation::getIterResults() sim_results is empty.";
@@ -245,108 +1017,286 @@ ACSimulation::ACSimulation(Analysis& analysis_,
                            Netlist& netlist_,
                            Nodes& nodes_,
                            Branches& branches_)
-    : Simulation(analysis_, netlist_, nodes_, branches_) {
-    std::complex<double> j(0, 1);
+    : Simulation(analysis_, netlist_, nodes_, branches_),
+      ac_solver_type(LINEAR_SOLVER_AUTO),
+      transfer_mode(AC_TRANSFER_OFF) {
     // 生成 AC 状态 MNA，复制 base MNA，将虚部置零
     arma::sp_mat MNA_zerofill = arma::sp_mat(size((*MNA_T)));
     MNA_AC_T = new arma::sp_cx_mat((*MNA_T), MNA_zerofill);
     arma::vec RHS_zerofill = arma::vec(size((*RHS_T)), arma::fill::zeros);
     RHS_AC_T = new arma::cx_vec((*RHS_T), RHS_zerofill);
 
-    // 生成 AC 状态 MNA 模板
-    for (VoltageSource* voltage_source : netlist.voltage_sources) {
-        double dc_voltage = voltage_source->getDCVoltage();
-        double ac_magnitude = voltage_source->getACMagnitude();
-        double ac_phase = voltage_source->getACPhase() / 180 * M_PI;
-        int id_branch = voltage_source->getIdBranch();
+    // 生成 AC 状态 RHS 模板：直流值上叠加交流激励
+    MatrixSink<arma::sp_cx_mat, arma::cx_vec> sink(*MNA_AC_T, *RHS_AC_T);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampACSource(sink);
+    });
+}
 
-        (*RHS_AC_T)(id_branch) = dc_voltage + ac_magnitude * exp(j * ac_phase);
+void ACSimulation::buildACStampMap(const arma::vec& x_op) {
+    int matrix_size = static_cast<int>(MNA_AC_T->n_rows);
+
+    const DiodeTable& diodes = DEV_T->diodes;
+    DiodeStamp diode_stamp(diodes);
+
+    // 结构：MNA 模板 + 电容 + 电感 + 二极管小信号电导
+    ac_stamps.clear();
+    ac_stamps.addPattern(*MNA_T);
+    PatternSink pattern(ac_stamps);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampSusceptance(pattern);
+    });
+    diode_stamp.stampSmallSignal(nullptr, nullptr, pattern);
+    ac_stamps.compile(matrix_size);
+    ac_stamps.loadBase(*MNA_T);
+    ac_stamps.resetValues();
+    ac_rhs = *RHS_AC_T;
+
+    // G：线性部分 + 使用 diode 静态工作点的小信号电导
+    arma::vec vd(diodes.size());
+    arma::vec id(diodes.size());
+    arma::vec gd(diodes.size());
+    for (int k = 0; k < diodes.size(); k++) {
+        int id_nplus = diodes.nplus[k];
+        int id_nminus = diodes.nminus[k];
+        double v_nplus = id_nplus >= 0 ? x_op(id_nplus) : 0;
+        double v_nminus = id_nminus >= 0 ? x_op(id_nminus) : 0;
+        vd(k) = v_nplus - v_nminus;
     }
-    for (CurrentSource* current_source : netlist.current_sources) {
-        int id_nplus = current_source->getIdNplus();
-        int id_nminus = current_source->getIdNminus();
-        double ac_magnitude = current_source->getACMagnitude();
-        double ac_phase = current_source->getACPhase() / 180 * M_PI;
+    diodes.evaluate(vd.memptr(), id.memptr(), gd.memptr());
+    arma::vec jd = id - gd % vd;
+    StampMapSink<arma::cx_vec> g_sink(ac_stamps, ac_rhs);
+    diode_stamp.stampSmallSignal(gd.memptr(), jd.memptr(), g_sink);
+    const arma::sp_mat& G = ac_stamps.getMatrix();
+    int nnz = ac_stamps.getNonzeroNum();
+    ac_conductance = arma::vec(G.values, nnz);
+
+    // B：Y(f) 的虚部为 f * B，接地一端的 slot 为 -1，直接丢弃
+    ac_susceptance.zeros(nnz);
+    SlotArraySink b_sink(ac_stamps, ac_susceptance.memptr());
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampSusceptance(b_sink);
+    });
+
+    // 复数方程没有迭代法，自动选择时在稠密 LU 和稀疏 LU 之间选
+    ac_solver_type = selectLinearSolver(analysis.linear_solver, matrix_size,
+                                        nnz, analysis.analysis_type, true);
+}
 
-        std::complex<double> ac_current = ac_magnitude * exp(j * ac_phase);
+void ACSimulation::buildWorkspaces(int thread_num) {
+    clearWorkspaces();
+
+    // 复数矩阵沿用 ac_stamps 的 CSC 结构，保留显式零元
+    const arma::sp_mat& G = ac_stamps.getMatrix();
+    int matrix_size = static_cast<int>(G.n_rows);
+    int nnz = ac_stamps.getNonzeroNum();
+    arma::uvec rowind(nnz);
+    arma::uvec colptr(matrix_size + 1);
+    for (int k = 0; k < nnz; k++) {
+        rowind(k) = G.row_indices[k];
+    }
+    for (int col = 0; col <= matrix_size; col++) {
+        colptr(col) = G.col_ptrs[col];
+    }
 
-        (*RHS_AC_T)(id_nplus) -= ac_current;
-        (*RHS_AC_T)(id_nminus) += ac_current;
+    // 多个工作区同时求解时，各求解器分摊硬件线程
+    int inner_threads = std::max(
+        1, static_cast<int>(std::thread::hardware_concurrency()) / thread_num);
+    workspaces.resize(thread_num);
+    for (ACWorkspace& ws : workspaces) {
+        ws.matrix =
+            arma::sp_cx_mat(rowind, colptr, arma::zeros<arma::cx_vec>(nnz),
+                            matrix_size, matrix_size, false);
+        ws.values = arma::access::rwp(ws.matrix.values);
+        ws.solver = createComplexLinearSolver(ac_solver_type);
+        if (thread_num > 1) {
+            ws.solver->setThreadNum(inner_threads);
+        }
     }
 }
 
-arma::cx_vec ACSimulation::solveOneFreq(arma::sp_cx_mat& MNA_AC,
-                                        arma::cx_vec& RHS_AC,
-                                        arma::vec& x_op,
-                                        double freq) const {
-    std::complex<double> j(0, 1);
+void ACSimulation::clearWorkspaces() {
+    for (ACWorkspace& ws : workspaces) {
+        delete ws.solver;
+    }
+    workspaces.clear();
+}
 
-    for (Capacitor* capacitor : netlist.capacitors) {
-        int id_nplus = capacitor->getIdNplus();
-        int id_nminus = capacitor->getIdNminus();
-        double capacitance = capacitor->getCapacitance();
+ACSimulation::~ACSimulation() {
+    clearWorkspaces();
+}
 
-        MNA_AC(id_nplus, id_nplus) += 2 * M_PI * freq * capacitance * j;
-        MNA_AC(id_nminus, id_nminus) += 2 * M_PI * freq * capacitance * j;
-        MNA_AC(id_nplus, id_nminus) -= 2 * M_PI * freq * capacitance * j;
-        MNA_AC(id_nminus, id_nplus) -= 2 * M_PI * freq * capacitance * j;
+bool ACSimulation::solveFreq(ACWorkspace& ws, double freq, arma::cx_vec& x) {
+    int nnz = static_cast<int>(ac_conductance.n_elem);
+    for (int k = 0; k < nnz; k++) {
+        ws.values[k] =
+            std::complex<double>(ac_conductance(k), freq * ac_susceptance(k));
     }
-    for (Inductor* inductor : netlist.inductors) {
-        double inductance = inductor->getInductance();
-        int id_branch = inductor->getIdBranch();
 
-        MNA_AC(id_branch, id_branch) -= 2 * M_PI * freq * inductance * j;
-    }
-    for (Diode* diode : netlist.diodes) {
-        int id_nplus = diode->getIdNplus();
-        int id_nminus = diode->getIdNminus();
-        DiodeModel* model = diode->getModel();
+    // qDebug() << "AC Simulation at frequency: " << freq;
+    // ws.matrix.print("MNA_AC");
+    // ac_rhs.print("RHS_AC");
 
-        // 使用 diode 静态工作点
-        double vk = x_op(id_nplus) - x_op(id_nminus);
-        double ik = model->calcCurrentAtVoltage(vk);
-        double gk = model->calcConductanceAtVoltage(vk);
-        double jk = ik - gk * vk;
+    // 结构不变，第一个频率之后只做数值分解
+    return ws.solver->factorize(ws.matrix) && ws.solver->solve(ac_rhs, x);
+}
 
-        MNA_AC(id_nplus, id_nplus) += gk;
-        MNA_AC(id_nplus, id_nminus) -= gk;
-        MNA_AC(id_nminus, id_nminus) += gk;
-        MNA_AC(id_nminus, id_nplus) -= gk;
-        RHS_AC(id_nplus) -= jk;
-        RHS_AC(id_nminus) += jk;
+void ACSimulation::sweepFreqRange(ACWorkspace& ws, int first, int last) {
+    int matrix_size = static_cast<int>(ac_rhs.n_elem);
+    for (int k = first; k < last; k++) {
+        double freq = analysis.sim_values[k];
+        bool status = solveFreq(ws, freq, sim_cresults[k]);
+        if (!status) {
+            qDebug() << "ACSimulation::sweepFreqRange() at frequency: " << freq
+                     << "solve failed.";
+            sim_cresults[k].zeros(matrix_size);
+        }
+        // 传递函数沿用这一频率的分解，只多做几次回代
+        if (!sim_transfer.empty() &&
+            !(status && solveTransfer(ws, sim_transfer[k]))) {
+            sim_transfer[k].zeros(transfer_index.size(), transfer_rhs.n_cols);
+        }
     }
+}
 
-    // exclude ground node
-    MNA_AC.shed_row(0);
-    MNA_AC.shed_col(0);
-    RHS_AC.shed_row(0);
+void ACSimulation::buildTransfer() {
+    transfer_mode = analysis.ac_transfer;
+    transfer_index.clear();
+    transfer_outputs.clear();
+    transfer_sources.clear();
+    if (transfer_mode == AC_TRANSFER_OFF) {
+        return;
+    }
+    int matrix_size = static_cast<int>(ac_rhs.n_elem);
+    int node_num = nodes.getNodeNumExgnd();
+
+    // 输入：AC 幅度不为零的独立源
+    const SourceTable& voltage_sources = DEV_T->voltage_sources;
+    const SourceTable& current_sources = DEV_T->current_sources;
+    std::vector<int> voltage_index;
+    std::vector<int> current_index;
+    for (int k = 0; k < voltage_sources.size(); k++) {
+        if (voltage_sources.ac_magnitude[k] != 0) {
+            voltage_index.push_back(k);
+        }
+    }
+    for (int k = 0; k < current_sources.size(); k++) {
+        if (current_sources.ac_magnitude[k] != 0) {
+            current_index.push_back(k);
+        }
+    }
+    int source_num =
+        static_cast<int>(voltage_index.size() + current_index.size());
+    transfer_rhs.zeros(matrix_size, source_num);
+    int col = 0;
+    for (int k : voltage_index) {
+        transfer_rhs(voltage_sources.branch[k], col++) = 1;
+        transfer_sources.push_back(voltage_sources.name[k]);
+    }
+    for (int k : current_index) {
+        // 方向与 CurrentSourceStamp::acSource 相同
+        if (current_sources.nplus[k] >= 0) {
+            transfer_rhs(current_sources.nplus[k], col) -= 1.0;
+        }
+        if (current_sources.nminus[k] >= 0) {
+            transfer_rhs(current_sources.nminus[k], col) += 1.0;
+        }
+        col++;
+        transfer_sources.push_back(current_sources.name[k]);
+    }
 
-    // check if the matrix is singular
-    /*
-    arma::cx_mat MNA_AC_dense =
-        arma::conv_to<arma::cx_mat>::from(MNA_AC);
-    if (std::abs(arma::det(MNA_AC_dense)) < 1e-5) {
-        qDebug() << "The matrix MNA_AC is singular.";
-        continue;
+    // 输出：.PRINT AC 中的节点电压和支路电流，重复的只算一次
+    for (const Output* output : netlist.outputs) {
+        if (output->output_type != ANALYSIS_PRINT ||
+            output->analysis_type != TOKEN_ANALYSIS_AC) {
+            continue;
+        }
+        for (const Variable& var : output->var_list) {
+            bool voltage = var.type >= TOKEN_VAR_VOLTAGE_REAL &&
+                           var.type <= TOKEN_VAR_VOLTAGE_DB;
+            for (const std::string& name : var.nodes) {
+                int index = -1;
+                if (voltage) {
+                    index = nodes.getNodeIndexExgnd(name);
+                } else if (branches.getBranchIndex(name) >= 0) {
+                    index = branches.getBranchIndex(name) + node_num;
+                }
+                if (index < 0 || index >= matrix_size ||
+                    std::find(transfer_index.begin(), transfer_index.end(),
+                              index) != transfer_index.end()) {
+                    continue;
+                }
+                transfer_index.push_back(index);
+                transfer_outputs.push_back((voltage ? "V(" : "I(") + name +
+                                           ")");
+            }
+        }
+    }
+    int output_num = static_cast<int>(transfer_index.size());
+    if (source_num == 0 || output_num == 0) {
+        qDebug() << "ACSimulation::buildTransfer() no AC source or output.";
+        transfer_mode = AC_TRANSFER_OFF;
+        return;
     }
-    */
 
-    // qDebug() << "AC Simulation at frequency: " << freq;
-    // MNA_AC.print("MNA_AC");
-    // RHS_AC.print("RHS_AC");
+    // 直接法每个源一次回代，伴随法每个输出一次回代，取次数少的
+    if (transfer_mode == AC_TRANSFER_AUTO) {
+        transfer_mode = source_num > output_num ? AC_TRANSFER_ADJOINT
+                                                : AC_TRANSFER_DIRECT;
+    }
+    if (transfer_mode == AC_TRANSFER_ADJOINT) {
+        transfer_probe.zeros(matrix_size, output_num);
+        for (int o = 0; o < output_num; o++) {
+            transfer_probe(transfer_index[o], o) = 1;
+        }
+    }
+}
 
-    arma::cx_vec x;
-    bool status = arma::spsolve(x, MNA_AC, RHS_AC);
-    // printf("status: %d\n", status);
-    if (!status) {
-        qDebug() << "ACSimulation::solveOneFreq() at frequency: " << freq
-                 << "solve failed.";
-        arma::vec x_op_zerofill = arma::vec(size(x_op), arma::fill::zeros);
-        return arma::cx_vec(x_op, x_op_zerofill);
+bool ACSimulation::solveTransfer(ACWorkspace& ws, arma::cx_mat& H) {
+    int output_num = static_cast<int>(transfer_index.size());
+    int source_num = static_cast<int>(transfer_rhs.n_cols);
+    int matrix_size = static_cast<int>(transfer_rhs.n_rows);
+    H.zeros(output_num, source_num);
+    if (transfer_mode == AC_TRANSFER_ADJOINT) {
+        // Y^T W = E，H = W^T B：W 的第 o 列是输出 o 对各行激励的灵敏度
+        arma::cx_mat W;
+        if (!ws.solver->solveTransposed(transfer_probe, W)) {
+            return false;
+        }
+        for (int s = 0; s < source_num; s++) {
+            for (int i = 0; i < matrix_size; i++) {
+                std::complex<double> b = transfer_rhs(i, s);
+                if (b == 0.0) {
+                    continue;
+                }
+                for (int o = 0; o < output_num; o++) {
+                    H(o, s) += W(i, o) * b;
+                }
+            }
+        }
     } else {
-        // x.print("ACSimulation::solveOneFreq() x:");
-        return x;
+        // Y X = B，一次分解解所有源的右端项
+        arma::cx_mat X;
+        if (!ws.solver->solve(transfer_rhs, X)) {
+            return false;
+        }
+        for (int s = 0; s < source_num; s++) {
+            for (int o = 0; o < output_num; o++) {
+                H(o, s) = X(transfer_index[o], s);
+            }
+        }
     }
+    return true;
+}
+
+void ACSimulation::printTransferStats() const {
+    bool adjoint = transfer_mode == AC_TRANSFER_ADJOINT;
+    std::cout << "AC transfer: mode = " << (adjoint ? "adjoint" : "direct")
+              << ", sources = " << transfer_sources.size()
+              << ", outputs = " << transfer_outputs.size()
+              << ", solves per point = "
+              << (adjoint ? transfer_outputs.size() : transfer_sources.size())
+              << std::endl;
 }
 
 void ACSimulation::runSimulation() {
@@ -359,7 +1309,6 @@ void ACSimulation::runSimulation() {
 
     // 先忽略交流信号，求解非线性器件的静态工作点 //
     arma::vec x_op = *RHS_T;  // (偷懒)直接用 RHS_DC_T 作为默认值
-    x_op.shed_row(0);         // 去掉 ground node
 
     arma::sp_mat MNA_AC_OP = *MNA_T;
     arma::vec RHS_AC_OP = *RHS_T;
@@ -367,16 +1316,46 @@ void ACSimulation::runSimulation() {
     x_op = solveOneOP(MNA_AC_OP, RHS_AC_OP, x_op);  // 静态工作点
 
     // 运行 AC 分析，此时就是线性系统 //
-    arma::cx_vec x;
-    for (double freq : analysis.sim_values) {
-        sim_value = freq;
-
-        arma::sp_cx_mat MNA_AC = *MNA_AC_T;
-        arma::cx_vec RHS_AC = *RHS_AC_T;
+    buildACStampMap(x_op);
+
+    // 各频率点互相独立：分成连续的几段，每个线程用自己的工作区求解，
+    // 结果直接写入预先分配的位置，与顺序扫描完全相同
+    int point_num = static_cast<int>(analysis.sim_values.size());
+    int thread_num = std::max(
+        1, std::min(getThreadNum(), point_num / AC_SWEEP_MIN_THREAD_POINTS));
+    // 线程数确定后再生成工作区，每个线程一个求解器
+    buildWorkspaces(thread_num);
+    sim_cresults.assign(point_num, arma::cx_vec());
+    buildTransfer();
+    if (transfer_mode != AC_TRANSFER_OFF) {
+        sim_transfer.assign(point_num, arma::cx_mat());
+    }
 
-        x = solveOneFreq(MNA_AC, RHS_AC, x_op, freq);
+    std::vector<std::thread> pool;
+    for (int t = 1; t < thread_num; t++) {
+        pool.emplace_back([this, t, thread_num, point_num]() {
+            sweepFreqRange(workspaces[t], point_num * t / thread_num,
+                           point_num * (t + 1) / thread_num);
+        });
+    }
+    sweepFreqRange(workspaces[0], 0, point_num / thread_num);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (point_num > 0) {
+        sim_value = analysis.sim_values.back();
+    }
 
-        sim_cresults.push_back(x);
+    if (analysis.print_stats) {
+        std::cout << "Linear solver: " << workspaces[0].solver->getName();
+        if (thread_num > 1) {
+            std::cout << ", threads = " << thread_num;
+        }
+        std::cout << std::endl;
+        workspaces[0].solver->printStats();
+        if (hasTransfer()) {
+            printTransferStats();
+        }
     }
 }
 
@@ -406,73 +1385,62 @@ TranSimulation::TranSimulation(Analysis& analysis_,
 
     // 生成 Tran 状态 MNA 模板
     // 为 Capacitor 的 branch 进行调整
-    for (Capacitor* capacitor : netlist.capacitors) {
-        int id_nplus = capacitor->getIdNplus();
-        int id_nminus = capacitor->getIdNminus();
-        int id_branch = capacitor->getIdBranch();
-
-        (*MNA_TRAN_T)(id_nplus, id_branch) = 1;
-        (*MNA_TRAN_T)(id_nminus, id_branch) = -1;
-        // (*MNA_TRAN_T)(id_branch, id_branch) = -1;
-    }
+    MatrixSink<arma::sp_mat, arma::vec> sink(*MNA_TRAN_T, *RHS_TRAN_T);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampTranTemplate(sink);
+    });
+
+    // 结构：模板 + 伴随模型的位置（模板中数值为 0，稀疏矩阵里没有）
+    int matrix_size = static_cast<int>(MNA_TRAN_T->n_rows);
+    tran_stamps.addPattern(*MNA_TRAN_T);
+    PatternSink pattern(tran_stamps);
+    forEachDeviceStamp(*DEV_T, [&](const auto& devices) {
+        devices.stampTranTemplate(pattern);
+    });
+    tran_stamps.compile(matrix_size);
+    tran_stamps.loadBase(*MNA_TRAN_T);
 }
 
 arma::vec TranSimulation::tranBackEuler(double time,
                                         double h,
-                                        arma::vec x_prevtime) const {
-    arma::sp_mat MNA_TRAN = *MNA_TRAN_T;
+                                        arma::vec x_prevtime) {
+    tran_stamps.resetValues();
     arma::vec RHS_TRAN = *RHS_TRAN_T;
-    arma::vec x_prevtime_gnd = x_prevtime;
-    x_prevtime_gnd.insert_rows(0, arma::zeros(1));  // insert ground node
 
-    for (Capacitor* capacitor : netlist.capacitors) {
-        int id_nplus = capacitor->getIdNplus();
-        int id_nminus = capacitor->getIdNminus();
-        double capacitance = capacitor->getCapacitance();
-        int id_branch = capacitor->getIdBranch();
+    // 电容、电感的后向 Euler 伴随模型，按 slot 累加，不改变矩阵结构
+    const DeviceTables& dev = *DEV_T;
+    StampMapSink<arma::vec> sink(tran_stamps, RHS_TRAN);
+    forEachDeviceStamp(dev, [&](const auto& devices) {
+        devices.stampTranStep(h, x_prevtime, sink);
+    });
 
-        MNA_TRAN(id_branch, id_nplus) = capacitance / h;
-        MNA_TRAN(id_branch, id_nminus) = -capacitance / h;
-        RHS_TRAN(id_branch) =
-            capacitance / h *
-            (x_prevtime_gnd(id_nplus) - x_prevtime_gnd(id_nminus));
-    }
-
-    for (Inductor* inductor : netlist.inductors) {
-        double inductance = inductor->getInductance();
-        int id_branch = inductor->getIdBranch();
-
-        MNA_TRAN(id_branch, id_branch) = -inductance / h;
-        RHS_TRAN(id_branch) = -inductance / h * x_prevtime_gnd(id_branch);
-    }
-
-    for (VoltageSource* voltage_source : netlist.voltage_sources) {
-        if (voltage_source->getFunction() == nullptr) {
+    const SourceTable& vs = dev.voltage_sources;
+    for (int k = 0; k < vs.size(); k++) {
+        if (vs.function[k] == nullptr) {
             continue;  // 没有 function，直接使用 DC 电压，已在 MNA_TRAN_T
                        // 中存在
         }
-        int id_branch = voltage_source->getIdBranch();
-
-        RHS_TRAN(id_branch) = calcFunctionAtTime(voltage_source->getFunction(),
-                                                 time, tstep, tstop);
+        RHS_TRAN(vs.branch[k]) =
+            calcFunctionAtTime(vs.function[k], time, tstep, tstop);
     }
 
-    for (CurrentSource* current_source : netlist.current_sources) {
-        if (current_source->getFunction() == nullptr) {
+    const SourceTable& is = dev.current_sources;
+    for (int k = 0; k < is.size(); k++) {
+        if (is.function[k] == nullptr) {
             continue;  // 没有 function，直接使用 DC 电流，已在 MNA_TRAN_T
                        // 中存在
         }
-        int id_nplus = current_source->getIdNplus();
-        int id_nminus = current_source->getIdNminus();
-        double current_time = calcFunctionAtTime(current_source->getFunction(),
-                                                 time, tstep, tstop);
+        int id_nplus = is.nplus[k];
+        int id_nminus = is.nminus[k];
+        double current_time =
+            calcFunctionAtTime(is.function[k], time, tstep, tstop);
 
-        RHS_TRAN(id_nplus) = -current_time;
-        RHS_TRAN(id_nminus) = current_time;
+        stampSet(RHS_TRAN, id_nplus, -current_time);
+        stampSet(RHS_TRAN, id_nminus, current_time);
     }
 
     arma::vec x;
-    x = solveOneOP(MNA_TRAN, RHS_TRAN, x_prevtime);
+    x = solveOneOP(tran_stamps.getMatrix(), RHS_TRAN, x_prevtime);
 
     return x;
 }
@@ -493,77 +1461,81 @@ void TranSimulation::runSimulation() {
     arma::sp_mat* MNA_TRAN_0 = new arma::sp_mat(*MNA_TRAN_T);
     arma::vec* RHS_TRAN_0 = new arma::vec(*RHS_TRAN_T);
 
-    for (Capacitor* capacitor : netlist.capacitors) {
+    const DeviceTables& dev = *DEV_T;
+    for (int k = 0; k < dev.capacitors.size(); k++) {
         // 相当于无电流的电压源
-        int id_nplus = capacitor->getIdNplus();
-        int id_nminus = capacitor->getIdNminus();
-        double initial_voltage = capacitor->getInitialVoltage();
-        int id_branch = capacitor->getIdBranch();
-
-        (*MNA_TRAN_0)(id_nplus, id_branch) = 1;
-        (*MNA_TRAN_0)(id_nminus, id_branch) = -1;
-        (*MNA_TRAN_0)(id_branch, id_nplus) = 1;
-        (*MNA_TRAN_0)(id_branch, id_nminus) = -1;
-        (*MNA_TRAN_0)(id_branch, id_branch) = 0;
+        int id_nplus = dev.capacitors.nplus[k];
+        int id_nminus = dev.capacitors.nminus[k];
+        double initial_voltage = dev.capacitors.initial_voltage[k];
+        int id_branch = dev.capacitors.branch[k];
+
+        stampSet(*MNA_TRAN_0, id_nplus, id_branch, 1);
+        stampSet(*MNA_TRAN_0, id_nminus, id_branch, -1);
+        stampSet(*MNA_TRAN_0, id_branch, id_nplus, 1);
+        stampSet(*MNA_TRAN_0, id_branch, id_nminus, -1);
+        stampSet(*MNA_TRAN_0, id_branch, id_branch, 0);
         (*RHS_TRAN_0)(id_branch) = initial_voltage;
     }
-    for (Inductor* inductor : netlist.inductors) {
+    for (int k = 0; k < dev.inductors.size(); k++) {
         // 相当于无电压的电流源
-        int id_nplus = inductor->getIdNplus();
-        int id_nminus = inductor->getIdNminus();
-        double initial_current = inductor->getInitialCurrent();
-        int id_branch = inductor->getIdBranch();
-
-        (*MNA_TRAN_0)(id_nplus, id_branch) = 0;
-        (*MNA_TRAN_0)(id_nminus, id_branch) = 0;
-        (*MNA_TRAN_0)(id_branch, id_nplus) = 0;
-        (*MNA_TRAN_0)(id_branch, id_nminus) = 0;
-        (*MNA_TRAN_0)(id_branch, id_branch) = -1;
-        (*RHS_TRAN_0)(id_nplus) = -initial_current;
-        (*RHS_TRAN_0)(id_nminus) = initial_current;
+        int id_nplus = dev.inductors.nplus[k];
+        int id_nminus = dev.inductors.nminus[k];
+        double initial_current = dev.inductors.initial_current[k];
+        int id_branch = dev.inductors.branch[k];
+
+        stampSet(*MNA_TRAN_0, id_nplus, id_branch, 0);
+        stampSet(*MNA_TRAN_0, id_nminus, id_branch, 0);
+        stampSet(*MNA_TRAN_0, id_branch, id_nplus, 0);
+        stampSet(*MNA_TRAN_0, id_branch, id_nminus, 0);
+        stampSet(*MNA_TRAN_0, id_branch, id_branch, -1);
+        stampSet(*RHS_TRAN_0, id_nplus, -initial_current);
+        stampSet(*RHS_TRAN_0, id_nminus, initial_current);
         (*RHS_TRAN_0)(id_branch) = -initial_current;
     }
-    for (VoltageSource* voltage_source : netlist.voltage_sources) {
-        if (voltage_source->getFunction() == nullptr) {
+    const SourceTable& vs = dev.voltage_sources;
+    for (int k = 0; k < vs.size(); k++) {
+        if (vs.function[k] == nullptr) {
             continue;  // 没有 function，直接使用 DC 电压，已在 MNA_TRAN_T
                        // 中存在
         }
-        int id_branch = voltage_source->getIdBranch();
-
-        (*RHS_TRAN_0)(id_branch) =
-            calcFunctionAtTime(voltage_source->getFunction(), 0, h, tstop);
+        (*RHS_TRAN_0)(vs.branch[k]) =
+            calcFunctionAtTime(vs.function[k], 0, h, tstop);
     }
-    for (CurrentSource* current_source : netlist.current_sources) {
-        if (current_source->getFunction() == nullptr) {
+    const SourceTable& is = dev.current_sources;
+    for (int k = 0; k < is.size(); k++) {
+        if (is.function[k] == nullptr) {
             continue;  // 没有 function，直接使用 DC 电流，已在 MNA_TRAN_T
                        // 中存在
         }
-        int id_nplus = current_source->getIdNplus();
-        int id_nminus = current_source->getIdNminus();
-        double current_0 =
-            calcFunctionAtTime(current_source->getFunction(), 0, h, tstop);
+        int id_nplus = is.nplus[k];
+        int id_nminus = is.nminus[k];
+        double current_0 = calcFunctionAtTime(is.function[k], 0, h, tstop);
 
-        (*RHS_TRAN_0)(id_nplus) = -current_0;
-        (*RHS_TRAN_0)(id_nminus) = current_0;
+        stampSet(*RHS_TRAN_0, id_nplus, -current_0);
+        stampSet(*RHS_TRAN_0, id_nminus, current_0);
     }
-    for (Diode* diode : netlist.diodes) {
-        // 已知了起始电压，就已知静态工作点，相当于电流源与电阻并联
-        int id_nplus = diode->getIdNplus();
-        int id_nminus = diode->getIdNminus();
-        int id_branch = diode->getIdBranch();
-        DiodeModel* model = diode->getModel();
-
-        double v0 = diode->getInitialVoltage();
-        double i0 = model->calcCurrentAtVoltage(v0);
-        double g0 = model->calcConductanceAtVoltage(v0);
+    // 已知了起始电压，就已知静态工作点，相当于电流源与电阻并联
+    int diode_num = dev.diodes.size();
+    std::vector<double> i_0(diode_num);
+    std::vector<double> g_0(diode_num);
+    dev.diodes.evaluate(dev.diodes.initial_voltage.data(), i_0.data(),
+                        g_0.data());
+    for (int k = 0; k < diode_num; k++) {
+        int id_nplus = dev.diodes.nplus[k];
+        int id_nminus = dev.diodes.nminus[k];
+        int id_branch = dev.diodes.branch[k];
+
+        double v0 = dev.diodes.initial_voltage[k];
+        double i0 = i_0[k];
+        double g0 = g_0[k];
         double j0 = i0 - g0 * v0;
 
-        (*MNA_TRAN_0)(id_nplus, id_nplus) += g0;
-        (*MNA_TRAN_0)(id_nplus, id_nminus) -= g0;
-        (*MNA_TRAN_0)(id_nminus, id_nminus) += g0;
-        (*MNA_TRAN_0)(id_nminus, id_nplus) -= g0;
-        (*RHS_TRAN_0)(id_nplus) -= j0;
-        (*RHS_TRAN_0)(id_nminus) += j0;
+        stampAdd(*MNA_TRAN_0, id_nplus, id_nplus, g0);
+        stampAdd(*MNA_TRAN_0, id_nplus, id_nminus, -g0);
+        stampAdd(*MNA_TRAN_0, id_nminus, id_nminus, g0);
+        stampAdd(*MNA_TRAN_0, id_nminus, id_nplus, -g0);
+        stampAdd(*RHS_TRAN_0, id_nplus, -j0);
+        stampAdd(*RHS_TRAN_0, id_nminus, j0);
 
         // (*MNA_TRAN_0)(id_nplus, id_branch) = 0;
         // (*MNA_TRAN_0)(id_nminus, id_branch) = 0;
@@ -573,25 +1545,22 @@ void TranSimulation::runSimulation() {
         (*RHS_TRAN_0)(id_branch) = -i0;
     }
 
-    // exclude ground node
-    (*MNA_TRAN_0).shed_row(0);
-    (*MNA_TRAN_0).shed_col(0);
-    (*RHS_TRAN_0).shed_row(0);
-    // check if the matrix is singular
-    if (arma::det(arma::mat(*MNA_TRAN_0)) == 0) {
-        qDebug() << "Solving MNA_TRAN_0 and RHS_TRAN_0";
-        qDebug() << "The matrix is singular after shedding the first "
-                    "row and column, cannot solve the system.";
-        (*MNA_TRAN_0).print("MNA_TRAN_0");
-        (*RHS_TRAN_0).print("RHS_TRAN_0");
-        return;
-    }
-
     sim_value = 0;
-    bool status = arma::spsolve(x, (*MNA_TRAN_0), (*RHS_TRAN_0));
+    // 奇异矩阵由分解失败报告，不再做稠密的 det 检查
+    int solver_type = selectLinearSolver(
+        analysis.linear_solver, static_cast<int>(MNA_TRAN_0->n_rows),
+        static_cast<int>(MNA_TRAN_0->n_nonzero), analysis.analysis_type);
+    RealLinearSolver* solver_0 =
+        createLinearSolver(solver_type, analysis.preconditioner, nullptr,
+                           analysis.mixed_precision);
+    x.zeros(RHS_TRAN_0->n_elem);
+    bool status = solver_0->factorize(*MNA_TRAN_0) &&
+                  solver_0->solve(*RHS_TRAN_0, x);
+    delete solver_0;
     // printf("status: %d\n", status);
     if (!status) {
-        qDebug() << "TranSimulation::runSimulation() t = 0 solve failed.";
+        qDebug() << "Solving MNA_TRAN_0 and RHS_TRAN_0";
+        qDebug() << "The matrix is singular, cannot solve the system.";
         (*MNA_TRAN_0).print("MNA_TRAN_0");
         (*RHS_TRAN_0).print("RHS_TRAN_0");
         return;
@@ -633,6 +1602,9 @@ void TranSimulation::runSimulation() {
         // std::cout << "time: " << time << "\t";
         // x.print("TranSimulation() x:");
     }
+    if (analysis.print_stats) {
+        printSolverStats();
+    }
 }
 
 const std::vector<arma::vec>& TranSimulation::getIterResults() {
@@ -0,0 +1,299 @@
+#include "SmallDenseLU.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include "simd.h"
+
+// 选主元用的大小，复数时与 LAPACK 一样用 |re| + |im|
+static inline double pivotMagnitude(double value) {
+    return std::fabs(value);
+}
+
+static inline double pivotMagnitude(const std::complex<double>& value) {
+    return std::fabs(value.real()) + std::fabs(value.imag());
+}
+
+#if SIMD_DISPATCH
+SIMD_TARGET_AVX512 static void columnUpdateAVX512(int len,
+                                                  double alpha,
+                                                  const double* x,
+                                                  double* y) {
+    int i = 0;
+    __m512d va = _mm512_set1_pd(alpha);
+    for (; i + 8 <= len; i += 8) {
+        __m512d vy = _mm512_loadu_pd(y + i);
+        vy = _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + i), vy);
+        _mm512_storeu_pd(y + i, vy);
+    }
+    for (; i < len; i++) {
+        y[i] -= alpha * x[i];
+    }
+    _mm256_zeroupper();
+}
+
+SIMD_TARGET_AVX2 static void columnUpdateAVX2(int len,
+                                              double alpha,
+                                              const double* x,
+                                              double* y) {
+    int i = 0;
+    __m256d va = _mm256_set1_pd(alpha);
+    for (; i + 4 <= len; i += 4) {
+        __m256d vy = _mm256_loadu_pd(y + i);
+        vy = _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + i), vy);
+        _mm256_storeu_pd(y + i, vy);
+    }
+    for (; i < len; i++) {
+        y[i] -= alpha * x[i];
+    }
+    _mm256_zeroupper();
+}
+#endif
+
+// y -= alpha * x，消元和回代的内层循环，kernel 为 SIMD_KERNEL_*；
+// 不足一个向量长度时直接用标量循环，省去函数调用
+static inline void columnUpdate(int kernel,
+                                int len,
+                                double alpha,
+                                const double* x,
+                                double* y) {
+#if SIMD_DISPATCH
+    if (kernel == SIMD_KERNEL_AVX512 && len >= 8) {
+        columnUpdateAVX512(len, alpha, x, y);
+        return;
+    }
+    if (kernel != SIMD_KERNEL_SCALAR && len >= 4) {
+        columnUpdateAVX2(len, alpha, x, y);
+        return;
+    }
+#endif
+    for (int i = 0; i < len; i++) {
+        y[i] -= alpha * x[i];
+    }
+}
+
+static inline void columnUpdate(int,
+                                int len,
+                                const std::complex<double>& alpha,
+                                const std::complex<double>* x,
+                                std::complex<double>* y) {
+    // 展开复数乘法，避免 std::complex 对 inf / nan 的额外处理
+    double ar = alpha.real();
+    double ai = alpha.imag();
+    for (int i = 0; i < len; i++) {
+        double xr = x[i].real();
+        double xi = x[i].imag();
+        y[i] = std::complex<double>(y[i].real() - (ar * xr - ai * xi),
+                                    y[i].imag() - (ar * xi + ai * xr));
+    }
+}
+
+// N > 0 时阶数在编译期确定，循环可以完全展开；N = 0 时使用 n_runtime
+template <typename eT, int N>
+static bool factorKernel(eT* a, int* perm, int n_runtime, int kernel) {
+    const int n = N > 0 ? N : n_runtime;
+    for (int k = 0; k < n; k++) {
+        eT* col_k = a + k * n;
+
+        // 列主元
+        int p = k;
+        double max_mag = pivotMagnitude(col_k[k]);
+        for (int i = k + 1; i < n; i++) {
+            double mag = pivotMagnitude(col_k[i]);
+            if (mag > max_mag) {
+                max_mag = mag;
+                p = i;
+            }
+        }
+        if (!(max_mag > 0) || !std::isfinite(max_mag)) {
+            return false;
+        }
+        if (p != k) {
+            for (int j = 0; j < n; j++) {
+                std::swap(a[j * n + k], a[j * n + p]);
+            }
+            std::swap(perm[k], perm[p]);
+        }
+
+        // L 的第 k 列
+        eT inv = eT(1) / col_k[k];
+        for (int i = k + 1; i < n; i++) {
+            col_k[i] *= inv;
+        }
+
+        // 右下角更新，按列进行，内层连续访问
+        for (int j = k + 1; j < n; j++) {
+            eT* col_j = a + j * n;
+            eT ukj = col_j[k];
+            if (ukj != eT(0)) {
+                columnUpdate(kernel, n - k - 1, ukj, col_k + k + 1,
+                             col_j + k + 1);
+            }
+        }
+    }
+    return true;
+}
+
+template <typename eT, int N>
+static void solveKernel(const eT* a, int n_runtime, int kernel, eT* y) {
+    const int n = N > 0 ? N : n_runtime;
+    // L y = P b，y 已经按 perm 排好
+    for (int k = 0; k < n; k++) {
+        if (y[k] != eT(0)) {
+            columnUpdate(kernel, n - k - 1, y[k], a + k * n + k + 1,
+                         y + k + 1);
+        }
+    }
+    // U x = y
+    for (int k = n - 1; k >= 0; k--) {
+        y[k] /= a[k * n + k];
+        if (y[k] != eT(0)) {
+            columnUpdate(kernel, k, y[k], a + k * n, y);
+        }
+    }
+}
+
+template <typename eT>
+SmallDenseLU<eT>::SmallDenseLU()
+    : factored(false),
+      n(0),
+      kernel(getSimdKernel()),
+      factor_count(0),
+      solve_count(0) {
+    setKernel(kernel);
+}
+
+template <typename eT>
+void SmallDenseLU<eT>::setKernel(int kernel_) {
+    // 复数没有向量化的内核；实数不超过 CPU 支持的一级
+    if (!std::is_same<eT, double>::value) {
+        kernel = SIMD_KERNEL_SCALAR;
+    } else {
+        kernel = std::max(SIMD_KERNEL_SCALAR,
+                          std::min(kernel_, getSimdKernel()));
+    }
+}
+
+template <typename eT>
+bool SmallDenseLU<eT>::factorize(const arma::SpMat<eT>& A) {
+    factored = false;
+    if (A.n_rows != A.n_cols || A.n_rows > SMALL_DENSE_MAX_SIZE) {
+        return false;
+    }
+    n = static_cast<int>(A.n_rows);
+
+    std::fill(lu, lu + n * n, eT(0));
+    for (int j = 0; j < n; j++) {
+        for (arma::uword p = A.col_ptrs[j]; p < A.col_ptrs[j + 1]; p++) {
+            lu[j * n + A.row_indices[p]] = A.values[p];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+
+    bool status;
+    switch (n) {
+        case 4:
+            status = factorKernel<eT, 4>(lu, perm, n, kernel);
+            break;
+        case 8:
+            status = factorKernel<eT, 8>(lu, perm, n, kernel);
+            break;
+        case 16:
+            status = factorKernel<eT, 16>(lu, perm, n, kernel);
+            break;
+        case 32:
+            status = factorKernel<eT, 32>(lu, perm, n, kernel);
+            break;
+        default:
+            status = factorKernel<eT, 0>(lu, perm, n, kernel);
+    }
+    if (!status) {
+        return false;
+    }
+    factored = true;
+    factor_count++;
+    return true;
+}
+
+template <typename eT>
+bool SmallDenseLU<eT>::solve(const arma::Col<eT>& b, arma::Col<eT>& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+    // 在栈上求解，b 和 x 可以是同一个向量
+    eT y[SMALL_DENSE_MAX_SIZE];
+    for (int i = 0; i < n; i++) {
+        y[i] = b(perm[i]);
+    }
+    switch (n) {
+        case 4:
+            solveKernel<eT, 4>(lu, n, kernel, y);
+            break;
+        case 8:
+            solveKernel<eT, 8>(lu, n, kernel, y);
+            break;
+        case 16:
+            solveKernel<eT, 16>(lu, n, kernel, y);
+            break;
+        case 32:
+            solveKernel<eT, 32>(lu, n, kernel, y);
+            break;
+        default:
+            solveKernel<eT, 0>(lu, n, kernel, y);
+    }
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(i) = y[i];
+    }
+    solve_count++;
+    return true;
+}
+
+template <typename eT>
+bool SmallDenseLU<eT>::solveTransposed(const arma::Col<eT>& b,
+                                       arma::Col<eT>& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+    // P A = L U，A^T = U^T L^T P；U^T、L^T 的行就是 lu 的列，按内积求解
+    eT y[SMALL_DENSE_MAX_SIZE];
+    for (int j = 0; j < n; j++) {
+        const eT* col_j = lu + j * n;
+        eT yj = b(j);
+        for (int i = 0; i < j; i++) {
+            yj -= col_j[i] * y[i];
+        }
+        y[j] = yj / col_j[j];
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        const eT* col_j = lu + j * n;
+        eT yj = y[j];
+        for (int i = j + 1; i < n; i++) {
+            yj -= col_j[i] * y[i];
+        }
+        y[j] = yj;
+    }
+    x.set_size(n);
+    for (int i = 0; i < n; i++) {
+        x(perm[i]) = y[i];
+    }
+    solve_count++;
+    return true;
+}
+
+template <typename eT>
+const char* SmallDenseLU<eT>::getKernelName() const {
+    return getSimdKernelName(kernel);
+}
+
+template <typename eT>
+void SmallDenseLU<eT>::printStats() const {
+    std::cout << "SmallDenseLU: n = " << n << ", kernel = " << getKernelName()
+              << ", factor = " << factor_count << ", solve = " << solve_count
+              << std::endl;
+}
+
+template class SmallDenseLU<double>;
+template class SmallDenseLU<std::complex<double>>;
@@ -0,0 +1,686 @@
+#include "SparseLU.h"
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include "Ordering.h"
+
+static inline bool isFiniteValue(double value) {
+    return std::isfinite(value);
+}
+
+static inline bool isFiniteValue(const std::complex<double>& value) {
+    return std::isfinite(value.real()) && std::isfinite(value.imag());
+}
+
+// 并行回代时每一层结束后同步，层数多而每层很短，用自旋而不用条件变量
+class SpinBarrier {
+   public:
+    explicit SpinBarrier(int count_) : count(count_), waiting(0), phase(0) {}
+
+    void wait() {
+        int current = phase.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (phase.load(std::memory_order_acquire) == current) {
+            std::this_thread::yield();
+        }
+    }
+
+   private:
+    int count;
+    std::atomic<int> waiting;
+    std::atomic<int> phase;
+};
+
+template <typename eT>
+BasicSparseLU<eT>::BasicSparseLU()
+    : analyzed(false),
+      factored(false),
+      n(0),
+      parallel_solve(false),
+      thread_num(std::max(1u, std::thread::hardware_concurrency())),
+      parallel_min_size(200000),
+      ordering(ORDERING_AMD),
+      pivot_tol(0.1),
+      refactor_tol(1e-3),
+      analyze_count(0),
+      factor_count(0),
+      refactor_count(0) {}
+
+template <typename eT>
+BasicSparseLU<eT>::~BasicSparseLU() {}
+
+template <typename eT>
+void BasicSparseLU<eT>::loadPattern(const arma::SpMat<eT>& A) {
+    n = static_cast<int>(A.n_cols);
+    Ap.assign(n + 1, 0);
+    Ai.clear();
+    Ax.clear();
+    Ai.reserve(A.n_nonzero);
+    Ax.reserve(A.n_nonzero);
+    for (typename arma::SpMat<eT>::const_iterator it = A.begin();
+         it != A.end(); ++it) {
+        Ap[it.col() + 1]++;
+        Ai.push_back(static_cast<int>(it.row()));
+        Ax.push_back(*it);
+    }
+    for (int col = 0; col < n; col++) {
+        Ap[col + 1] += Ap[col];
+    }
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::loadValues(const arma::SpMat<eT>& A) {
+    // 结构检查与数值复制在同一次遍历中完成
+    if (!analyzed || static_cast<int>(A.n_cols) != n ||
+        static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_nonzero) != static_cast<int>(Ai.size())) {
+        return false;
+    }
+    int p = 0;
+    for (typename arma::SpMat<eT>::const_iterator it = A.begin();
+         it != A.end(); ++it) {
+        int col = static_cast<int>(it.col());
+        if (Ai[p] != static_cast<int>(it.row()) || p < Ap[col] ||
+            p >= Ap[col + 1]) {
+            return false;
+        }
+        Ax[p++] = (*it);
+    }
+    return true;
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::samePattern(const arma::SpMat<eT>& A) const {
+    if (!analyzed || static_cast<int>(A.n_cols) != n ||
+        static_cast<int>(A.n_rows) != n ||
+        static_cast<int>(A.n_nonzero) != static_cast<int>(Ai.size())) {
+        return false;
+    }
+    int p = 0;
+    for (typename arma::SpMat<eT>::const_iterator it = A.begin();
+         it != A.end(); ++it) {
+        int col = static_cast<int>(it.col());
+        if (Ai[p] != static_cast<int>(it.row()) || p < Ap[col] ||
+            p >= Ap[col + 1]) {
+            return false;
+        }
+        p++;
+    }
+    return true;
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::factorize(const arma::SpMat<eT>& A) {
+    if (!loadValues(A)) {
+        // 结构变化，重新排序
+        return analyze(A) && factorNumeric();
+    }
+    if (factored && refactorNumeric()) {
+        return true;
+    }
+    // 主元过小，重新选主元（列排序不变）
+    return factorNumeric();
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::analyze(const arma::SpMat<eT>& A) {
+    if (A.n_rows != A.n_cols) {
+        qDebug() << "SparseLU::analyze() matrix is not square.";
+        return false;
+    }
+    loadPattern(A);
+    q = computeOrdering(ordering, n, Ap, Ai);
+
+    Lp.assign(n + 1, 0);
+    Up.assign(n + 1, 0);
+    pinv.assign(n, -1);
+    prow.assign(n, -1);
+    prow_prev.assign(n, -1);
+    work_x.assign(n, 0);
+    work_xi.assign(n, 0);
+    work_stack.assign(2 * n, 0);
+    work_mark.assign(n, -1);
+    work_y.assign(n, 0);
+
+    analyzed = true;
+    factored = false;
+    analyze_count++;
+    return true;
+}
+
+template <typename eT>
+int BasicSparseLU<eT>::reach(int k, int col) {
+    // 从 A(:,col) 的每个非零行出发，在 L 的图上做 DFS，
+    // 拓扑序存放在 work_xi[top..n-1]
+    int top = n;
+    int* node_stack = work_stack.data();
+    int* pos_stack = work_stack.data() + n;
+    for (int p = Ap[col]; p < Ap[col + 1]; p++) {
+        int start = Ai[p];
+        if (work_mark[start] == k) {
+            continue;
+        }
+        int head = 0;
+        node_stack[0] = start;
+        while (head >= 0) {
+            int j = node_stack[head];
+            int jnew = pinv[j];
+            if (work_mark[j] != k) {
+                work_mark[j] = k;
+                pos_stack[head] = jnew < 0 ? 0 : Lp[jnew] + 1;
+            }
+            bool done = true;
+            int p_end = jnew < 0 ? 0 : Lp[jnew + 1];
+            for (int pj = pos_stack[head]; pj < p_end; pj++) {
+                int i = Li[pj];
+                if (work_mark[i] == k) {
+                    continue;
+                }
+                pos_stack[head] = pj + 1;
+                node_stack[++head] = i;
+                done = false;
+                break;
+            }
+            if (done) {
+                head--;
+                work_xi[--top] = j;
+            }
+        }
+    }
+    return top;
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::factor(const arma::SpMat<eT>& A) {
+    if (!analyzed) {
+        qDebug() << "SparseLU::factor() matrix is not analyzed.";
+        return false;
+    }
+    if (!loadValues(A)) {
+        qDebug() << "SparseLU::factor() sparsity pattern changed.";
+        return false;
+    }
+    return factorNumeric();
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::factorNumeric() {
+    // 上一次的主元顺序，重新选主元时优先沿用，尽量保持 L, U 的结构不变
+    if (factored) {
+        prow_prev = prow;
+    }
+    factored = false;
+
+    Li.clear();
+    Lx.clear();
+    Ui.clear();
+    Ux.clear();
+    std::fill(pinv.begin(), pinv.end(), -1);
+    std::fill(work_mark.begin(), work_mark.end(), -1);
+    std::fill(work_x.begin(), work_x.end(), 0);
+
+    for (int k = 0; k < n; k++) {
+        int col = q[k];
+        Lp[k] = static_cast<int>(Li.size());
+        Up[k] = static_cast<int>(Ui.size());
+
+        // 稀疏三角求解 x = L \ A(:,col)
+        int top = reach(k, col);
+        for (int p = Ap[col]; p < Ap[col + 1]; p++) {
+            work_x[Ai[p]] += Ax[p];
+        }
+        for (int px = top; px < n; px++) {
+            int j = work_xi[px];
+            int jnew = pinv[j];
+            if (jnew < 0) {
+                continue;
+            }
+            eT xj = work_x[j];
+            for (int p = Lp[jnew] + 1; p < Lp[jnew + 1]; p++) {
+                work_x[Li[p]] -= Lx[p] * xj;
+            }
+        }
+
+        // 选主元
+        int ipiv = -1;
+        double amax = -1;
+        for (int px = top; px < n; px++) {
+            int i = work_xi[px];
+            if (pinv[i] < 0) {
+                double t = std::abs(work_x[i]);
+                if (t > amax) {
+                    amax = t;
+                    ipiv = i;
+                }
+            } else {
+                Ui.push_back(pinv[i]);
+                Ux.push_back(work_x[i]);
+            }
+        }
+        if (ipiv < 0 || amax <= 0 || !std::isfinite(amax)) {
+            // 结构或数值奇异
+            for (int px = top; px < n; px++) {
+                work_x[work_xi[px]] = 0;
+            }
+            return false;
+        }
+        // 阈值主元：满足 |x_i| >= pivot_tol * max|x| 的候选中，
+        // 优先选择上一次的主元行，其次是对角元，最后才是列中最大元
+        int prev = prow_prev[k];
+        if (prev >= 0 && pinv[prev] < 0 && work_mark[prev] == k &&
+            std::abs(work_x[prev]) >= amax * pivot_tol) {
+            ipiv = prev;
+        } else if (pinv[col] < 0 && work_mark[col] == k &&
+                   std::abs(work_x[col]) >= amax * pivot_tol) {
+            ipiv = col;
+        }
+
+        eT pivot = work_x[ipiv];
+        Ui.push_back(k);
+        Ux.push_back(pivot);
+        pinv[ipiv] = k;
+        prow[k] = ipiv;
+        Li.push_back(ipiv);
+        Lx.push_back(1);
+        for (int px = top; px < n; px++) {
+            int i = work_xi[px];
+            if (pinv[i] < 0) {
+                Li.push_back(i);
+                Lx.push_back(work_x[i] / pivot);
+            }
+            work_x[i] = 0;
+        }
+    }
+    Lp[n] = static_cast<int>(Li.size());
+    Up[n] = static_cast<int>(Ui.size());
+
+    // L 的行索引换成主元编号
+    for (int& i : Li) {
+        i = pinv[i];
+    }
+    sortUColumns();
+    buildSolveSchedule();
+
+    factored = true;
+    factor_count++;
+    return true;
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::sortUColumns() {
+    // U 每列按行号升序排列（对角元在最后），refactor 时按此顺序消去
+    std::vector<std::pair<int, eT>> column;
+    for (int k = 0; k < n; k++) {
+        column.clear();
+        for (int p = Up[k]; p < Up[k + 1]; p++) {
+            column.push_back(std::make_pair(Ui[p], Ux[p]));
+        }
+        std::sort(column.begin(), column.end(),
+                  [](const std::pair<int, eT>& a,
+                     const std::pair<int, eT>& b) {
+                      return a.first < b.first;
+                  });
+        for (int p = Up[k]; p < Up[k + 1]; p++) {
+            Ui[p] = column[p - Up[k]].first;
+            Ux[p] = column[p - Up[k]].second;
+        }
+    }
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::refactor(const arma::SpMat<eT>& A) {
+    if (!factored) {
+        return false;
+    }
+    if (!loadValues(A)) {
+        qDebug() << "SparseLU::refactor() sparsity pattern changed.";
+        factored = false;
+        return false;
+    }
+    return refactorNumeric();
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::refactorNumeric() {
+
+    // work_x 按主元编号索引
+    for (int k = 0; k < n; k++) {
+        int col = q[k];
+        for (int p = Ap[col]; p < Ap[col + 1]; p++) {
+            work_x[pinv[Ai[p]]] += Ax[p];
+        }
+
+        // U(:,k)，按行号升序做消去
+        for (int p = Up[k]; p < Up[k + 1] - 1; p++) {
+            int j = Ui[p];
+            eT xj = work_x[j];
+            Ux[p] = xj;
+            work_x[j] = 0;
+            for (int pl = Lp[j] + 1; pl < Lp[j + 1]; pl++) {
+                work_x[Li[pl]] -= Lx[pl] * xj;
+            }
+        }
+
+        eT pivot = work_x[k];
+        work_x[k] = 0;
+        double amax = 0;
+        for (int p = Lp[k] + 1; p < Lp[k + 1]; p++) {
+            amax = std::max<double>(amax, std::abs(work_x[Li[p]]));
+        }
+        if (pivot == eT(0) || !isFiniteValue(pivot) ||
+            std::abs(pivot) < amax * refactor_tol) {
+            // 主元过小，沿用旧的主元顺序不再稳定
+            for (int p = Lp[k] + 1; p < Lp[k + 1]; p++) {
+                work_x[Li[p]] = 0;
+            }
+            factored = false;
+            return false;
+        }
+        Ux[Up[k + 1] - 1] = pivot;
+        for (int p = Lp[k] + 1; p < Lp[k + 1]; p++) {
+            Lx[p] = work_x[Li[p]] / pivot;
+            work_x[Li[p]] = 0;
+        }
+    }
+
+    if (parallel_solve) {
+        loadSolveValues();
+    }
+    refactor_count++;
+    return true;
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::solve(const arma::Col<eT>& b, arma::Col<eT>& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+    // y = P b
+    for (int k = 0; k < n; k++) {
+        work_y[k] = b(prow[k]);
+    }
+    if (parallel_solve) {
+        solveLevels();
+    } else {
+        // L y = y
+        for (int j = 0; j < n; j++) {
+            eT yj = work_y[j];
+            for (int p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+                work_y[Li[p]] -= Lx[p] * yj;
+            }
+        }
+        // U y = y
+        for (int j = n - 1; j >= 0; j--) {
+            work_y[j] /= Ux[Up[j + 1] - 1];
+            eT yj = work_y[j];
+            for (int p = Up[j]; p < Up[j + 1] - 1; p++) {
+                work_y[Ui[p]] -= Ux[p] * yj;
+            }
+        }
+    }
+    // x = Q y
+    x.set_size(n);
+    for (int k = 0; k < n; k++) {
+        x(q[k]) = work_y[k];
+    }
+    for (int k = 0; k < n; k++) {
+        if (!isFiniteValue(x(k))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename eT>
+bool BasicSparseLU<eT>::solveTransposed(const arma::Col<eT>& b,
+                                        arma::Col<eT>& x) const {
+    if (!factored || static_cast<int>(b.n_elem) != n) {
+        return false;
+    }
+    // P A Q = L U，A^T = Q U^T L^T P
+    // y = Q^T b
+    for (int k = 0; k < n; k++) {
+        work_y[k] = b(q[k]);
+    }
+    // U^T y = y，U 的第 j 列即 U^T 的第 j 行
+    for (int j = 0; j < n; j++) {
+        eT yj = work_y[j];
+        for (int p = Up[j]; p < Up[j + 1] - 1; p++) {
+            yj -= Ux[p] * work_y[Ui[p]];
+        }
+        work_y[j] = yj / Ux[Up[j + 1] - 1];
+    }
+    // L^T y = y
+    for (int j = n - 1; j >= 0; j--) {
+        eT yj = work_y[j];
+        for (int p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+            yj -= Lx[p] * work_y[Li[p]];
+        }
+        work_y[j] = yj;
+    }
+    // x = P^T y
+    x.set_size(n);
+    for (int k = 0; k < n; k++) {
+        x(prow[k]) = work_y[k];
+    }
+    for (int k = 0; k < n; k++) {
+        if (!isFiniteValue(x(k))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按行的依赖层：level[i] = 1 + max level[j]，j 为第 i 行的非零列
+static void buildLevels(int n,
+                        const std::vector<int>& row_ptr,
+                        const std::vector<int>& row_col,
+                        bool lower,
+                        std::vector<int>& level_ptr,
+                        std::vector<int>& level_rows) {
+    std::vector<int> level(n, 0);
+    int level_num = 0;
+    for (int k = 0; k < n; k++) {
+        int i = lower ? k : n - 1 - k;
+        int lv = 0;
+        for (int p = row_ptr[i]; p < row_ptr[i + 1]; p++) {
+            lv = std::max(lv, level[row_col[p]] + 1);
+        }
+        level[i] = lv;
+        level_num = std::max(level_num, lv + 1);
+    }
+    level_ptr.assign(level_num + 1, 0);
+    for (int i = 0; i < n; i++) {
+        level_ptr[level[i] + 1]++;
+    }
+    for (int lv = 0; lv < level_num; lv++) {
+        level_ptr[lv + 1] += level_ptr[lv];
+    }
+    level_rows.resize(n);
+    std::vector<int> next(level_ptr.begin(), level_ptr.end() - 1);
+    for (int i = 0; i < n; i++) {
+        level_rows[next[level[i]]++] = i;
+    }
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::buildSolveSchedule() {
+    parallel_solve = false;
+    // 此时 factored 还未置位，getFactorNonzeroNum() 为 0，直接按 L, U 计算
+    int factor_nnz = static_cast<int>(Li.size() + Ui.size()) - n;
+    if (thread_num <= 1 || factor_nnz < parallel_min_size) {
+        return;
+    }
+
+    // L, U 转为按行存储，不含对角元
+    Lr_ptr.assign(n + 1, 0);
+    Ur_ptr.assign(n + 1, 0);
+    for (int j = 0; j < n; j++) {
+        for (int p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+            Lr_ptr[Li[p] + 1]++;
+        }
+        for (int p = Up[j]; p < Up[j + 1] - 1; p++) {
+            Ur_ptr[Ui[p] + 1]++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        Lr_ptr[i + 1] += Lr_ptr[i];
+        Ur_ptr[i + 1] += Ur_ptr[i];
+    }
+    Lr_col.resize(Lr_ptr[n]);
+    Lr_src.resize(Lr_ptr[n]);
+    Ur_col.resize(Ur_ptr[n]);
+    Ur_src.resize(Ur_ptr[n]);
+    std::vector<int> l_next(Lr_ptr.begin(), Lr_ptr.end() - 1);
+    std::vector<int> u_next(Ur_ptr.begin(), Ur_ptr.end() - 1);
+    for (int j = 0; j < n; j++) {
+        for (int p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+            int dest = l_next[Li[p]]++;
+            Lr_col[dest] = j;
+            Lr_src[dest] = p;
+        }
+        for (int p = Up[j]; p < Up[j + 1] - 1; p++) {
+            int dest = u_next[Ui[p]]++;
+            Ur_col[dest] = j;
+            Ur_src[dest] = p;
+        }
+    }
+
+    buildLevels(n, Lr_ptr, Lr_col, true, l_level_ptr, l_level_rows);
+    buildLevels(n, Ur_ptr, Ur_col, false, u_level_ptr, u_level_rows);
+
+    // 每层平均分给每个线程的行数太少时，同步开销超过并行的收益
+    // （例如依赖链很长的电路）；parallel_min_size <= 0 时不判断，总是并行
+    int level_num =
+        static_cast<int>(l_level_ptr.size() + u_level_ptr.size()) - 2;
+    if (parallel_min_size > 0 && 2 * n < 8 * thread_num * level_num) {
+        return;
+    }
+    parallel_solve = true;
+    loadSolveValues();
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::loadSolveValues() {
+    Lr_val.resize(Lr_src.size());
+    for (std::size_t p = 0; p < Lr_src.size(); p++) {
+        Lr_val[p] = Lx[Lr_src[p]];
+    }
+    Ur_val.resize(Ur_src.size());
+    for (std::size_t p = 0; p < Ur_src.size(); p++) {
+        Ur_val[p] = Ux[Ur_src[p]];
+    }
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::solveLevels() const {
+    int threads = thread_num;
+    SpinBarrier barrier(threads);
+
+    // 每层的行平均分给各线程，层与层之间同步
+    auto worker = [&](int t) {
+        int l_level_num = static_cast<int>(l_level_ptr.size()) - 1;
+        for (int lv = 0; lv < l_level_num; lv++) {
+            int begin = l_level_ptr[lv];
+            int size = l_level_ptr[lv + 1] - begin;
+            int lo = begin + static_cast<int>(1LL * size * t / threads);
+            int hi = begin + static_cast<int>(1LL * size * (t + 1) / threads);
+            for (int k = lo; k < hi; k++) {
+                int i = l_level_rows[k];
+                eT sum = work_y[i];
+                for (int p = Lr_ptr[i]; p < Lr_ptr[i + 1]; p++) {
+                    sum -= Lr_val[p] * work_y[Lr_col[p]];
+                }
+                work_y[i] = sum;
+            }
+            barrier.wait();
+        }
+        int u_level_num = static_cast<int>(u_level_ptr.size()) - 1;
+        for (int lv = 0; lv < u_level_num; lv++) {
+            int begin = u_level_ptr[lv];
+            int size = u_level_ptr[lv + 1] - begin;
+            int lo = begin + static_cast<int>(1LL * size * t / threads);
+            int hi = begin + static_cast<int>(1LL * size * (t + 1) / threads);
+            for (int k = lo; k < hi; k++) {
+                int i = u_level_rows[k];
+                eT sum = work_y[i];
+                for (int p = Ur_ptr[i]; p < Ur_ptr[i + 1]; p++) {
+                    sum -= Ur_val[p] * work_y[Ur_col[p]];
+                }
+                work_y[i] = sum / Ux[Up[i + 1] - 1];
+            }
+            barrier.wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+template <typename eT>
+int BasicSparseLU<eT>::getSolveLevelNum() const {
+    if (!parallel_solve) {
+        return 0;
+    }
+    return static_cast<int>(l_level_ptr.size() + u_level_ptr.size()) - 2;
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::setThreadNum(int num) {
+    thread_num = std::max(num, 1);
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::setParallelSolveMinSize(int size) {
+    parallel_min_size = size;
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::setOrdering(int method) {
+    if (method != ordering) {
+        ordering = method;
+        analyzed = false;
+        factored = false;
+    }
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::setPivotTolerance(double tol) {
+    pivot_tol = std::min(1.0, std::max(0.0, tol));
+}
+
+template <typename eT>
+int BasicSparseLU<eT>::getFactorNonzeroNum() const {
+    return factored ? static_cast<int>(Li.size() + Ui.size()) - n : 0;
+}
+
+template <typename eT>
+void BasicSparseLU<eT>::printStats() const {
+    std::cout << "SparseLU: n = " << n << ", nnz(A) = " << Ai.size()
+              << ", nnz(L+U) = " << getFactorNonzeroNum()
+              << ", analyze = " << analyze_count
+              << ", factor = " << factor_count
+              << ", refactor = " << refactor_count;
+    if (parallel_solve) {
+        std::cout << ", solve levels = " << getSolveLevelNum()
+                  << ", threads = " << thread_num;
+    }
+    std::cout << std::endl;
+}
+
+template class BasicSparseLU<double>;
+template class BasicSparseLU<float>;
+template class BasicSparseLU<std::complex<double>>;
@@ -0,0 +1,112 @@
+#include "StampMap.h"
+#include <QDebug>
+#include <algorithm>
+
+StampMap::StampMap()
+    : compiled(false), size(0), base_version(0), values(nullptr) {}
+
+StampMap::~StampMap() {}
+
+void StampMap::clear() {
+    compiled = false;
+    size = 0;
+    entries.clear();
+    col_ptr.clear();
+    row_idx.clear();
+    base.clear();
+    matrix.reset();
+    values = nullptr;
+}
+
+void StampMap::addEntry(int row, int col) {
+    if (row < 0 || col < 0) {
+        return;  // 地节点，直接丢弃
+    }
+    entries.push_back(std::make_pair(col, row));
+    compiled = false;
+}
+
+void StampMap::addPattern(const arma::sp_mat& MNA) {
+    for (arma::sp_mat::const_iterator it = MNA.begin(); it != MNA.end();
+         ++it) {
+        addEntry(static_cast<int>(it.row()), static_cast<int>(it.col()));
+    }
+}
+
+void StampMap::compile(int size_) {
+    size = size_;
+
+    // 排序去重，得到按列排列的 CSC 结构
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    col_ptr.assign(size + 1, 0);
+    row_idx.clear();
+    row_idx.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (entry.first >= size || entry.second >= size) {
+            qDebug() << "StampMap::compile() entry out of range:"
+                     << entry.second << entry.first;
+            continue;
+        }
+        col_ptr[entry.first + 1]++;
+        row_idx.push_back(entry.second);
+    }
+    for (int col = 0; col < size; col++) {
+        col_ptr[col + 1] += col_ptr[col];
+    }
+
+    int nnz = static_cast<int>(row_idx.size());
+    base.assign(nnz, 0);
+    base_version++;
+
+    // 使用 batch 构造函数，保留显式的零元，保证结构固定
+    arma::uvec rowind(nnz);
+    arma::uvec colptr(size + 1);
+    for (int k = 0; k < nnz; k++) {
+        rowind(k) = row_idx[k];
+    }
+    for (int col = 0; col <= size; col++) {
+        colptr(col) = col_ptr[col];
+    }
+    matrix = arma::sp_mat(rowind, colptr, arma::zeros<arma::vec>(nnz), size,
+                          size, false);
+    values = arma::access::rwp(matrix.values);
+
+    compiled = true;
+}
+
+int StampMap::getSlot(int row, int col) const {
+    if (!compiled || row < 0 || col < 0 || row >= size || col >= size) {
+        return -1;
+    }
+    auto first = row_idx.begin() + col_ptr[col];
+    auto last = row_idx.begin() + col_ptr[col + 1];
+    auto it = std::lower_bound(first, last, row);
+    if (it == last || *it != row) {
+        return -1;
+    }
+    return static_cast<int>(it - row_idx.begin());
+}
+
+bool StampMap::loadBase(const arma::sp_mat& MNA) {
+    base_next.assign(base.size(), 0);
+    for (arma::sp_mat::const_iterator it = MNA.begin(); it != MNA.end();
+         ++it) {
+        int slot = getSlot(static_cast<int>(it.row()),
+                           static_cast<int>(it.col()));
+        if (slot < 0) {
+            return false;  // 结构外的非零元，需要重新编译
+        }
+        base_next[slot] = (*it);
+    }
+    if (base_next != base) {
+        base.swap(base_next);
+        base_version++;
+    }
+    return true;
+}
+
+void StampMap::resetValues() {
+    std::copy(base.begin(), base.end(), values);
+}